@@ -103,8 +103,10 @@ HEADERS += \
     $$PWD/backend/pad_decoder.h \
     $$PWD/backend/eep-protection.h \
     $$PWD/backend/energy_dispersal.h \
+    $$PWD/backend/ensemble-cache.h \
     $$PWD/backend/fib-processor.h \
     $$PWD/backend/fic-handler.h \
+    $$PWD/backend/iq-capture.h \
     $$PWD/backend/msc-handler.h \
     $$PWD/backend/freq-interleaver.h \
     $$PWD/backend/ofdm-decoder.h \
@@ -116,6 +118,11 @@ HEADERS += \
     $$PWD/backend/protection.h \
     $$PWD/backend/radio-controller.h \
     $$PWD/backend/radio-receiver.h \
+    $$PWD/backend/signal-presence.h \
+    $$PWD/backend/spectrum-snapshot.h \
+    $$PWD/backend/spectrum-engine.h \
+    $$PWD/backend/cir-analyser.h \
+    $$PWD/backend/fractional-resampler.h \
     $$PWD/backend/tools.h \
     $$PWD/backend/uep-protection.h \
     $$PWD/backend/viterbi.h \\
@@ -140,7 +147,11 @@ HEADERS += \
     $$PWD/libs/fec/init_rs.h \
     $$PWD/libs/fec/rs-common.h \
     $$PWD/backend/decoder_adapter.h \
+    $$PWD/input/channeliser.h \
+    $$PWD/input/halfband_decimator.h \
     $$PWD/input/input_factory.h \
+    $$PWD/input/iq_container.h \
+    $$PWD/input/iq_recorder.h \
     $$PWD/input/null_device.h \
     $$PWD/input/raw_file.h \
     $$PWD/input/virtual_input.h \
@@ -155,8 +166,10 @@ SOURCES += \
     $$PWD/backend/mot_manager.cpp \
     $$PWD/backend/pad_decoder.cpp \
     $$PWD/backend/eep-protection.cpp \
+    $$PWD/backend/ensemble-cache.cpp \
     $$PWD/backend/fib-processor.cpp \
     $$PWD/backend/fic-handler.cpp \
+    $$PWD/backend/iq-capture.cpp \
     $$PWD/backend/msc-handler.cpp \
     $$PWD/backend/freq-interleaver.cpp \
     $$PWD/backend/ofdm-decoder.cpp \
@@ -166,6 +179,11 @@ SOURCES += \
     $$PWD/backend/tii-decoder.cpp \
     $$PWD/backend/protTables.cpp \
     $$PWD/backend/radio-receiver.cpp \
+    $$PWD/backend/signal-presence.cpp \
+    $$PWD/backend/spectrum-snapshot.cpp \
+    $$PWD/backend/spectrum-engine.cpp \
+    $$PWD/backend/cir-analyser.cpp \
+    $$PWD/backend/fractional-resampler.cpp \
     $$PWD/backend/tools.cpp \
     $$PWD/backend/uep-protection.cpp \
     $$PWD/backend/viterbi.cpp \
@@ -178,7 +196,11 @@ SOURCES += \
     $$PWD/libs/fec/decode_rs_char.c \
     $$PWD/libs/fec/init_rs_char.c \
     $$PWD/backend/decoder_adapter.cpp \
+    $$PWD/input/channeliser.cpp \
+    $$PWD/input/halfband_decimator.cpp \
     $$PWD/input/input_factory.cpp \
+    $$PWD/input/iq_container.cpp \
+    $$PWD/input/iq_recorder.cpp \
     $$PWD/input/null_device.cpp \
     $$PWD/input/raw_file.cpp \
     $$PWD/input/rtl_tcp.cpp
@@ -0,0 +1,334 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include "cir-analyser.h"
+
+using namespace std;
+
+// A peak must exceed the mean of the impulse response by this factor,
+// like in PhaseReference::findIndex(), and be at most 30 dB below the
+// strongest peak.
+static const float PEAK_OVER_MEAN = 3.0f;
+static const float MIN_RELATIVE_AMPLITUDE = 0.0316f;
+
+static const size_t MAX_PEAKS = 8;
+static const float MIN_PEAK_DISTANCE = 3.0f;
+
+// Largest common shift of all paths per frame between two updates
+static const float MAX_COMMON_SHIFT = 10.0f;
+
+// A peak belongs to a track when it is closer than this to its prediction
+static const float TRACK_GATE = 2.5f;
+
+// A track is reported once it was followed for this many frames, and
+// removed after this many consecutive frames without a peak. The frames
+// since the previous update count like the updated one.
+static const int CONFIRM_HITS = 5;
+static const int MAX_MISSES = 25;
+
+// When the updates are several frames apart, two noise peaks close to
+// each other would already confirm a track
+static const int CONFIRM_DETECTIONS = 3;
+
+// Kalman filter noise variances: measurement of the position, and the
+// change of position and drift per frame.
+static const float MEASUREMENT_VARIANCE = 0.05f;
+static const float POSITION_NOISE = 0.01f;
+static const float DRIFT_NOISE = 1e-4f;
+
+// Weight of a new measurement in the average of the level, for
+// consecutive frames
+static const float LEVEL_AVERAGING = 0.2f;
+
+// A TII measurement is associated to the track closest to its delay,
+// if it is closer than this
+static const float TII_TOLERANCE = 2.5f;
+
+static const size_t HISTORY_LENGTH = 100;
+
+float transmitter_track_t::getDelayKm(void) const
+{
+    constexpr float km_per_sample = 3e8f / 1000.0f / 2048000.0f;
+    return delay_samples * km_per_sample;
+}
+
+bool CIRAnalyser::track_t::confirmed() const
+{
+    return hits >= CONFIRM_HITS and detections >= CONFIRM_DETECTIONS;
+}
+
+CIRAnalyser::CIRAnalyser(const DABParams& params) :
+    T_u(params.T_u)
+{
+}
+
+// Bring a position or a difference of positions into [-T_u/2, T_u/2[
+static float wrap(float position, int T_u)
+{
+    while (position >= T_u / 2) {
+        position -= T_u;
+    }
+    while (position < -T_u / 2) {
+        position += T_u;
+    }
+    return position;
+}
+
+vector<CIRAnalyser::peak_t> CIRAnalyser::findPeaks(const vector<float>& cir) const
+{
+    const int n = cir.size();
+    if (n < 3) {
+        return {};
+    }
+
+    const float mean = accumulate(cir.begin(), cir.end(), 0.0f) / n;
+    const float max = *max_element(cir.begin(), cir.end());
+    const float threshold = std::max(PEAK_OVER_MEAN * mean, MIN_RELATIVE_AMPLITUDE * max);
+
+    vector<int> candidates;
+    for (int i = 0; i < n; i++) {
+        const float prev = cir[(i + n - 1) % n];
+        const float next = cir[(i + 1) % n];
+        if (cir[i] > threshold and cir[i] > prev and cir[i] >= next) {
+            candidates.push_back(i);
+        }
+    }
+
+    sort(candidates.begin(), candidates.end(),
+            [&](int lhs, int rhs) { return cir[lhs] > cir[rhs]; });
+
+    vector<peak_t> peaks;
+    for (const int i : candidates) {
+        if (peaks.size() == MAX_PEAKS) {
+            break;
+        }
+
+        // Fit a parabola through the maximum and its neighbours
+        const float a = cir[(i + n - 1) % n];
+        const float b = cir[i];
+        const float c = cir[(i + 1) % n];
+        const float denominator = a - 2 * b + c;
+        const float delta = denominator < 0 ? 0.5f * (a - c) / denominator : 0;
+
+        peak_t peak;
+        peak.position = wrap(i + delta, T_u);
+        peak.amplitude = b - 0.25f * (a - c) * delta;
+
+        const bool too_close = any_of(peaks.begin(), peaks.end(),
+                [&](const peak_t& p) {
+                    return fabs(wrap(p.position - peak.position, T_u)) < MIN_PEAK_DISTANCE;
+                });
+
+        if (not too_close) {
+            peaks.push_back(peak);
+        }
+    }
+
+    return peaks;
+}
+
+const CIRAnalyser::track_t *CIRAnalyser::strongestTrack() const
+{
+    const track_t *strongest = nullptr;
+    for (const auto& t : tracks) {
+        if (t.confirmed() and
+                (strongest == nullptr or t.info.level_dB > strongest->info.level_dB)) {
+            strongest = &t;
+        }
+    }
+    return strongest;
+}
+
+void CIRAnalyser::process(const vector<float>& impulseResponse, int frames)
+{
+    const auto peaks = findPeaks(impulseResponse);
+    const auto now = chrono::system_clock::now();
+    const int n = std::max(frames, 1);
+    const float level_averaging = 1 - pow(1 - LEVEL_AVERAGING, n);
+
+    lock_guard<std::mutex> lock(mutex);
+
+    // Kalman prediction over n frames
+    for (auto& t : tracks) {
+        t.x[0] = wrap(t.x[0] + n * t.x[1], T_u);
+        t.P[0][0] += 2 * n * t.P[0][1] + n * n * t.P[1][1] + n * POSITION_NOISE;
+        t.P[0][1] += n * t.P[1][1];
+        t.P[1][0] = t.P[0][1];
+        t.P[1][1] += n * DRIFT_NOISE;
+        t.updated = false;
+    }
+
+    // Remove the common shift, using the peak that is closest to the
+    // strongest track
+    const track_t *reference = strongestTrack();
+    if (reference) {
+        const float max_shift = std::min(n * MAX_COMMON_SHIFT, T_u / 4.0f);
+        float shift = max_shift;
+        for (const auto& p : peaks) {
+            const float d = wrap(p.position - reference->x[0], T_u);
+            if (fabs(d) < fabs(shift)) {
+                shift = d;
+            }
+        }
+
+        if (fabs(shift) < max_shift) {
+            for (auto& t : tracks) {
+                t.x[0] = wrap(t.x[0] + shift, T_u);
+            }
+        }
+    }
+
+    // The peaks are sorted by amplitude, the strongest ones pick their
+    // track first.
+    for (const auto& p : peaks) {
+        track_t *best = nullptr;
+        float best_distance = TRACK_GATE;
+        for (auto& t : tracks) {
+            const float d = fabs(wrap(p.position - t.x[0], T_u));
+            if (not t.updated and d < best_distance) {
+                best = &t;
+                best_distance = d;
+            }
+        }
+
+        const float level_dB = 20.0f * log10(p.amplitude);
+
+        if (best) {
+            auto& t = *best;
+            // Kalman update
+            const float y = wrap(p.position - t.x[0], T_u);
+            const float S = t.P[0][0] + MEASUREMENT_VARIANCE;
+            const float K0 = t.P[0][0] / S;
+            const float K1 = t.P[0][1] / S;
+            t.x[0] = wrap(t.x[0] + K0 * y, T_u);
+            t.x[1] += K1 * y;
+            const float P00 = t.P[0][0];
+            const float P01 = t.P[0][1];
+            t.P[0][0] = (1 - K0) * P00;
+            t.P[0][1] = (1 - K0) * P01;
+            t.P[1][0] = t.P[0][1];
+            t.P[1][1] -= K1 * P01;
+
+            t.info.level_dB += level_averaging * (level_dB - t.info.level_dB);
+            t.hits += n;
+            t.detections++;
+            t.misses = 0;
+            t.updated = true;
+        }
+        else {
+            track_t t;
+            t.info.id = nextId++;
+            t.info.level_dB = level_dB;
+            t.x[0] = p.position;
+            t.P[0][0] = MEASUREMENT_VARIANCE;
+            t.P[1][1] = 0.1f;
+            t.hits = 1;
+            t.detections = 1;
+            t.updated = true;
+            tracks.push_back(move(t));
+        }
+    }
+
+    tracks.remove_if([&](track_t& t) {
+            if (not t.updated) {
+                t.misses += n;
+            }
+            return t.misses > MAX_MISSES;
+        });
+
+    reference = strongestTrack();
+    if (reference == nullptr) {
+        return;
+    }
+
+    for (auto& t : tracks) {
+        if (t.updated and t.confirmed()) {
+            t.info.delay_samples = wrap(t.x[0] - reference->x[0], T_u);
+
+            transmitter_sample_t s;
+            s.time = now;
+            s.delay_samples = t.info.delay_samples;
+            s.level_dB = t.info.level_dB;
+
+            if (t.info.history.size() == HISTORY_LENGTH) {
+                t.info.history.erase(t.info.history.begin());
+            }
+            t.info.history.push_back(s);
+        }
+    }
+}
+
+void CIRAnalyser::associate(const tii_measurement_t& m)
+{
+    lock_guard<std::mutex> lock(mutex);
+
+    const track_t *reference = strongestTrack();
+    if (reference == nullptr) {
+        return;
+    }
+
+    track_t *best = nullptr;
+    float best_distance = TII_TOLERANCE;
+    for (auto& t : tracks) {
+        if (not t.confirmed()) {
+            continue;
+        }
+
+        const float delay = wrap(t.x[0] - reference->x[0], T_u);
+        const float d = fabs(delay - m.delay_samples);
+        if (d <= best_distance) {
+            best = &t;
+            best_distance = d;
+        }
+    }
+
+    if (best) {
+        for (auto& t : tracks) {
+            if (t.info.comb == m.comb and t.info.pattern == m.pattern) {
+                t.info.comb = -1;
+                t.info.pattern = -1;
+            }
+        }
+
+        best->info.comb = m.comb;
+        best->info.pattern = m.pattern;
+    }
+}
+
+vector<transmitter_track_t> CIRAnalyser::getTracks() const
+{
+    lock_guard<std::mutex> lock(mutex);
+
+    vector<transmitter_track_t> result;
+    for (const auto& t : tracks) {
+        if (t.confirmed()) {
+            result.push_back(t.info);
+        }
+    }
+    return result;
+}
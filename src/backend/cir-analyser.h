@@ -0,0 +1,132 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef CIR_ANALYSER_H
+#define CIR_ANALYSER_H
+
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <vector>
+#include "dab-constants.h"
+#include "radio-controller.h"
+
+struct transmitter_sample_t {
+    std::chrono::system_clock::time_point time;
+    float delay_samples = 0;
+    float level_dB = 0;
+};
+
+/* A path of the channel impulse response followed over time. In an SFN,
+ * every transmitter that reaches the receiver gives one path. */
+struct transmitter_track_t {
+    int id = 0;
+
+    // The TII code associated to the path, -1 until one was found
+    int comb = -1;
+    int pattern = -1;
+
+    // Filtered delay relative to the strongest path, with sub-sample
+    // resolution, and filtered level of the path.
+    float delay_samples = 0;
+    float level_dB = 0;
+
+    // The latest estimates, oldest first
+    std::vector<transmitter_sample_t> history;
+
+    float getDelayKm(void) const;
+};
+
+/* Finds the paths in the channel impulse response computed by
+ * PhaseReference::findIndex(), and tracks them over the frames.
+ *
+ * The impulse response is only computed every few frames while the
+ * receiver tracks the timing, so every update says how many frames passed
+ * since the previous one, and the filters and counters below are in
+ * frames, not in updates.
+ *
+ * The peaks are located with sub-sample resolution by fitting a parabola
+ * through the three samples around each local maximum. Every path has a
+ * Kalman filter on its position and drift, so that a path that fades for
+ * a few frames keeps its identity. The timing loop of the receiver moves
+ * the FFT window between two updates, which moves all paths together.
+ * This common shift is taken from the strongest peak and removed before
+ * the peaks are matched to the tracks.
+ *
+ * The TII decoder measures the delay of a transmitter relative to the
+ * strongest path, its measurements are associated to the track at that
+ * delay. */
+class CIRAnalyser {
+    public:
+        CIRAnalyser(const DABParams& params);
+        CIRAnalyser(const CIRAnalyser&) = delete;
+        CIRAnalyser& operator=(const CIRAnalyser&) = delete;
+
+        // Only to be called from the receiver thread, with the magnitude
+        // of the impulse response and the number of frames since the
+        // previous impulse response.
+        void process(const std::vector<float>& impulseResponse, int frames);
+
+        // Can be called from any thread
+        void associate(const tii_measurement_t& m);
+
+        // Can be called from any thread. Returns the tracks that were
+        // confirmed by several frames.
+        std::vector<transmitter_track_t> getTracks(void) const;
+
+    private:
+        struct peak_t {
+            float position = 0;
+            float amplitude = 0;
+        };
+
+        struct track_t {
+            transmitter_track_t info;
+
+            // Kalman filter state: position in samples and drift per
+            // frame, and its covariance
+            float x[2] = {0, 0};
+            float P[2][2] = {{0, 0}, {0, 0}};
+
+            // Frames the track was followed, and peaks that it got
+            int hits = 0;
+            int detections = 0;
+            int misses = 0;
+            bool updated = false;
+
+            bool confirmed(void) const;
+        };
+
+        std::vector<peak_t> findPeaks(const std::vector<float>& cir) const;
+        const track_t *strongestTrack(void) const;
+
+        const int T_u;
+
+        mutable std::mutex mutex;
+        std::list<track_t> tracks;
+        int nextId = 0;
+};
+
+#endif
@@ -36,6 +36,7 @@
 #include "ringbuffer.h"
 #include "energy_dispersal.h"
 #include "radio-controller.h"
+#include "iq-capture.h"
 
 class DabProcessor;
 class Protection;
@@ -48,7 +49,8 @@ class DabAudio : public DabVirtual
                   int16_t bitRate,
                   ProtectionSettings protection,
                   ProgrammeHandlerInterface& phi,
-                  const std::string& dumpFileName);
+                  const std::string& dumpFileName,
+                  IQCapture& iqCapture);
         virtual ~DabAudio(void);
         DabAudio(const DabAudio&) = delete;
         DabAudio& operator=(const DabAudio&) = delete;
@@ -27,9 +27,10 @@
 #include <vector>
 #include "decoder_adapter.h"
 
-DecoderAdapter::DecoderAdapter(ProgrammeHandlerInterface &mr, int16_t bitRate, AudioServiceComponentType &dabModus, const std::string &dumpFileName):
+DecoderAdapter::DecoderAdapter(ProgrammeHandlerInterface &mr, int16_t bitRate, AudioServiceComponentType &dabModus, const std::string &dumpFileName, IQCapture &iqCapture):
     bitRate(bitRate),
     myInterface(mr),
+    iqCapture(iqCapture),
     padDecoder(this, true)
 {
     if (dabModus == AudioServiceComponentType::DAB)
@@ -138,6 +139,9 @@ void DecoderAdapter::ACCFrameError(const unsigned char error)
 void DecoderAdapter::FECInfo(int total_corr_count, bool uncorr_errors)
 {
     myInterface.onRsErrors(uncorr_errors, total_corr_count);
+    if (uncorr_errors) {
+        iqCapture.trigger(IQCaptureEvent::RSUncorrectable);
+    }
 }
 
 void DecoderAdapter::PADChangeDynamicLabel(const DL_STATE &dl)
@@ -34,6 +34,7 @@
 #include "dab-processor.h"
 #include "pad_decoder.h"
 #include "radio-controller.h"
+#include "iq-capture.h"
 #include "subchannel_sink.h"
 #include "dab_decoder.h"
 #include "dabplus_decoder.h"
@@ -44,7 +45,8 @@ class DecoderAdapter: public DabProcessor, public SubchannelSinkObserver, public
         DecoderAdapter(ProgrammeHandlerInterface& mr,
                      int16_t bitRate,
                      AudioServiceComponentType &dabModus,
-                     const std::string& dumpFileName);
+                     const std::string& dumpFileName,
+                     IQCapture& iqCapture);
 
         virtual void addtoFrame(uint8_t *v);
 
@@ -66,6 +68,7 @@ class DecoderAdapter: public DabProcessor, public SubchannelSinkObserver, public
         int16_t bitRate;
         int frameErrorCounter = 0;
         ProgrammeHandlerInterface& myInterface;
+        IQCapture& iqCapture;
         std::unique_ptr<SubchannelSink> decoder;
         PADDecoder padDecoder;
 
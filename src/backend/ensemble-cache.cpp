@@ -0,0 +1,310 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include "ensemble-cache.h"
+
+using namespace std;
+
+/* File format, all integers little-endian:
+ *   magic "WEC1"
+ *   ensemble: u16 EId, u8 ECC, label
+ *   u8 count, subchannels
+ *   u8 count, services
+ *   u16 count, components
+ * A label is the FIG 1 label and the FIG 2 segments as received.
+ * Strings are prefixed by their length on one byte. */
+static const char *magic = "WEC1";
+
+namespace {
+
+class Writer {
+    public:
+        void u8(uint8_t v) { buf.push_back(v); }
+        void u16(uint16_t v) { u8(v & 0xFF); u8(v >> 8); }
+        void u32(uint32_t v) { u16(v & 0xFFFF); u16(v >> 16); }
+        void bytes(const uint8_t *data, size_t len)
+        {
+            len = min<size_t>(len, 255);
+            u8(len);
+            buf.insert(buf.end(), data, data + len);
+        }
+        void str(const string& s) { bytes((const uint8_t*)s.data(), s.size()); }
+
+        void label(const DabLabel& l)
+        {
+            u8((uint8_t)l.charset);
+            str(l.fig1_label);
+            u16(l.fig1_flag);
+            u8((uint8_t)l.extended_label_charset);
+            u8(l.toggle_flag);
+            u8(l.fig2_rfu);
+            u8(l.segment_count);
+            u8(l.segments.size());
+            for (const auto& s : l.segments) {
+                u8(s.first);
+                bytes(s.second.data(), s.second.size());
+            }
+        }
+
+        vector<uint8_t> buf;
+};
+
+class Reader {
+    public:
+        Reader(const vector<uint8_t>& buf) : buf(buf) {}
+
+        uint8_t u8()
+        {
+            if (pos >= buf.size()) {
+                ok = false;
+                return 0;
+            }
+            return buf[pos++];
+        }
+        uint16_t u16() { const uint16_t lo = u8(); return lo | (u8() << 8); }
+        uint32_t u32() { const uint32_t lo = u16(); return lo | ((uint32_t)u16() << 16); }
+        vector<uint8_t> bytes()
+        {
+            const size_t len = u8();
+            if (pos + len > buf.size()) {
+                ok = false;
+                return {};
+            }
+            vector<uint8_t> b(buf.begin() + pos, buf.begin() + pos + len);
+            pos += len;
+            return b;
+        }
+        string str() { const auto b = bytes(); return string(b.begin(), b.end()); }
+
+        DabLabel label()
+        {
+            DabLabel l;
+            l.setCharset(u8());
+            l.fig1_label = str();
+            l.fig1_flag = u16();
+            l.extended_label_charset = static_cast<CharacterSet>(u8());
+            l.toggle_flag = u8();
+            l.fig2_rfu = u8();
+            l.segment_count = u8();
+            const size_t numSegments = u8();
+            for (size_t i = 0; i < numSegments and ok; i++) {
+                const int index = u8();
+                l.segments[index] = bytes();
+            }
+            return l;
+        }
+
+        bool ok = true;
+
+    private:
+        const vector<uint8_t>& buf;
+        size_t pos = 0;
+};
+
+}
+
+EnsembleCache::EnsembleCache(const string& directory) :
+    directory(directory)
+{
+}
+
+string EnsembleCache::fileName(int frequency) const
+{
+    return directory + "/ensemble-" + to_string(frequency) + ".bin";
+}
+
+bool EnsembleCache::save(int frequency, const EnsembleConfig& config) const
+{
+    Writer w;
+    w.buf.insert(w.buf.end(), magic, magic + 4);
+
+    w.u16(config.ensembleId);
+    w.u8(config.ensembleEcc);
+    w.label(config.ensembleLabel);
+
+    w.u8(config.subChannels.size());
+    for (const auto& sub : config.subChannels) {
+        w.u8(sub.subChId);
+        w.u16(sub.startAddr);
+        w.u16(sub.length);
+        w.u8(sub.programmeNotData);
+        const auto& ps = sub.protectionSettings;
+        w.u8(ps.shortForm);
+        w.u8(ps.uepTableIndex);
+        w.u8(ps.uepLevel);
+        w.u8((uint8_t)ps.eepProfile);
+        w.u8((uint8_t)ps.eepLevel);
+        w.u16(sub.language);
+        w.u8(sub.fecScheme);
+    }
+
+    w.u8(config.services.size());
+    for (const auto& s : config.services) {
+        w.u32(s.serviceId);
+        w.label(s.serviceLabel);
+        w.u16(s.language);
+        w.u16(s.programType);
+    }
+
+    w.u16(config.components.size());
+    for (const auto& c : config.components) {
+        w.u8(c.TMid);
+        w.u32(c.SId);
+        w.u16(c.componentNr);
+        w.label(c.componentLabel);
+        w.u16(c.ASCTy);
+        w.u16(c.PS_flag);
+        w.u16(c.subchannelId);
+        w.u16(c.SCId);
+        w.u8(c.CAflag);
+        w.u16(c.DSCTy);
+        w.u8(c.DGflag);
+        w.u16(c.packetAddress);
+    }
+
+    // Write to a temporary file first, so that a crash never leaves
+    // a truncated cache behind.
+    const string name = fileName(frequency);
+    const string tmpName = name + ".tmp";
+
+    FILE *fd = fopen(tmpName.c_str(), "wb");
+    if (fd == nullptr) {
+        clog << "EnsembleCache: cannot write " << tmpName << endl;
+        return false;
+    }
+    const bool written = fwrite(w.buf.data(), w.buf.size(), 1, fd) == 1;
+    const bool closed = fclose(fd) == 0;
+
+    if (not written or not closed) {
+        clog << "EnsembleCache: error writing " << tmpName << endl;
+        remove(tmpName.c_str());
+        return false;
+    }
+
+    if (rename(tmpName.c_str(), name.c_str()) != 0) {
+        // Windows does not replace existing files
+        remove(name.c_str());
+        if (rename(tmpName.c_str(), name.c_str()) != 0) {
+            clog << "EnsembleCache: cannot replace " << name << endl;
+            remove(tmpName.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EnsembleCache::load(int frequency, EnsembleConfig& config) const
+{
+    FILE *fd = fopen(fileName(frequency).c_str(), "rb");
+    if (fd == nullptr) {
+        return false;
+    }
+
+    vector<uint8_t> buf;
+    uint8_t block[4096];
+    size_t n;
+    while ((n = fread(block, 1, sizeof(block), fd)) > 0) {
+        buf.insert(buf.end(), block, block + n);
+    }
+    fclose(fd);
+
+    if (buf.size() < 4 or not equal(magic, magic + 4, buf.begin())) {
+        clog << "EnsembleCache: " << fileName(frequency) << " has an unknown format" << endl;
+        return false;
+    }
+    buf.erase(buf.begin(), buf.begin() + 4);
+
+    Reader r(buf);
+    EnsembleConfig c;
+
+    c.ensembleId = r.u16();
+    c.ensembleEcc = r.u8();
+    c.ensembleLabel = r.label();
+
+    const size_t numSubchannels = r.u8();
+    for (size_t i = 0; i < numSubchannels and r.ok; i++) {
+        Subchannel sub;
+        sub.subChId = r.u8();
+        sub.startAddr = r.u16();
+        sub.length = r.u16();
+        sub.programmeNotData = r.u8();
+        auto& ps = sub.protectionSettings;
+        ps.shortForm = r.u8();
+        ps.uepTableIndex = r.u8();
+        ps.uepLevel = r.u8();
+        ps.eepProfile = static_cast<EEPProtectionProfile>(r.u8());
+        ps.eepLevel = static_cast<EEPProtectionLevel>(r.u8());
+        sub.language = r.u16();
+        sub.fecScheme = r.u8();
+
+        // Same limits as the FIG 0/1 fields
+        if (sub.subChId >= 64 or ps.uepTableIndex >= 64) {
+            r.ok = false;
+        }
+        c.subChannels.push_back(sub);
+    }
+
+    const size_t numServices = r.u8();
+    for (size_t i = 0; i < numServices and r.ok; i++) {
+        Service s(r.u32());
+        s.serviceLabel = r.label();
+        s.language = r.u16();
+        s.programType = r.u16();
+        c.services.push_back(s);
+    }
+
+    const size_t numComponents = r.u16();
+    for (size_t i = 0; i < numComponents and r.ok; i++) {
+        ServiceComponent sc;
+        sc.TMid = r.u8();
+        sc.SId = r.u32();
+        sc.componentNr = r.u16();
+        sc.componentLabel = r.label();
+        sc.ASCTy = r.u16();
+        sc.PS_flag = r.u16();
+        sc.subchannelId = r.u16();
+        sc.SCId = r.u16();
+        sc.CAflag = r.u8();
+        sc.DSCTy = r.u16();
+        sc.DGflag = r.u8();
+        sc.packetAddress = r.u16();
+
+        if (sc.subchannelId < 0 or sc.subchannelId >= 64) {
+            r.ok = false;
+        }
+        c.components.push_back(sc);
+    }
+
+    if (not r.ok) {
+        clog << "EnsembleCache: " << fileName(frequency) << " is truncated" << endl;
+        return false;
+    }
+
+    config = move(c);
+    return true;
+}
@@ -0,0 +1,61 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef ENSEMBLE_CACHE_H
+#define ENSEMBLE_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "dab-constants.h"
+
+/* The part of the FIC database needed to decode services */
+struct EnsembleConfig {
+    uint16_t ensembleId = 0;
+    uint8_t ensembleEcc = 0;
+    DabLabel ensembleLabel;
+    std::vector<Service> services;
+    std::vector<ServiceComponent> components;
+    std::vector<Subchannel> subChannels; // Only the valid ones
+};
+
+/* Keeps the last known ensemble configuration of every frequency in a
+ * small binary file, so that services can be started right after a
+ * retune instead of waiting for the FIC to be received again. */
+class EnsembleCache {
+    public:
+        // The directory has to exist
+        EnsembleCache(const std::string& directory);
+
+        bool load(int frequency, EnsembleConfig& config) const;
+        bool save(int frequency, const EnsembleConfig& config) const;
+
+    private:
+        std::string fileName(int frequency) const;
+
+        std::string directory;
+};
+
+#endif
@@ -32,6 +32,13 @@
 #include "charsets.h"
 #include "MathHelper.h"
 
+// Cached services disappear after a few seconds of FIC that does not
+// contain them, see HandleFIG0Extension2
+static constexpr uint8_t CACHED_SERVICE_REPEAT_COUNT = 3;
+
+// FIG 0/2 for all services is repeated well within this time
+static constexpr auto ENSEMBLE_COMPLETE_TIME = std::chrono::seconds(10);
+
 FIBProcessor::FIBProcessor(RadioControllerInterface& mr) :
     myRadioInterface(mr)
 {
@@ -48,6 +55,11 @@ void FIBProcessor::processFIB(uint8_t *p, uint16_t fib)
 
     std::lock_guard<std::mutex> lock(mutex);
 
+    if (not fibReceived) {
+        fibReceived = true;
+        timeFirstFIB = std::chrono::steady_clock::now();
+    }
+
     (void)fib;
     while (processedBytes  < 30) {
         const uint8_t FIGtype = getBits_3 (d, 0);
@@ -65,7 +77,9 @@ void FIBProcessor::processFIB(uint8_t *p, uint16_t fib)
                 break;
 
             case 7:
-                return;
+                // End marker, the rest of the FIB is padding
+                processedBytes = 30;
+                continue;
 
             default:
                 //std::clog << "FIG%d present" << FIGtype << std::endl;
@@ -76,6 +90,12 @@ void FIBProcessor::processFIB(uint8_t *p, uint16_t fib)
         processedBytes += getBits_5 (d, 3) + 1;
         d = p + processedBytes * 8;
     }
+
+    if (cacheOutdated) {
+        cacheOutdated = false;
+        std::clog << "fib-processor: cached ensemble configuration is outdated" << std::endl;
+        myRadioInterface.onRestartService();
+    }
 }
 //
 //  Handle ensemble is all through FIG0
@@ -122,6 +142,12 @@ void FIBProcessor::FIG0Extension0 (uint8_t *d)
     uint16_t eId  = getBits(d, 16, 16);
 
     if (ensembleId != eId) {
+        if (loadedFromCache) {
+            // The cache was for another ensemble
+            resetDatabase();
+            ensembleLabel = DabLabel();
+            cacheOutdated = true;
+        }
         ensembleId = eId;
         myRadioInterface.onNewEnsemble(ensembleId);
     }
@@ -180,6 +206,7 @@ int16_t FIBProcessor::HandleFIG0Extension1(
     int16_t bitOffset = offset * 8;
     const int16_t subChId   = getBits_6 (d, bitOffset);
     const int16_t startAdr  = getBits(d, bitOffset + 6, 10);
+    const Subchannel before = subChannels[subChId];
     subChannels[subChId].programmeNotData = pd;
     subChannels[subChId].subChId = subChId;
     subChannels[subChId].startAddr = startAdr;
@@ -238,6 +265,14 @@ int16_t FIBProcessor::HandleFIG0Extension1(
         bitOffset += 32;
     }
 
+    const auto& after = subChannels[subChId];
+    if (loadedFromCache and before.valid() and (
+                before.startAddr != after.startAddr or
+                before.length != after.length or
+                before.protection() != after.protection())) {
+        cacheOutdated = true;
+    }
+
     return bitOffset / 8;   // we return bytes
 }
 
@@ -298,7 +333,7 @@ int16_t FIBProcessor::HandleFIG0Extension2(
                 ++it;
             }
             else if (it->second == 0) {
-                dropService(it->second);
+                dropService(it->first);
                 it = serviceRepeatCount.erase(it);
             }
             else {
@@ -1143,10 +1178,8 @@ void FIBProcessor::bindAudioService(
     Service *s = findServiceId(SId);
     if (!s) return;
 
-    if (std::find_if(components.begin(), components.end(),
-                [&](const ServiceComponent& sc) {
-                    return sc.SId == s->serviceId && sc.componentNr == compnr;
-                }) == components.end()) {
+    ServiceComponent *comp = findComponent(s->serviceId, compnr);
+    if (comp == nullptr) {
         ServiceComponent newcomp;
         newcomp.TMid         = TMid;
         newcomp.componentNr  = compnr;
@@ -1158,6 +1191,16 @@ void FIBProcessor::bindAudioService(
 
         //  std::clog << "fib-processor:" << "service %8x (comp %d) is audio\n", SId, compnr) << std::endl;
     }
+    else if (loadedFromCache and (comp->TMid != TMid or
+                comp->subchannelId != subChId or
+                comp->PS_flag != ps_flag or
+                comp->ASCTy != ASCTy)) {
+        comp->TMid         = TMid;
+        comp->subchannelId = subChId;
+        comp->PS_flag      = ps_flag;
+        comp->ASCTy        = ASCTy;
+        cacheOutdated = true;
+    }
 }
 
 void FIBProcessor::bindDataStreamService(
@@ -1171,10 +1214,8 @@ void FIBProcessor::bindDataStreamService(
     Service *s = findServiceId(SId);
     if (!s) return;
 
-    if (std::find_if(components.begin(), components.end(),
-                [&](const ServiceComponent& sc) {
-                    return sc.SId == s->serviceId && sc.componentNr == compnr;
-                }) == components.end()) {
+    ServiceComponent *comp = findComponent(s->serviceId, compnr);
+    if (comp == nullptr) {
         ServiceComponent newcomp;
         newcomp.TMid         = TMid;
         newcomp.SId          = SId;
@@ -1186,6 +1227,16 @@ void FIBProcessor::bindDataStreamService(
 
         //  std::clog << "fib-processor:" << "service %8x (comp %d) is packet\n", SId, compnr) << std::endl;
     }
+    else if (loadedFromCache and (comp->TMid != TMid or
+                comp->subchannelId != subChId or
+                comp->PS_flag != ps_flag or
+                comp->DSCTy != DSCTy)) {
+        comp->TMid         = TMid;
+        comp->subchannelId = subChId;
+        comp->PS_flag      = ps_flag;
+        comp->DSCTy        = DSCTy;
+        cacheOutdated = true;
+    }
 }
 
 //      bindPacketService is the main processor for - what the name suggests -
@@ -1202,10 +1253,8 @@ void FIBProcessor::bindPacketService(
     Service *s = findServiceId(SId);
     if (!s) return;
 
-    if (std::find_if(components.begin(), components.end(),
-                [&](const ServiceComponent& sc) {
-                    return sc.SId == s->serviceId && sc.componentNr == compnr;
-                }) == components.end()) {
+    ServiceComponent *comp = findComponent(s->serviceId, compnr);
+    if (comp == nullptr) {
         ServiceComponent newcomp;
         newcomp.TMid        = TMid;
         newcomp.SId         = SId;
@@ -1217,6 +1266,16 @@ void FIBProcessor::bindPacketService(
 
         //  std::clog << "fib-processor:" << "service %8x (comp %d) is packet\n", SId, compnr) << std::endl;
     }
+    else if (loadedFromCache and (comp->TMid != TMid or
+                comp->SCId != SCId or
+                comp->PS_flag != ps_flag or
+                comp->CAflag != CAflag)) {
+        comp->TMid    = TMid;
+        comp->SCId    = SCId;
+        comp->PS_flag = ps_flag;
+        comp->CAflag  = CAflag;
+        cacheOutdated = true;
+    }
 }
 
 void FIBProcessor::dropService(uint32_t SId)
@@ -1261,17 +1320,80 @@ void FIBProcessor::dropService(uint32_t SId)
     std::clog << ss.str() << std::endl;
 }
 
-void FIBProcessor::clearEnsemble()
+void FIBProcessor::resetDatabase()
 {
-    std::lock_guard<std::mutex> lock(mutex);
     components.clear();
-    subChannels.resize(64);
+    subChannels.assign(64, Subchannel());
     services.clear();
     serviceRepeatCount.clear();
     timeLastServiceDecrement = std::chrono::steady_clock::now();
+    loadedFromCache = false;
+}
+
+void FIBProcessor::clearEnsemble()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    resetDatabase();
+    cacheOutdated = false;
+    fibReceived = false;
     timeLastFCT0Frame = std::chrono::system_clock::now();
 }
 
+void FIBProcessor::loadEnsembleConfig(const EnsembleConfig& config)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        resetDatabase();
+
+        ensembleId = config.ensembleId;
+        ensembleEcc = config.ensembleEcc;
+        ensembleLabel = config.ensembleLabel;
+        services = config.services;
+        components = config.components;
+        for (const auto& sub : config.subChannels) {
+            subChannels.at(sub.subChId) = sub;
+        }
+
+        // The services have to be confirmed by FIG 0/2 like new ones
+        for (const auto& s : services) {
+            serviceRepeatCount[s.serviceId] = CACHED_SERVICE_REPEAT_COUNT;
+        }
+        loadedFromCache = true;
+    }
+
+    myRadioInterface.onNewEnsemble(config.ensembleId);
+    DabLabel label = config.ensembleLabel;
+    myRadioInterface.onSetEnsembleLabel(label);
+    for (const auto& s : config.services) {
+        myRadioInterface.onServiceDetected(s.serviceId);
+    }
+}
+
+EnsembleConfig FIBProcessor::getEnsembleConfig() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    EnsembleConfig config;
+    config.ensembleId = ensembleId;
+    config.ensembleEcc = ensembleEcc;
+    config.ensembleLabel = ensembleLabel;
+    config.services = services;
+    config.components = components;
+    for (const auto& sub : subChannels) {
+        if (sub.valid()) {
+            config.subChannels.push_back(sub);
+        }
+    }
+    return config;
+}
+
+bool FIBProcessor::isEnsembleComplete() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return fibReceived and ensembleId != 0 and not services.empty() and
+        std::chrono::steady_clock::now() - timeFirstFIB > ENSEMBLE_COMPLETE_TIME;
+}
+
 std::vector<Service> FIBProcessor::getServiceList() const
 {
     std::lock_guard<std::mutex> lock(mutex);
@@ -33,6 +33,7 @@
 #include <mutex>
 #include <cstdint>
 #include <cstdio>
+#include "ensemble-cache.h"
 #include "msc-handler.h"
 #include "radio-controller.h"
 
@@ -44,6 +45,15 @@ class FIBProcessor {
         void processFIB(uint8_t *p, uint16_t fib);
         void clearEnsemble();
 
+        // Fill the database with a configuration from the cache, until
+        // the FIC confirms or replaces it.
+        void loadEnsembleConfig(const EnsembleConfig& config);
+        EnsembleConfig getEnsembleConfig() const;
+
+        // Whether the FIC was received for long enough that the service
+        // list can be considered complete.
+        bool isEnsembleComplete() const;
+
         // Called from the frontend
         uint16_t getEnsembleId() const;
         uint8_t getEnsembleEcc() const;
@@ -85,6 +95,7 @@ class FIBProcessor {
                 int16_t CAflag);
 
         void dropService(uint32_t SId);
+        void resetDatabase();
 
         void process_FIG0(uint8_t *);
         void process_FIG1(uint8_t *);
@@ -132,6 +143,13 @@ class FIBProcessor {
         std::unordered_map<uint32_t, uint8_t> serviceRepeatCount;
         std::chrono::steady_clock::time_point timeLastServiceDecrement;
         std::chrono::system_clock::time_point timeLastFCT0Frame;
+
+        // Set while the database contains entries from the cache. Any
+        // difference with the FIC then asks for the service to restart.
+        bool loadedFromCache = false;
+        bool cacheOutdated = false;
+        bool fibReceived = false;
+        std::chrono::steady_clock::time_point timeFirstFIB;
 };
 
 #endif
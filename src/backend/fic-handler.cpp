@@ -49,10 +49,11 @@ uint8_t PI_X [24] = {
   *     puncturing.
   *     The data is sent through to the fic processor
   */
-FicHandler::FicHandler(RadioControllerInterface& mr) :
+FicHandler::FicHandler(RadioControllerInterface& mr, IQCapture& iqCapture) :
     Viterbi(768),
     fibProcessor(mr),
     myRadioInterface(mr),
+    iqCapture(iqCapture),
     bitBuffer_out(768),
     ofdm_input(2304),
     viterbiBlock(3072 + 24)
@@ -216,6 +217,7 @@ void FicHandler::processFicInput(const softbit_t *ficblock, int16_t ficno)
         uint8_t *p = &bitBuffer_out[(i % 3) * 256];
         const bool crcvalid = check_CRC_bits(p, 256);
         myRadioInterface.onFIBDecodeSuccess(crcvalid, p);
+        iqCapture.reportFIB(crcvalid);
         if (crcvalid) {
             fibProcessor.processFIB(p, ficno);
 
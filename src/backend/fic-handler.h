@@ -34,11 +34,12 @@
 #include "viterbi.h"
 #include "fib-processor.h"
 #include "radio-controller.h"
+#include "iq-capture.h"
 
 class FicHandler: public Viterbi
 {
     public:
-        FicHandler(RadioControllerInterface& mr);
+        FicHandler(RadioControllerInterface& mr, IQCapture& iqCapture);
         void    processFicBlock(const softbit_t *data, int16_t blkno);
         void    setBitsperBlock(int16_t b);
         void    clearEnsemble();
@@ -48,6 +49,7 @@ class FicHandler: public Viterbi
 
     private:
         RadioControllerInterface& myRadioInterface;
+        IQCapture& iqCapture;
         void        processFicInput(const softbit_t *ficblock, int16_t ficno);
         const int8_t *PI_15;
         const int8_t *PI_16;
@@ -0,0 +1,80 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef FRACTIONAL_RESAMPLER_H
+#define FRACTIONAL_RESAMPLER_H
+
+#include <cstddef>
+#include <vector>
+#include "dab-constants.h"
+
+/* Resamples the input stream by a ratio very close to one, to compensate
+ * the sampling clock offset of the receiver.
+ *
+ * Every output sample is interpolated by a windowed sinc filter, whose
+ * taps are taken from a polyphase table and linearly interpolated between
+ * its two nearest phases. The I and Q parts are kept in separate arrays,
+ * so that the compiler can vectorise the filter.
+ *
+ * The output is delayed by NUM_TAPS/2 samples. As long as the ratio is
+ * exactly one, the samples are only copied. */
+class FractionalResampler {
+    public:
+        FractionalResampler();
+        FractionalResampler(const FractionalResampler&) = delete;
+        FractionalResampler& operator=(const FractionalResampler&) = delete;
+
+        // Input samples per output sample, i.e. one plus the sampling
+        // clock offset
+        void setRatio(double ratio);
+        double getRatio(void) const;
+
+        // Clear the history, but keep the ratio
+        void reset(void);
+
+        // Number of input samples that process() needs for n output samples
+        size_t inputLength(size_t n) const;
+
+        // Consume inputLength(n) samples from in, and write n samples to out
+        void process(const DSPCOMPLEX *in, DSPCOMPLEX *out, size_t n);
+
+    private:
+        static constexpr size_t NUM_TAPS = 12;
+        static constexpr size_t NUM_PHASES = 128;
+
+        // NUM_PHASES + 1 rows of NUM_TAPS taps, the last one is for a
+        // delay of a full sample
+        std::vector<float> m_taps;
+
+        // The last NUM_TAPS input samples, followed by the new ones
+        std::vector<float> m_historyI;
+        std::vector<float> m_historyQ;
+
+        // Position of the next output sample in the history
+        double m_position;
+        double m_ratio = 1.0;
+};
+
+#endif
@@ -0,0 +1,269 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+#include "iq-capture.h"
+#include "dab-constants.h"
+
+const char* iqCaptureEventToString(IQCaptureEvent event)
+{
+    switch (event) {
+        case IQCaptureEvent::FICErrors:
+            return "fic";
+        case IQCaptureEvent::RSUncorrectable:
+            return "rs";
+        case IQCaptureEvent::SyncLoss:
+            return "syncloss";
+        case IQCaptureEvent::Manual:
+            return "manual";
+    }
+    throw std::logic_error("Unhandled IQ capture event");
+}
+
+// Rewrite native int16 samples in little-endian byte order, as given by
+// the .s16le.iq extension. Leaves the bytes unchanged on little-endian hosts.
+static void s16ToLittleEndian(std::vector<uint8_t>& buf)
+{
+    for (size_t i = 0; i + 1 < buf.size(); i += 2) {
+        int16_t value;
+        memcpy(&value, &buf[i], sizeof(value));
+        buf[i] = (uint16_t)value & 0xFF;
+        buf[i + 1] = (uint16_t)value >> 8;
+    }
+}
+
+IQCapture::IQCapture(const RawSampleFormat& format) :
+    format(format)
+{
+}
+
+IQCapture::~IQCapture()
+{
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+void IQCapture::configure(const IQCaptureSettings& s)
+{
+    {
+        std::lock_guard<std::mutex> lock(settingsMutex);
+        // Keep the samples collected so far if nothing changed
+        if (newSettings == s) {
+            return;
+        }
+        newSettings = s;
+    }
+    enabled = s.enabled;
+    ficErrorStreak = s.ficErrorStreak;
+    onRSUncorrectable = s.onRSUncorrectable;
+    onSyncLoss = s.onSyncLoss;
+    settingsChanged = true;
+}
+
+void IQCapture::applySettings()
+{
+    {
+        std::lock_guard<std::mutex> lock(settingsMutex);
+        settings = newSettings;
+    }
+
+    writePos = 0;
+    samplesInRing = 0;
+    holdOffSamples = 0;
+    capturing = false;
+    pendingEvent = -1;
+
+    size_t size = 0;
+    if (settings.enabled) {
+        const int seconds = std::max(settings.preTriggerSeconds, 0) +
+            std::max(settings.postTriggerSeconds, 0);
+        size = (size_t)seconds * INPUT_RATE * format.bytesPerSample();
+    }
+
+    // Allocate both buffers now, so that the pages are not faulted in
+    // by the first capture.
+    ring.assign(size, 0);
+    ring.shrink_to_fit();
+    if (not writerBusy) {
+        if (writer.joinable()) {
+            writer.join();
+        }
+        spare.assign(size, 0);
+        spare.shrink_to_fit();
+    }
+
+    if (size > 0) {
+        std::clog << "IQCapture: keeping " << size / 1000000 <<
+            " MB of samples" << std::endl;
+    }
+}
+
+void IQCapture::feed(const void *samples, size_t n)
+{
+    if (settingsChanged.load(std::memory_order_relaxed) and settingsChanged.exchange(false)) {
+        applySettings();
+    }
+
+    if (ring.empty()) {
+        return;
+    }
+
+    const size_t bytesPerSample = format.bytesPerSample();
+    const uint8_t *in = static_cast<const uint8_t*>(samples);
+    size_t length = n * bytesPerSample;
+    if (length > ring.size()) {
+        in += length - ring.size();
+        length = ring.size();
+    }
+
+    const size_t first = std::min(length, ring.size() - writePos);
+    std::copy(in, in + first, ring.begin() + writePos);
+    std::copy(in + first, in + length, ring.begin());
+    writePos = (writePos + length) % ring.size();
+    samplesInRing += n;
+
+    holdOffSamples -= std::min<uint64_t>(holdOffSamples, n);
+
+    if (pendingEvent.load(std::memory_order_relaxed) >= 0) {
+        const int event = pendingEvent.exchange(-1);
+        // Events during a capture or shortly after are ignored
+        if (event >= 0 and not capturing and holdOffSamples == 0) {
+            capturing = true;
+            captureEvent = static_cast<IQCaptureEvent>(event);
+            samplesUntilCapture = (uint64_t)std::max(settings.postTriggerSeconds, 0) * INPUT_RATE;
+            std::clog << "IQCapture: " << iqCaptureEventToString(captureEvent) <<
+                " event, capturing" << std::endl;
+        }
+    }
+
+    if (capturing) {
+        samplesUntilCapture -= std::min<uint64_t>(samplesUntilCapture, n);
+        if (samplesUntilCapture == 0) {
+            capturing = false;
+            holdOffSamples = (uint64_t)std::max(settings.holdOffSeconds, 0) * INPUT_RATE;
+            startWriter(captureEvent);
+        }
+    }
+}
+
+void IQCapture::trigger(IQCaptureEvent event)
+{
+    if (not enabled) {
+        return;
+    }
+
+    if ((event == IQCaptureEvent::RSUncorrectable and not onRSUncorrectable) or
+            (event == IQCaptureEvent::SyncLoss and not onSyncLoss)) {
+        return;
+    }
+
+    int none = -1;
+    pendingEvent.compare_exchange_strong(none, static_cast<int>(event));
+}
+
+void IQCapture::reportFIB(bool crcOk)
+{
+    if (crcOk) {
+        currentFicErrorStreak = 0;
+    }
+    else if (++currentFicErrorStreak == ficErrorStreak) {
+        trigger(IQCaptureEvent::FICErrors);
+    }
+}
+
+void IQCapture::startWriter(IQCaptureEvent event)
+{
+    if (writerBusy) {
+        std::clog << "IQCapture: still writing the previous capture, dropping this one" << std::endl;
+        return;
+    }
+
+    if (writer.joinable()) {
+        writer.join();
+    }
+
+    // Hand the ring buffer over to the writer and continue with the spare
+    std::swap(ring, spare);
+    const size_t bytes = std::min<uint64_t>(samplesInRing * format.bytesPerSample(), spare.size());
+    spareStart = (bytes == spare.size()) ? writePos : 0;
+    spareLength = bytes;
+
+    if (ring.size() != spare.size()) {
+        // The settings changed while the previous capture was written
+        ring.assign(spare.size(), 0);
+    }
+    writePos = 0;
+    samplesInRing = 0;
+
+    writerBusy = true;
+    const std::string fileName = makeFileName(event);
+    writer = std::thread([this, fileName]() {
+            FILE *fd = fopen(fileName.c_str(), "wb");
+            if (fd == nullptr) {
+                std::clog << "IQCapture: cannot open " << fileName << std::endl;
+            }
+            else {
+                if (format.type == RawSampleFormat::Type::S16) {
+                    s16ToLittleEndian(spare);
+                }
+
+                const size_t first = std::min(spareLength, spare.size() - spareStart);
+                const bool ok = fwrite(spare.data() + spareStart, 1, first, fd) == first and
+                    fwrite(spare.data(), 1, spareLength - first, fd) == spareLength - first;
+                fclose(fd);
+                std::clog << "IQCapture: " << (ok ? "wrote " : "failed to write ") <<
+                    fileName << std::endl;
+            }
+            writerBusy = false;
+        });
+}
+
+std::string IQCapture::makeFileName(IQCaptureEvent event) const
+{
+    const time_t now = time(nullptr);
+    char timestamp[32];
+    strftime(timestamp, sizeof(timestamp), "_%Y%m%d_%H%M%S_", localtime(&now));
+
+    std::string extension;
+    switch (format.type) {
+        case RawSampleFormat::Type::U8:
+            extension = ".u8.iq";
+            break;
+        case RawSampleFormat::Type::S16:
+            extension = ".s16le.iq";
+            break;
+        case RawSampleFormat::Type::CF32:
+            extension = ".cf32.iq";
+            break;
+    }
+
+    return settings.fileNamePrefix + timestamp + iqCaptureEventToString(event) + extension;
+}
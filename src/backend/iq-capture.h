@@ -0,0 +1,115 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef IQ_CAPTURE_H
+#define IQ_CAPTURE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "radio-controller.h"
+#include "radio-receiver-options.h"
+
+enum class IQCaptureEvent { FICErrors, RSUncorrectable, SyncLoss, Manual };
+
+const char* iqCaptureEventToString(IQCaptureEvent event);
+
+/* Keeps the last seconds of input samples in a ring buffer, and saves
+ * them to a file when a decoding anomaly is reported, together with the
+ * samples that follow the anomaly.
+ *
+ * The samples are kept in the native format of the input device, so
+ * that the receiver thread only copies bytes into the ring buffer. When
+ * the post-trigger samples are complete, the full ring buffer is swapped
+ * with a spare one of the same size, and a writer thread saves it to
+ * disk. This needs twice the memory of the ring buffer, but the receiver
+ * thread never waits for the disk nor copies the capture. The writer
+ * stores 16-bit samples in little-endian order, whatever the host. */
+class IQCapture {
+    public:
+        IQCapture(const RawSampleFormat& format);
+        ~IQCapture();
+        IQCapture(const IQCapture&) = delete;
+        IQCapture& operator=(const IQCapture&) = delete;
+
+        // Can be called from any thread, applied by the receiver thread
+        // with the next samples.
+        void configure(const IQCaptureSettings& settings);
+
+        // Only to be called from the receiver thread, with samples in
+        // the format given to the constructor.
+        void feed(const void *samples, size_t n);
+
+        // Report an event, from any thread. Disabled events are ignored.
+        void trigger(IQCaptureEvent event);
+
+        // Only to be called from the FIC decoder, counts CRC error streaks
+        void reportFIB(bool crcOk);
+
+    private:
+        void applySettings(void);
+        void startWriter(IQCaptureEvent event);
+        std::string makeFileName(IQCaptureEvent event) const;
+
+        const RawSampleFormat format;
+
+        std::mutex settingsMutex;
+        IQCaptureSettings newSettings;
+        std::atomic<bool> settingsChanged = ATOMIC_VAR_INIT(false);
+
+        // Copy of the event switches for trigger()
+        std::atomic<bool> enabled = ATOMIC_VAR_INIT(false);
+        std::atomic<int> ficErrorStreak = ATOMIC_VAR_INIT(0);
+        std::atomic<bool> onRSUncorrectable = ATOMIC_VAR_INIT(false);
+        std::atomic<bool> onSyncLoss = ATOMIC_VAR_INIT(false);
+
+        // Event waiting to be picked up by the receiver thread, -1 if none
+        std::atomic<int> pendingEvent = ATOMIC_VAR_INIT(-1);
+
+        // FIC decoder state
+        int currentFicErrorStreak = 0;
+
+        // Receiver thread state
+        IQCaptureSettings settings;
+        std::vector<uint8_t> ring;
+        size_t writePos = 0;
+        uint64_t samplesInRing = 0;
+        uint64_t samplesUntilCapture = 0;
+        uint64_t holdOffSamples = 0;
+        bool capturing = false;
+        IQCaptureEvent captureEvent = IQCaptureEvent::Manual;
+
+        // Owned by the writer thread while it runs
+        std::vector<uint8_t> spare;
+        size_t spareStart = 0;
+        size_t spareLength = 0;
+        std::atomic<bool> writerBusy = ATOMIC_VAR_INIT(false);
+        std::thread writer;
+};
+
+#endif
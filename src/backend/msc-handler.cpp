@@ -37,9 +37,11 @@
 //  Note CIF counts from 0 .. 3
 MscHandler::MscHandler(
         const DABParams& p,
-        bool show_crcErrors) :
+        bool show_crcErrors,
+        IQCapture& iqCapture) :
     bitsperBlock(2 * p.K),
     show_crcErrors(show_crcErrors),
+    iqCapture(iqCapture),
     cifVector(864 * CUSize)
 {
     if (p.dabMode == 4) {  // 2 CIFS per 76 blocks
@@ -81,7 +83,8 @@ bool MscHandler::addSubchannel(
                 sub.bitrate(),
                 sub.protectionSettings,
                 handler,
-                dumpFileName);
+                dumpFileName,
+                iqCapture);
 
      /* TODO dealing with data
       s.dabHandler = std::make_shared<DabData>(radioInterface,
@@ -40,13 +40,14 @@
 #include "dab-constants.h"
 #include "ringbuffer.h"
 #include "radio-controller.h"
+#include "iq-capture.h"
 
 class DabVirtual;
 
 class MscHandler
 {
     public:
-        MscHandler(const DABParams& p, bool show_crcErrors);
+        MscHandler(const DABParams& p, bool show_crcErrors, IQCapture& iqCapture);
 
         // Stop processing and remove all subchannels
         void stopProcessing(void);
@@ -89,6 +90,7 @@ class MscHandler
         const int16_t bitsperBlock;
         int16_t numberofblocksperCIF;
         bool show_crcErrors;
+        IQCapture& iqCapture;
 
         std::vector<softbit_t> cifVector;
         int16_t cifCount = 0; // msc blocks in CIF
@@ -28,10 +28,24 @@
  */
 
 #include <cstddef>
+#include <algorithm>
+#include <cmath>
 #include "ofdm-decoder.h"
 #include "various/profiling.h"
 #include <iostream>
 
+// Averaging constant of the per-carrier signal and noise estimates,
+// in data symbols.
+static const float CSI_ALPHA = 1.0f / 16.0f;
+// Carriers at this SNR get the same soft bit magnitude as with the
+// plain demapper, carriers above saturate.
+static const float CSI_REFERENCE_SNR = 10.0f;
+static const float CSI_MAX_SNR = 1000.0f;
+// Carriers estimated below this SNR are erased. Because the decisions
+// are mostly right even on noise, the estimate of a carrier without
+// any signal is 1.75, and 2 corresponds to an SNR of about -1.5 dB.
+static const float CSI_ERASURE_SNR = 2.0f;
+
 /**
  * \brief OfdmDecoder
  * The class OfdmDecoder is - when implemented in a separate thread -
@@ -49,14 +63,31 @@ OfdmDecoder::OfdmDecoder(
     ficHandler(ficHandler),
     mscHandler(mscHandler),
     pending_symbols(params.L),
-    phaseReference(params.T_u),
+    phaseReference(params.K),
     fft_handler(p.T_u),
-    interleaver(p),
-    ibits(2 * params.K)
+    carrierIndex(params.K),
+    carriers(params.K),
+    products(params.K),
+    ibits(2 * params.K),
+    csiDemapper(params.K)
 {
     T_g = params.T_s - params.T_u;
     fft_buffer = fft_handler.getVector();
 
+    /**
+     * a little optimization: we do not interchange the
+     * positive/negative frequencies to their right positions.
+     * The FFT bin of every de-interleaved carrier is computed
+     * once here, the negative frequencies wrapped.
+     */
+    FrequencyInterleaver interleaver(p);
+    for (int16_t i = 0; i < params.K; i++) {
+        int16_t index = interleaver.mapIn(i);
+        if (index < 0)
+            index += params.T_u;
+        carrierIndex[i] = index;
+    }
+
     /**
      * When implemented in a thread, the thread controls the
      * reading in of the data and processing the data through
@@ -82,9 +113,17 @@ void OfdmDecoder::reset()
         thread.join();
     }
 
+    // The channel has to be estimated again after a restart
+    csiDemapper.reset();
+
     thread = std::thread(&OfdmDecoder::workerthread, this);
 }
 
+void OfdmDecoder::setCSIWeighting(bool enable)
+{
+    csiWeighting = enable;
+}
+
 /**
  * The code in the thread executes a simple loop,
  * waiting for the next symbols and executing the interpretation
@@ -162,7 +201,59 @@ void OfdmDecoder::processPRS()
      * we are now in the frequency domain, and we keep the carriers
      * as coming from the FFT as phase reference.
      */
-    memcpy(phaseReference.data(), fft_buffer, params.T_u * sizeof (DSPCOMPLEX));
+    for (int i = 0; i < params.K; i++) {
+        phaseReference[i] = fft_buffer[carrierIndex[i]];
+    }
+}
+
+/**
+ * Differential demodulation of n carriers, written on the interleaved
+ * real and imaginary parts so that the compiler vectorises it: the
+ * complex multiplication operator does not, because of its checks
+ * for infinities.
+ * Also maps the products to soft bits, the real parts to bits[0 .. n-1]
+ * and the imaginary parts to bits[n .. 2n-1].
+ */
+static void demodulateAndDemap(
+        const DSPCOMPLEX *carriers,
+        const DSPCOMPLEX *reference,
+        DSPCOMPLEX *products,
+        softbit_t *bits,
+        size_t n)
+{
+    const DSPFLOAT *c = reinterpret_cast<const DSPFLOAT*>(carriers);
+    const DSPFLOAT *r = reinterpret_cast<const DSPFLOAT*>(reference);
+    DSPFLOAT *p = reinterpret_cast<DSPFLOAT*>(products);
+
+    for (size_t i = 0; i < n; i++) {
+        const DSPFLOAT re = c[2*i] * r[2*i] + c[2*i+1] * r[2*i+1];
+        const DSPFLOAT im = c[2*i+1] * r[2*i] - c[2*i] * r[2*i+1];
+        p[2*i] = re;
+        p[2*i+1] = im;
+
+        const DSPFLOAT ab1 = 127.0f / (std::fabs(re) + std::fabs(im));
+        bits[i] = -re * ab1;
+        bits[n + i] = -im * ab1;
+    }
+}
+
+/**
+ * Same as demodulateAndDemap, without the soft bits.
+ */
+static void demodulate(
+        const DSPCOMPLEX *carriers,
+        const DSPCOMPLEX *reference,
+        DSPCOMPLEX *products,
+        size_t n)
+{
+    const DSPFLOAT *c = reinterpret_cast<const DSPFLOAT*>(carriers);
+    const DSPFLOAT *r = reinterpret_cast<const DSPFLOAT*>(reference);
+    DSPFLOAT *p = reinterpret_cast<DSPFLOAT*>(products);
+
+    for (size_t i = 0; i < n; i++) {
+        p[2*i] = c[2*i] * r[2*i] + c[2*i+1] * r[2*i+1];
+        p[2*i+1] = c[2*i+1] * r[2*i] - c[2*i] * r[2*i+1];
+    }
 }
 
 /**
@@ -184,38 +275,36 @@ void OfdmDecoder::decodeDataSymbol(int32_t sym_ix)
      */
     fft_handler.do_FFT();
 
-    /**
-     * a little optimization: we do not interchange the
-     * positive/negative frequencies to their right positions.
-     * The de-interleaving understands this
-     */
-
     PROFILE(Deinterleaver);
     /**
      * Note that from here on, we are only interested in the
-     * K useful carriers of the FFT output
+     * K useful carriers of the FFT output, which we gather in
+     * the order of the de-interleaved bits.
      */
-    for (int16_t i = 0; i < params.K; i ++) {
-        int16_t index = interleaver.mapIn(i);
-        if (index < 0)
-            index += params.T_u;
-        /**
-         * decoding is computing the phase difference between
-         * carriers with the same index in subsequent symbols.
-         * The carrier of a symbols is the reference for the carrier
-         * on the same position in the next symbols
-         */
-        const DSPCOMPLEX r1 = fft_buffer[index] * conj (phaseReference[index]);
-        phaseReference[index] = fft_buffer[index];
-        const DSPFLOAT ab1 = 127.0f / l1_norm(r1);
-        /// split the real and the imaginary part and scale it
+    const size_t K = params.K;
+    for (size_t i = 0; i < K; i++) {
+        carriers[i] = fft_buffer[carrierIndex[i]];
+    }
 
-        ibits[i]            = -real (r1) * ab1;
-        ibits[params.K + i] = -imag (r1) * ab1;
+    /**
+     * decoding is computing the phase difference between
+     * carriers with the same index in subsequent symbols.
+     * The carrier of a symbols is the reference for the carrier
+     * on the same position in the next symbols
+     */
+    if (csiWeighting) {
+        demodulate(carriers.data(), phaseReference.data(),
+                products.data(), K);
+        csiDemapper.demap(products.data(), ibits.data());
+    }
+    else {
+        demodulateAndDemap(carriers.data(), phaseReference.data(),
+                products.data(), ibits.data(), K);
+    }
+    std::swap(phaseReference, carriers);
 
-        if (i % constellationDecimation == 0) {
-            constellationPoints.push_back(r1);
-        }
+    for (size_t i = 0; i < K; i += constellationDecimation) {
+        constellationPoints.push_back(products[i]);
     }
 
     if (sym_ix < 4) {
@@ -229,6 +318,69 @@ void OfdmDecoder::decodeDataSymbol(int32_t sym_ix)
     PROFILE(SymbolProcessed);
 }
 
+CSIDemapper::CSIDemapper(size_t K) :
+    signal(K),
+    noise(K)
+{
+}
+
+void CSIDemapper::reset()
+{
+    std::fill(signal.begin(), signal.end(), 0.0f);
+    std::fill(noise.begin(), noise.end(), 0.0f);
+}
+
+void CSIDemapper::demap(const DSPCOMPLEX *products, softbit_t *bits)
+{
+    const size_t K = signal.size();
+    for (size_t i = 0; i < K; i++) {
+        const DSPCOMPLEX r1 = products[i];
+        /**
+         * Rotate r1 onto the decided DQPSK point: the real part
+         * of d then carries the signal, the imaginary part only
+         * noise. A faded carrier gets a low SNR estimate and
+         * therefore soft bits close to zero, instead of bits
+         * as confident as those of the good carriers.
+         */
+        const DSPFLOAT sr = real(r1) < 0 ? -M_SQRT1_2 : M_SQRT1_2;
+        const DSPFLOAT si = imag(r1) < 0 ? -M_SQRT1_2 : M_SQRT1_2;
+        const DSPCOMPLEX d = r1 * DSPCOMPLEX(sr, -si);
+
+        float& s = signal[i];
+        float& n = noise[i];
+        if (s == 0.0f) {
+            // The first estimate comes from the product
+            // with the PRS, assume the reference SNR
+            s = std::abs(r1);
+            n = s * s / CSI_REFERENCE_SNR;
+        }
+        else {
+            s += CSI_ALPHA * (real(d) - s);
+            n += CSI_ALPHA * (2 * imag(d) * imag(d) - n);
+        }
+
+        const float snr_carrier = n > 0.0f ?
+            std::min(s * s / n, CSI_MAX_SNR) :
+            (s > 0.0f ? CSI_MAX_SNR : 0.0f);
+
+        if (snr_carrier < CSI_ERASURE_SNR) {
+            // Decisions on this carrier are no better than guesses
+            bits[i] = 0;
+            bits[K + i] = 0;
+        }
+        else {
+            // Normalise the decision variable to +-1 and scale it
+            // with the SNR, which makes it proportional to the LLR
+            const DSPFLOAT ab1 = 127.0f * M_SQRT1_2 / s *
+                snr_carrier / CSI_REFERENCE_SNR;
+            bits[i] = std::max(-127.0f,
+                    std::min(127.0f, -real(r1) * ab1));
+            bits[K + i] = std::max(-127.0f,
+                    std::min(127.0f, -imag(r1) * ab1));
+        }
+    }
+}
+
 /**
  * for the snr we have a full T_u wide vector, with in the middle
  * K carriers.
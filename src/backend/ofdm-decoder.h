@@ -38,6 +38,30 @@
 #include "fic-handler.h"
 #include "msc-handler.h"
 
+/* Maps the differential products of the K carriers of a symbol to soft
+ * bits scaled by the SNR of every carrier, so that the Viterbi decoder
+ * trusts faded carriers less. The SNR is estimated decision-directed on
+ * the products: the signal is the mean projection onto the decided
+ * DQPSK point, the noise the variance orthogonal to it. */
+class CSIDemapper
+{
+    public:
+        CSIDemapper(size_t K);
+
+        // Forget the estimates, e.g. after a restart
+        void    reset(void);
+
+        // The real parts are mapped to bits[0 .. K-1], and the
+        // imaginary parts to bits[K .. 2K-1], like with the plain
+        // demapper. The first symbol after a reset is assumed to be at
+        // the reference SNR, and gets the soft bits of the plain demapper.
+        void    demap(const DSPCOMPLEX *products, softbit_t *bits);
+
+    private:
+        std::vector<float> signal;
+        std::vector<float> noise;
+};
+
 class OfdmDecoder
 {
     public:
@@ -49,6 +73,10 @@ class OfdmDecoder
         ~OfdmDecoder();
         void    pushAllSymbols(std::vector<std::vector<DSPCOMPLEX> >&& sym);
         void    reset();
+
+        // Weight the soft bits of every carrier by its estimated SNR
+        // instead of mapping them to the phase of the carrier only.
+        void    setCSIWeighting(bool enable);
     private:
         int16_t get_snr(DSPCOMPLEX *, uint8_t method);
 
@@ -69,12 +97,20 @@ class OfdmDecoder
         void decodeDataSymbol(int32_t n);
 
         int32_t T_g;
+        // The carriers of the previous symbol, in the order of carrierIndex
         std::vector<DSPCOMPLEX> phaseReference;
         fft::Forward fft_handler;
         DSPCOMPLEX   *fft_buffer;
-        FrequencyInterleaver interleaver;
+
+        // FFT bin of every carrier in de-interleaved order
+        std::vector<int32_t> carrierIndex;
+        std::vector<DSPCOMPLEX> carriers;
+        std::vector<DSPCOMPLEX> products;
 
         std::vector<softbit_t> ibits;
+
+        std::atomic<bool> csiWeighting = ATOMIC_VAR_INIT(false);
+        CSIDemapper csiDemapper;
         int16_t snrCount = 0;
         float snr = 0;
 
@@ -30,13 +30,34 @@
  *
  */
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include "ofdm-processor.h"
+#include "signal-presence.h"
 #include "various/profiling.h"
 #include <iostream>
 //
 #define SEARCH_RANGE        (2 * 36)
 #define CORRELATION_LENGTH  24
+//  Below this normalised correlation, the spectrum is considered to
+//  be noise, see correlateSpectrum()
+#define MIN_SPECTRUM_CORRELATION 0.1f
+//  While tracking the timing, the full PRS correlation is still done
+//  every FULL_SYNC_INTERVAL frames, to update the impulse response
+#define FULL_SYNC_INTERVAL  10
+//  Gains of the timing tracking loop, for the error and its drift
+#define TIMING_GAIN         0.5f
+#define TIMING_DRIFT_GAIN   0.1f
+//  The tracking is abandoned when the correlation of the cyclic prefix
+//  drops below this fraction of the one measured after the full sync
+#define MIN_RELATIVE_CP_CORRELATION 0.5f
+//  Larger sampling clock offsets are considered to be estimation errors
+#define MAX_SAMPLING_CLOCK_OFFSET 200e-6
+//  How often the block for the spectrum display is refreshed
+#define SPECTRUM_UPDATES_PER_SECOND 25
+//  How often the spectra shown by the GUI and the web interface are computed
+#define SPECTRUM_ENGINE_UPDATES_PER_SECOND 10
 
 /**
   * \brief OFDMProcessor
@@ -50,6 +71,20 @@
   * to the interpreters for FIC and MSC
   */
 
+/* The oscillator table only depends on INPUT_RATE, it is shared by all
+ * OFDMProcessor instances of the process instead of having 16MB per
+ * receiver. Initialisation of the function-local static is thread-safe. */
+static const std::vector<DSPCOMPLEX>& sharedOscillatorTable()
+{
+    static const std::vector<DSPCOMPLEX> table = [](){
+        std::vector<DSPCOMPLEX> t(INPUT_RATE);
+        for (int i = 0; i < INPUT_RATE; i ++)
+            t[i] = DSPCOMPLEX(cos(2.0 * M_PI * i / INPUT_RATE),
+                    sin(2.0 * M_PI * i / INPUT_RATE));
+        return t;
+    }();
+    return table;
+}
 
 OFDMProcessor::OFDMProcessor(
         InputInterface& inputInterface,
@@ -57,22 +92,30 @@ OFDMProcessor::OFDMProcessor(
         RadioControllerInterface& ri,
         MscHandler& msc,
         FicHandler& fic,
+        IQCapture& iqCapture,
         RadioReceiverOptions rro) :
     receiver_options(rro),
     radioInterface(ri),
     input(inputInterface),
     params(params),
     ficHandler(fic),
-    tiiDecoder(params, ri),
+    iqCapture(iqCapture),
+    cirAnalyser(params),
+    tiiDecoder(params, ri, cirAnalyser),
     T_null(params.T_null),
     T_u(params.T_u),
     T_s(params.T_s),
     T_F(params.T_F),
-    oscillatorTable(INPUT_RATE),
+    oscillatorTable(sharedOscillatorTable()),
     phaseRef(params, rro.fftPlacementMethod),
     ofdmDecoder(params, ri, fic, msc),
+    rawFormat(inputInterface.getRawSampleFormat()),
+    spectrumSnapshot(params.T_u, SPECTRUM_UPDATES_PER_SECOND),
+    spectrumEngine(spectrumSnapshot, params.T_u, SPECTRUM_ENGINE_UPDATES_PER_SECOND),
     fft_handler(params.T_u),
-    fft_buffer(fft_handler.getVector())
+    fft_buffer(fft_handler.getVector()),
+    fft_correlation(params.T_u),
+    ifft_correlation(params.T_u)
 {
     /**
      * the class phaseReference will take a number of samples
@@ -89,10 +132,6 @@ OFDMProcessor::OFDMProcessor(
      * the decoded symbols
      */
 
-    for (int i = 0; i < INPUT_RATE; i ++)
-        oscillatorTable[i] = DSPCOMPLEX(cos(2.0 * M_PI * i / INPUT_RATE),
-                sin(2.0 * M_PI * i / INPUT_RATE));
-
     //  and for the correlation
     refArg.resize(CORRELATION_LENGTH);
     for (int i = 0; i < CORRELATION_LENGTH; i ++)  {
@@ -101,6 +140,21 @@ OFDMProcessor::OFDMProcessor(
     }
 
     correlationVector.resize(SEARCH_RANGE + CORRELATION_LENGTH);
+
+    ofdmDecoder.setCSIWeighting(rro.csiWeightedDemapper);
+
+    //  and for the correlation of the whole spectrum
+    DSPCOMPLEX *refDiff = fft_correlation.getVector();
+    for (int i = 0; i < T_u; i ++) {
+        refDiff[i] = phaseRef[i] * conj(phaseRef[(i + 1) % T_u]);
+        refDiffEnergy += norm(refDiff[i]);
+    }
+    fft_correlation.do_FFT();
+
+    refDiffSpectrum.resize(T_u);
+    for (int i = 0; i < T_u; i ++) {
+        refDiffSpectrum[i] = conj(refDiff[i]);
+    }
 }
 
 OFDMProcessor::~OFDMProcessor()
@@ -126,6 +180,9 @@ void OFDMProcessor::restart()
     syncBufferIndex    = 0;
     sLevel             = 0;
     localPhase         = 0;
+    timingTracking     = false;
+    resampler.reset();
+    tiiDecoder.reset();
     bool inputRestarted = false;
     try {
         inputRestarted = input.restart();
@@ -162,36 +219,63 @@ class InputFailure { };
 class NotRunningAnymore { };
 
 /**
- * \brief getSample
- * Profiling shows that getting a sample, together
- * with the frequency shift, is a real performance killer.
- * we therefore distinguish between getting a single sample
- * and getting a vector full of samples
+ * \brief readInput
+ * Reads the samples from the input device, and resamples them to
+ * compensate the sampling clock offset. Exactly n samples are written
+ * to v, a short read from the device is filled with zeros.
  */
-
-DSPCOMPLEX OFDMProcessor::getSample(int32_t phase)
+void OFDMProcessor::readInput(DSPCOMPLEX *v, int32_t n)
 {
-    DSPCOMPLEX temp;
     if (!running)
         throw NotRunningAnymore();
-    /// bufferContent is an indicator for the value of ...->Samples ()
-    if (bufferContent == 0) {
-        bufferContent = input.getSamplesToRead ();
-        while ((bufferContent == 0) && running) {
+
+    const int32_t needed = resampler.inputLength(n);
+    if (needed > bufferContent) {
+        bufferContent = input.getSamplesToRead();
+        while ((bufferContent < needed) && running) {
             if (not input.is_ok()) {
                 throw InputFailure();
             }
             std::this_thread::sleep_for(std::chrono::microseconds(10));
-            bufferContent = input.getSamplesToRead ();
+            bufferContent = input.getSamplesToRead();
         }
     }
-
     if (!running)
         throw NotRunningAnymore();
     //
-    //  so here, bufferContent > 0
-    input.getSamples (&temp, 1);
-    bufferContent --;
+    //  so here, bufferContent >= needed
+    resamplerInput.resize(needed);
+    DSPCOMPLEX *in = resamplerInput.data();
+    int32_t got;
+    if (rawFormat.type == RawSampleFormat::Type::CF32) {
+        got = input.getSamples(in, needed);
+        iqCapture.feed(in, got);
+    }
+    else {
+        rawBuffer.resize(needed * rawFormat.bytesPerSample());
+        got = input.getRawSamples(rawBuffer.data(), needed);
+        convertRawSamples(rawBuffer.data(), rawFormat, in, got);
+        iqCapture.feed(rawBuffer.data(), got);
+    }
+    bufferContent -= got;
+    spectrumSnapshot.feed(in, got);
+    std::fill(in + got, in + needed, DSPCOMPLEX(0, 0));
+
+    resampler.process(in, v, n);
+}
+
+/**
+ * \brief getSample
+ * Profiling shows that getting a sample, together
+ * with the frequency shift, is a real performance killer.
+ * we therefore distinguish between getting a single sample
+ * and getting a vector full of samples
+ */
+
+DSPCOMPLEX OFDMProcessor::getSample(int32_t phase)
+{
+    DSPCOMPLEX temp;
+    readInput(&temp, 1);
 
     //
     //  OK, we have a sample!!
@@ -214,24 +298,7 @@ void OFDMProcessor::getSamples(DSPCOMPLEX *v, int16_t n, int32_t phase)
 {
     int32_t     i;
 
-    if (!running)
-        throw NotRunningAnymore();
-    if (n > bufferContent) {
-        bufferContent = input.getSamplesToRead ();
-        while ((bufferContent < n) && running) {
-            if (not input.is_ok()) {
-                throw InputFailure();
-            }
-            std::this_thread::sleep_for(std::chrono::microseconds(10));
-            bufferContent = input.getSamplesToRead();
-        }
-    }
-    if (!running)
-        throw NotRunningAnymore();
-    //
-    //  so here, bufferContent >= n
-    n = input.getSamples (v, n);
-    bufferContent -= n;
+    readInput(v, n);
 
     //  OK, we have samples!!
     //  first: adjust frequency. We need Hz accuracy
@@ -268,6 +335,7 @@ void OFDMProcessor::run()
     constexpr int32_t syncBufferSize  = 32768;
     constexpr int32_t syncBufferMask  = syncBufferSize - 1;
     float envBuffer[syncBufferSize];
+    bool isSynced = false;
 
     std::vector<DSPCOMPLEX> ofdmBuffer(params.L * params.T_s);
     std::vector<std::vector<DSPCOMPLEX> > allSymbols;
@@ -280,6 +348,25 @@ void OFDMProcessor::run()
         for (i = 0; i < T_F / 2; i ++) {
             l1_norm(getSample (0));
         }
+
+        if (scanMode) {
+            /* Look for the null symbol over a bit more than a frame,
+             * so that empty channels are skipped without waiting for
+             * several failed synchronisation attempts. */
+            std::vector<DSPCOMPLEX> frame(T_F + T_null);
+            const int32_t chunk = 16384;
+            for (size_t j = 0; j < frame.size(); j += chunk) {
+                getSamples(&frame[j],
+                        std::min<size_t>(chunk, frame.size() - j), 0);
+            }
+
+            if (nullDipDepth(frame.data(), frame.size(), T_null / 2) >
+                    NULL_DIP_THRESHOLD) {
+                radioInterface.onSignalPresence(false);
+                scanMode  = false;
+                attempts  = 0;
+            }
+        }
 notSynced:
         PROFILE(NotSynced);
         if (scanMode && ++attempts > 5) {
@@ -309,6 +396,10 @@ notSynced:
          */
         counter  = 0;
         radioInterface.onSyncChange(false);
+        if (isSynced) {
+            isSynced = false;
+            iqCapture.trigger(IQCaptureEvent::SyncLoss);
+        }
         while (currentStrength / 50  > 0.50 * sLevel) {
             DSPCOMPLEX sample =
                 getSample (coarseCorrector + fineCorrector);
@@ -361,33 +452,68 @@ SyncOnPhase:
          * as long as we can be sure that the first sample to be identified
          * is part of the samples read.
          */
-        getSamples(ofdmBuffer.data(), T_u, coarseCorrector + fineCorrector);
-        //
-        /// and then, call upon the phase synchronizer to verify/compute
-        /// the real "first" sample
-        startIndex = phaseRef.findIndex(ofdmBuffer.data(),
-                impulseResponseBuffer);
-        PROFILE(FindIndex);
-        radioInterface.onNewImpulseResponse(std::move(impulseResponseBuffer));
-        impulseResponseBuffer.clear();
-
-        if (startIndex < 0) { // no sync, try again
-            std::clog << "ofdm-processor: " << "SyncOnPhase failed" << std::endl;
-            goto notSynced;
+        isFullSync = not timingTracking or
+            framesSinceFullSync >= FULL_SYNC_INTERVAL;
+
+        if (isFullSync) {
+            getSamples(ofdmBuffer.data(), T_u, coarseCorrector + fineCorrector);
+            //
+            /// and then, call upon the phase synchronizer to verify/compute
+            /// the real "first" sample
+            startIndex = phaseRef.findIndex(ofdmBuffer.data(),
+                    impulseResponseBuffer);
+            PROFILE(FindIndex);
+            if (startIndex >= 0) {
+                bool decodeTII = false;
+                {
+                    std::lock_guard<std::mutex> lock(receiver_options_mutex);
+                    decodeTII = receiver_options.decodeTII;
+                }
+                if (decodeTII) {
+                    // The frames tracked since the previous full sync
+                    // and this one
+                    cirAnalyser.process(impulseResponseBuffer,
+                            framesSinceFullSync + 1);
+                }
+            }
+            radioInterface.onNewImpulseResponse(std::move(impulseResponseBuffer));
+            impulseResponseBuffer.clear();
+
+            if (startIndex < 0) { // no sync, try again
+                std::clog << "ofdm-processor: " << "SyncOnPhase failed" << std::endl;
+                timingTracking = false;
+                goto notSynced;
+            }
+            if (scanMode) {
+                radioInterface.onSignalPresence(true);
+                scanMode  = false;
+                attempts  = 0;
+            }
+
+            /**
+             * Once here, we are synchronized, we need to copy the data we
+             * used for synchronization for the PRS */
+            memmove(ofdmBuffer.data(), &ofdmBuffer[startIndex],
+                    (params.T_u - startIndex) * sizeof (DSPCOMPLEX));
+            ofdmBufferIndex  = params.T_u - startIndex;
+
+            trackedStartIndex = startIndex;
+            framesSinceFullSync = 0;
         }
-        if (scanMode) {
-            radioInterface.onSignalPresence(true);
-            scanMode  = false;
-            attempts  = 0;
+        else {
+            /**
+             * When tracking, the PRS starts where it started in the previous
+             * frame, moved by the timing loop. We skip the samples before it
+             * and read it directly at the start of the buffer. */
+            PROFILE(TrackTiming);
+            if (trackedStartIndex > 0) {
+                getSamples(ofdmBuffer.data(), trackedStartIndex,
+                        coarseCorrector + fineCorrector);
+            }
+            ofdmBufferIndex = 0;
+            framesSinceFullSync++;
         }
 
-        /**
-         * Once here, we are synchronized, we need to copy the data we
-         * used for synchronization for the PRS */
-        memmove(ofdmBuffer.data(), &ofdmBuffer[startIndex],
-                (params.T_u - startIndex) * sizeof (DSPCOMPLEX));
-        ofdmBufferIndex  = params.T_u - startIndex;
-
         //Symbol 0: Phase reference symbol symbol
         /**
          * Symbol 0 is special in that it is used for fine time synchronization
@@ -396,6 +522,7 @@ SyncOnPhase:
          * We read the missing samples in the ofdm buffer
          */
         radioInterface.onSyncChange(true);
+        isSynced = true;
         getSamples(&ofdmBuffer[ofdmBufferIndex],
                 T_u - ofdmBufferIndex,
                 coarseCorrector + fineCorrector);
@@ -412,6 +539,60 @@ SyncOnPhase:
             std::copy(ofdmBuffer.begin(), ofdmBuffer.begin() + T_u, prs.begin());
         }
 
+        const bool coarseSearch = !rro.disableCoarseCorrector and
+            ficHandler.getFicDecodeRatioPercent() < 50;
+
+        //  The timing is only tracked when the coarse corrector is
+        //  settled, otherwise the channel estimate is meaningless.
+        if (coarseSearch and timingTracking) {
+            timingTracking = false;
+            isFullSync = true;
+        }
+
+        //  The spectrum of the PRS is used by the timing loop and by
+        //  the coarse corrector
+        memcpy(fft_buffer, ofdmBuffer.data(), T_u * sizeof(DSPCOMPLEX));
+        fft_handler.do_FFT();
+
+        if (isFullSync) {
+            //  The timing loop keeps the channel where the full sync
+            //  placed it. Its drift estimate is kept over the full syncs,
+            //  unless the tracking was lost.
+            if (not timingTracking) {
+                timingDrift = 0;
+                timingAccumulator = 0;
+            }
+            else {
+                updateSamplingClockOffset();
+            }
+            timingReference = estimateChannelDelay();
+            timingAccumulator += timingDrift;
+            timingTracking = not coarseSearch;
+        }
+        else {
+            const float error = estimateChannelDelay() - timingReference;
+            if (std::abs(error) > (T_s - T_u) / 4) {
+                std::clog << "ofdm-processor: " << "Lost timing, error " <<
+                    error << " samples" << std::endl;
+                timingTracking = false;
+            }
+            else {
+                timingDrift += TIMING_DRIFT_GAIN * error;
+                timingAccumulator += TIMING_GAIN * error + timingDrift;
+            }
+        }
+
+        {
+            //  A positive error means that the FFT window starts too
+            //  late, fewer samples have to be skipped
+            const int shift = std::lround(timingAccumulator);
+            timingAccumulator -= shift;
+            trackedStartIndex -= shift;
+            if (trackedStartIndex < 0 or trackedStartIndex >= T_u) {
+                timingTracking = false;
+            }
+        }
+
         //  Here we look only at the PRS when we need a coarse
         //  frequency synchronization.
         //  The width is limited to 2 * 35 kHz (i.e. positive and negative)
@@ -421,13 +602,13 @@ SyncOnPhase:
         //  reception glitch might provoke a long delay until it resyncs properly.
         //  As long as some FICs have correct CRC, we assume the coarse corrector cannot
         //  be off.
-        if (!rro.disableCoarseCorrector and ficHandler.getFicDecodeRatioPercent() < 50) {
+        if (coarseSearch) {
             if (!coarseSyncCounter) {
                 std::clog << "ofdm-processor: " << "Lost coarse sync (coarseCorrector: " << lastValidCoarseCorrector << "; fineCorrector: " <<  lastValidFineCorrector << ")" << std::endl;
             }
 
             coarseSyncCounter++;
-            int correction = processPRS(ofdmBuffer.data(), rro.freqsyncMethod);
+            int correction = processPRS(rro.freqsyncMethod);
             if (correction != 100) {
                 coarseCorrector += correction * params.carrierDiff;
                 if (abs (coarseCorrector) > kHz(35))
@@ -439,6 +620,7 @@ SyncOnPhase:
                  std::clog << "ofdm-processor: " << "Found sync (coarseCorrector: " << lastValidCoarseCorrector << "; fineCorrector: " <<  lastValidFineCorrector << " after " << coarseSyncCounter << " frames)" << std::endl;
             }
             coarseSyncCounter = 0;
+            coarseSyncConfidence = -1.0f;
 
             lastValidFineCorrector = fineCorrector;
             lastValidCoarseCorrector = coarseCorrector;
@@ -460,12 +642,31 @@ SyncOnPhase:
          * corresponding samples in the datapart.
          */
         DSPCOMPLEX FreqCorr = DSPCOMPLEX(0, 0);
+        float cpEnergy = 0;
         for (int sym = 1; sym < params.L; sym ++) {
             auto& buf = allSymbols[sym];
             buf.resize(T_s);
             getSamples(buf.data(), T_s, coarseCorrector + fineCorrector);
-            for (int i = T_u; i < T_s; i ++)
+            for (int i = T_u; i < T_s; i ++) {
                 FreqCorr += buf[i] * conj(buf[i - T_u]);
+                cpEnergy += norm(buf[i]) + norm(buf[i - T_u]);
+            }
+        }
+
+        //  The normalised correlation of the cyclic prefix drops when
+        //  the FFT window drifts away, which ends the timing tracking.
+        {
+            const float cpCorrelation = cpEnergy > 0 ?
+                2 * abs(FreqCorr) / cpEnergy : 0;
+            if (isFullSync) {
+                cpCorrelationReference = cpCorrelation;
+            }
+            else if (timingTracking and cpCorrelation <
+                    MIN_RELATIVE_CP_CORRELATION * cpCorrelationReference) {
+                std::clog << "ofdm-processor: " << "Lost timing, cyclic prefix correlation " <<
+                    cpCorrelation << std::endl;
+                timingTracking = false;
+            }
         }
 
         PROFILE(PushAllSymbols);
@@ -493,6 +694,7 @@ SyncOnPhase:
         }
 
         PROFILE(OnNewNull);
+        spectrumEngine.feedNullSymbol(nullSymbol);
         radioInterface.onNewNullSymbol(std::move(nullSymbol));
 
         /**
@@ -548,6 +750,7 @@ void OFDMProcessor::setReceiverOptions(const RadioReceiverOptions rro)
     bool need_reset = (receiver_options.disableCoarseCorrector != rro.disableCoarseCorrector);
     receiver_options = rro;
     phaseRef.selectFFTWindowPlacement(rro.fftPlacementMethod);
+    ofdmDecoder.setCSIWeighting(rro.csiWeightedDemapper);
     lock.unlock();
 
     if (need_reset) {
@@ -560,14 +763,27 @@ void OFDMProcessor::set_scanMode(bool b)
     scanMode = b;
 }
 
+std::vector<float> OFDMProcessor::getSpectrum(SpectrumEngine::Source source,
+        std::chrono::milliseconds maxWait) const
+{
+    return spectrumEngine.read(source, maxWait);
+}
+
+std::vector<transmitter_track_t> OFDMProcessor::getTransmitterTracks() const
+{
+    return cirAnalyser.getTracks();
+}
+
+float OFDMProcessor::getCoarseSyncConfidence() const
+{
+    return coarseSyncConfidence;
+}
+
 #define RANGE 36
-int16_t OFDMProcessor::processPRS(DSPCOMPLEX *v, const FreqsyncMethod& freqsyncMethod)
+int16_t OFDMProcessor::processPRS(const FreqsyncMethod& freqsyncMethod)
 {
     int16_t i, j, index = 100;
 
-    memcpy(fft_buffer, v, T_u * sizeof(DSPCOMPLEX));
-    fft_handler.do_FFT();
-
     switch (freqsyncMethod) {
         case FreqsyncMethod::GetMiddle:
             return getMiddle(fft_buffer);
@@ -596,10 +812,10 @@ int16_t OFDMProcessor::processPRS(DSPCOMPLEX *v, const FreqsyncMethod& freqsyncM
                 float sum = 0;
                 for (j = 0; j < CORRELATION_LENGTH; j ++) {
                     sum += abs(refArg [j] * correlationVector[i + j]);
-                    if (sum > MMax) {
-                        MMax = sum;
-                        index = i;
-                    }
+                }
+                if (sum > MMax) {
+                    MMax = sum;
+                    index = i;
                 }
             }
 
@@ -638,10 +854,127 @@ int16_t OFDMProcessor::processPRS(DSPCOMPLEX *v, const FreqsyncMethod& freqsyncM
             }
             return index - T_u;
         }
+        case FreqsyncMethod::CorrelateSpectrum:
+            return correlateSpectrum(fft_buffer);
     }
     throw std::logic_error("Unimplemented freqsyncMethod");
 }
 
+int16_t OFDMProcessor::correlateSpectrum(DSPCOMPLEX *v)
+{
+    //  Like CorrelatePRS, we correlate the products of successive
+    //  carriers, which do not depend on the phase offset, and
+    //  only very little on the placement of the FFT window.
+    //  Keeping them complex instead of taking their arg() allows to
+    //  compute the correlation for all offsets at once, as
+    //  IFFT(FFT(diff) * conj(FFT(refDiff))).
+    DSPCOMPLEX *diff = fft_correlation.getVector();
+    float energy = 0;
+    for (int i = 0; i < T_u - 1; i ++) {
+        diff[i] = v[i] * conj(v[i + 1]);
+        energy += norm(diff[i]);
+    }
+    diff[T_u - 1] = v[T_u - 1] * conj(v[0]);
+    energy += norm(diff[T_u - 1]);
+
+    fft_correlation.do_FFT();
+
+    DSPCOMPLEX *corr = ifft_correlation.getVector();
+    for (int i = 0; i < T_u; i ++) {
+        corr[i] = diff[i] * refDiffSpectrum[i];
+    }
+    ifft_correlation.do_IFFT();
+
+    //  corr[i] now is the correlation of the received spectrum, shifted
+    //  by i carriers, with the reference
+    float maxCorr = -1;
+    int16_t index = 0;
+    for (int i = -SEARCH_RANGE / 2; i < SEARCH_RANGE / 2; i ++) {
+        const float c = abs(corr[(T_u + i) % T_u]);
+        if (c > maxCorr) {
+            maxCorr = c;
+            index = i;
+        }
+    }
+
+    //  By Cauchy-Schwarz, this is between 0 and 1. Noise alone gives
+    //  about 0.05.
+    const float confidence = (energy > 0 and refDiffEnergy > 0) ?
+        maxCorr / sqrt(energy * refDiffEnergy) : 0;
+    coarseSyncConfidence = confidence;
+
+    //  A parabola through the peak and its neighbours estimates the
+    //  fractional part of the offset. The inter-carrier interference
+    //  makes it too unreliable to correct the fine corrector with it,
+    //  it is only logged to show how far off the tuning is.
+    const float prev = abs(corr[(T_u + index - 1) % T_u]);
+    const float next = abs(corr[(T_u + index + 1) % T_u]);
+    const float denominator = prev - 2 * maxCorr + next;
+    const float delta = denominator < 0 ? 0.5f * (prev - next) / denominator : 0;
+
+    if (coarseSyncCounter % 10 == 1) {
+        std::clog << "ofdm-processor: coarse offset " << index + delta <<
+            " carriers, confidence " << confidence << std::endl;
+    }
+
+    if (confidence < MIN_SPECTRUM_CORRELATION) {
+        return 100;
+    }
+    return index;
+}
+
+void OFDMProcessor::updateSamplingClockOffset()
+{
+    //  The drift of the timing loop is the change of the delay of the
+    //  channel estimate from one PRS to the next, that is left after
+    //  the resampler. When the PRS comes later in every frame, the
+    //  sampling clock of the receiver is too fast, and more input
+    //  samples have to be consumed for every output sample.
+    //  The drift is moved into the ratio of the resampler.
+    const double ratio = resampler.getRatio() * (1.0 - timingDrift / T_F);
+
+    if (std::abs(ratio - 1.0) > MAX_SAMPLING_CLOCK_OFFSET) {
+        std::clog << "ofdm-processor: " << "Implausible sampling clock offset " <<
+            (ratio - 1.0) * 1e6 << " ppm" << std::endl;
+        resampler.setRatio(1.0);
+    }
+    else {
+        resampler.setRatio(ratio);
+        timingDrift = 0;
+    }
+
+    samplingClockOffset = (resampler.getRatio() - 1.0) * 1e6;
+}
+
+float OFDMProcessor::getSamplingClockOffset() const
+{
+    return samplingClockOffset;
+}
+
+float OFDMProcessor::estimateChannelDelay()
+{
+    //  A delay of the FFT window by d samples turns the PRS carriers
+    //  into refTable[k] * exp(j 2 pi k d / T_u). The phase between
+    //  successive carriers of the channel estimate is therefore
+    //  proportional to the delay of the channel, weighted by the power
+    //  of its paths. Carrier 0 is not used.
+    const int K = params.K;
+    DSPCOMPLEX sum = 0;
+    DSPCOMPLEX prev = fft_buffer[T_u - K / 2] * conj(phaseRef[T_u - K / 2]);
+    for (int k = -K / 2 + 1; k <= K / 2; k ++) {
+        if (k == 0) {
+            continue;
+        }
+        const int ix = (T_u + k) % T_u;
+        const DSPCOMPLEX h = fft_buffer[ix] * conj(phaseRef[ix]);
+        if (k != 1) {
+            sum += h * conj(prev);
+        }
+        prev = h;
+    }
+    return T_u / (2 * M_PI) * arg(sum);
+}
+
 int16_t OFDMProcessor::getMiddle (DSPCOMPLEX *v)
 {
     int16_t     i;
@@ -40,6 +40,7 @@
 #include <vector>
 #include "phasereference.h"
 #include "ofdm-decoder.h"
+#include "cir-analyser.h"
 #include "tii-decoder.h"
 #include "virtual_input.h"
 #include "fft.h"
@@ -47,6 +48,10 @@
 #include "radio-receiver-options.h"
 #include "fic-handler.h"
 #include "msc-handler.h"
+#include "spectrum-snapshot.h"
+#include "spectrum-engine.h"
+#include "iq-capture.h"
+#include "fractional-resampler.h"
 
 class OFDMProcessor
 {
@@ -57,6 +62,7 @@ class OFDMProcessor
                 RadioControllerInterface& ri,
                 MscHandler& msc,
                 FicHandler& fic,
+                IQCapture& iqCapture,
                 RadioReceiverOptions rro);
         ~OFDMProcessor();
 
@@ -68,6 +74,27 @@ class OFDMProcessor
         void setReceiverOptions(const RadioReceiverOptions rro);
         void set_scanMode(bool);
 
+        /* Averaged spectrum of the input samples, before frequency
+         * correction, or of the NULL symbol, in dB. Can be called from
+         * any thread, see SpectrumEngine::read(). */
+        std::vector<float> getSpectrum(SpectrumEngine::Source source,
+                std::chrono::milliseconds maxWait) const;
+
+        /* Transmitters seen in the channel impulse response, only
+         * tracked while TII decoding is enabled. Can be called from any
+         * thread. */
+        std::vector<transmitter_track_t> getTransmitterTracks() const;
+
+        /* Normalised correlation between the PRS spectrum and the
+         * reference at the coarse frequency offset found last, from 0
+         * to 1. Only measured by FreqsyncMethod::CorrelateSpectrum while
+         * the coarse corrector is searching, negative otherwise. */
+        float getCoarseSyncConfidence() const;
+
+        /* Sampling clock offset of the input device in ppm, as compensated
+         * by the resampler. Can be called from any thread. */
+        float getSamplingClockOffset() const;
+
     private:
         std::mutex receiver_options_mutex;
         RadioReceiverOptions receiver_options;
@@ -78,7 +105,9 @@ class OFDMProcessor
         InputInterface& input;
         const DABParams& params;
         FicHandler& ficHandler;
+        IQCapture& iqCapture;
         std::vector<float> impulseResponseBuffer;
+        CIRAnalyser cirAnalyser;
         TIIDecoder tiiDecoder;
 
         std::atomic<bool> running = ATOMIC_VAR_INIT(false);
@@ -89,7 +118,7 @@ class OFDMProcessor
         int32_t T_F;
         int32_t coarseSyncCounter = 0;
 
-        std::vector<DSPCOMPLEX> oscillatorTable;
+        const std::vector<DSPCOMPLEX>& oscillatorTable;
 
         int32_t localPhase = 0;
 
@@ -102,6 +131,19 @@ class OFDMProcessor
         int32_t coarseCorrector = 0;
 
         uint32_t ofdmBufferIndex = 0;
+
+        // Timing tracking: between two full syncs with
+        // PhaseReference::findIndex(), the start of the PRS is moved by a
+        // loop that keeps the delay of the channel estimate at the
+        // timingReference found after the full sync.
+        bool timingTracking = false;
+        bool isFullSync = true;
+        int framesSinceFullSync = 0;
+        int32_t trackedStartIndex = 0;
+        float timingReference = 0;
+        float timingAccumulator = 0;
+        float timingDrift = 0;
+        float cpCorrelationReference = 0;
         PhaseReference phaseRef;
         OfdmDecoder ofdmDecoder;
         std::vector<float> correlationVector;
@@ -112,14 +154,41 @@ class OFDMProcessor
 
         int32_t bufferContent = 0;
 
+        // Samples in the native format of the input device, converted
+        // in bulk into the working buffer by getSamples()
+        const RawSampleFormat rawFormat;
+        std::vector<uint8_t> rawBuffer;
+
+        // Compensates the sampling clock offset estimated by the timing
+        // loop, see updateSamplingClockOffset()
+        FractionalResampler resampler;
+        std::vector<DSPCOMPLEX> resamplerInput;
+        std::atomic<float> samplingClockOffset = ATOMIC_VAR_INIT(0.0f);
+
+        SpectrumSnapshot spectrumSnapshot;
+        SpectrumEngine spectrumEngine;
+
         fft::Forward fft_handler;
         DSPCOMPLEX *fft_buffer; // of size T_u
 
+        // Cross-correlation of the PRS spectrum with the reference, for
+        // FreqsyncMethod::CorrelateSpectrum. The spectrum of the phase
+        // differences of the reference is only computed once.
+        fft::Forward fft_correlation;
+        fft::Backward ifft_correlation;
+        std::vector<DSPCOMPLEX> refDiffSpectrum;
+        float refDiffEnergy = 0;
+        std::atomic<float> coarseSyncConfidence = ATOMIC_VAR_INIT(-1.0f);
+
+        void readInput(DSPCOMPLEX *v, int32_t n);
         DSPCOMPLEX getSample(int32_t);
         void getSamples(DSPCOMPLEX *, int16_t, int32_t);
         void run(void);
-        int16_t processPRS(DSPCOMPLEX *v, const FreqsyncMethod& freqsyncMethod);
+        int16_t processPRS(const FreqsyncMethod& freqsyncMethod);
+        float estimateChannelDelay(void);
+        void updateSamplingClockOffset(void);
         int16_t getMiddle(DSPCOMPLEX *);
+        int16_t correlateSpectrum(DSPCOMPLEX *);
 };
 #endif
 
@@ -37,6 +37,7 @@
 #include <vector>
 #include <string>
 #include <complex>
+#include <cstdint>
 #include "dab-constants.h"
 
 struct dab_date_time_t {
@@ -113,7 +114,9 @@ class RadioControllerInterface {
         /* For every FIB, tell if the CRC check passed. fib points to a bit-vector with 256 bits of FIB data  */
         virtual void onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib) = 0;
 
-        /* When a new channel impulse response vector was calculated */
+        /* When a new channel impulse response vector was calculated. While
+         * the OFDMProcessor tracks the timing, this only happens every
+         * tenth frame. */
         virtual void onNewImpulseResponse(std::vector<float>&& data) = 0;
 
         /* When new constellation points are available. data contains
@@ -182,8 +185,68 @@ enum class DeviceParam {
     SoapySDRAntenna,
     SoapySDRDriverArgs,
     SoapySDRClockSource,
+    SoapySDRSampleRate,
+    RTLTCPReceiveBufferSize,
 };
 
+/* Native format of the samples an input device hands out through
+ * InputInterface::getRawSamples(). Every sample is an I/Q pair, and
+ * each component converts to float as (raw - offset) * scale. */
+struct RawSampleFormat {
+    enum class Type { CF32, U8, S16 };
+
+    Type type = Type::CF32;
+    float offset = 0.0f;
+    float scale = 1.0f;
+
+    size_t bytesPerSample(void) const {
+        switch (type) {
+            case Type::U8: return 2 * sizeof(uint8_t);
+            case Type::S16: return 2 * sizeof(int16_t);
+            case Type::CF32: break;
+        }
+        return sizeof(DSPCOMPLEX);
+    }
+};
+
+/* Convert num_samples samples in the given format to complex floats, in
+ * bulk. The loops are written so that the compiler can vectorise them. */
+inline void convertRawSamples(const void *raw, const RawSampleFormat& format,
+        DSPCOMPLEX *out, size_t num_samples)
+{
+    float *f = reinterpret_cast<float*>(out);
+    const size_t n = 2 * num_samples;
+    const float offset = format.offset;
+    const float scale = format.scale;
+
+    switch (format.type) {
+        case RawSampleFormat::Type::U8:
+            {
+                const uint8_t *in = static_cast<const uint8_t*>(raw);
+                for (size_t i = 0; i < n; i++) {
+                    f[i] = ((float)in[i] - offset) * scale;
+                }
+            }
+            break;
+        case RawSampleFormat::Type::S16:
+            {
+                const int16_t *in = static_cast<const int16_t*>(raw);
+                for (size_t i = 0; i < n; i++) {
+                    f[i] = ((float)in[i] - offset) * scale;
+                }
+            }
+            break;
+        case RawSampleFormat::Type::CF32:
+            {
+                const float *in = static_cast<const float*>(raw);
+                for (size_t i = 0; i < n; i++) {
+                    f[i] = (in[i] - offset) * scale;
+                }
+            }
+            break;
+    }
+}
+
 /* Definition of the interface all input devices must implement */
 class InputInterface {
 public:
@@ -195,7 +258,6 @@ public:
     virtual void stop(void) = 0;
     virtual void reset(void) = 0;
     virtual int32_t getSamples(DSPCOMPLEX* buffer, int32_t size) = 0;
-    virtual std::vector<DSPCOMPLEX> getSpectrumSamples(int size) = 0;
     virtual int32_t getSamplesToRead(void) = 0;
     virtual float setGain(int gain) = 0;
     virtual float getGain(void) const = 0;
@@ -203,6 +265,19 @@ public:
     virtual void setAgc(bool agc) = 0;
     virtual std::string getDescription(void) = 0;
 
+    /* Devices that produce integer samples can hand them out without
+     * conversion, so that the receiver converts them only once, directly
+     * into its own buffer. buffer must hold size samples in the format
+     * given by getRawSampleFormat(). Returns the number of samples read.
+     * By default, the samples are read as complex floats. */
+    virtual RawSampleFormat getRawSampleFormat(void) const {
+        return RawSampleFormat();
+    }
+
+    virtual int32_t getRawSamples(void *buffer, int32_t size) {
+        return getSamples(static_cast<DSPCOMPLEX*>(buffer), size);
+    }
+
     virtual bool setDeviceParam(DeviceParam param, int value) {
         (void)param; (void)value;
         return false;
@@ -32,8 +32,10 @@
 
 #pragma once
 
+#include <string>
+
 // see OFDMProcessor::processPRS() for more information about these methods
-enum class FreqsyncMethod { GetMiddle = 0, CorrelatePRS = 1, PatternOfZeros = 2 };
+enum class FreqsyncMethod { GetMiddle = 0, CorrelatePRS = 1, PatternOfZeros = 2, CorrelateSpectrum = 3 };
 
 enum class FFTPlacementMethod {
     /* Old method: places the FFT on the strongest peak, which must be at least
@@ -62,6 +64,40 @@ enum class FFTPlacementMethod {
 // Default uses the old algorithm until the issues of the new one are solved.
 constexpr auto DEFAULT_FFT_PLACEMENT = FFTPlacementMethod::ThresholdBeforePeak;
 
+// Saving of the input samples around decoding anomalies, see IQCapture
+struct IQCaptureSettings {
+    // The ring buffer is only allocated while enabled
+    bool enabled = false;
+
+    // The captures are written to <fileNamePrefix>_<date>_<time>_<event>
+    // with the extension telling the sample format to CRAWFile.
+    std::string fileNamePrefix = "welle-io-capture";
+
+    // Seconds of samples before and after the event
+    int preTriggerSeconds = 5;
+    int postTriggerSeconds = 2;
+
+    // Events closer than this to the previous capture are ignored
+    int holdOffSeconds = 60;
+
+    // Number of consecutive FIBs with wrong CRC that trigger a capture,
+    // 0 to disable
+    int ficErrorStreak = 12;
+    bool onRSUncorrectable = true;
+    bool onSyncLoss = true;
+
+    bool operator==(const IQCaptureSettings& other) const {
+        return enabled == other.enabled and
+            fileNamePrefix == other.fileNamePrefix and
+            preTriggerSeconds == other.preTriggerSeconds and
+            postTriggerSeconds == other.postTriggerSeconds and
+            holdOffSeconds == other.holdOffSeconds and
+            ficErrorStreak == other.ficErrorStreak and
+            onRSUncorrectable == other.onRSUncorrectable and
+            onSyncLoss == other.onSyncLoss;
+    }
+};
+
 // Configuration for the backend
 struct RadioReceiverOptions {
     // Select the algorithm used in the OFDMProcessor PRS sync logic
@@ -81,5 +117,18 @@ struct RadioReceiverOptions {
     // Which method to use for the freqsyncmethod used in the coarse corrector.
     // Has no effect when coarse corrector is disabled.
     FreqsyncMethod freqsyncMethod = FreqsyncMethod::PatternOfZeros;
+
+    // Weight the soft bits by the SNR of their carrier, estimated from the
+    // PRS and the previous symbols. Helps on frequency selective channels
+    // where faded carriers would otherwise give confident wrong bits.
+    bool csiWeightedDemapper = false;
+
+    // Disabled by default, needs several MB of memory when enabled
+    IQCaptureSettings iqCapture;
+
+    // Directory where the ensemble configuration of every channel is
+    // kept, so that services can start before the FIC is received.
+    // Disabled when empty.
+    std::string ensembleCacheDirectory;
 };
 
@@ -59,6 +59,8 @@ const char* freqSyncMethodToString(FreqsyncMethod method)
             return "GetMiddle";
         case FreqsyncMethod::PatternOfZeros:
             return "PatternOfZeros";
+        case FreqsyncMethod::CorrelateSpectrum:
+            return "CorrelateSpectrum";
     }
     throw std::logic_error("Unhandled freqsyncMethod placement");
 }
@@ -69,32 +71,61 @@ RadioReceiver::RadioReceiver(
                 RadioReceiverOptions rro,
                 int transmission_mode) :
     params(transmission_mode),
-    mscHandler(params, false),
-    ficHandler(rci),
+    input(input),
+    iqCapture(input.getRawSampleFormat()),
+    mscHandler(params, false, iqCapture),
+    ficHandler(rci, iqCapture),
     ofdmProcessor(input,
         params,
         rci,
         mscHandler,
         ficHandler,
+        iqCapture,
         rro)
-{ }
+{
+    iqCapture.configure(rro.iqCapture);
+    if (not rro.ensembleCacheDirectory.empty()) {
+        ensembleCache = make_unique<EnsembleCache>(rro.ensembleCacheDirectory);
+    }
+}
+
+RadioReceiver::~RadioReceiver()
+{
+    saveEnsembleConfig();
+}
 
 void RadioReceiver::restart(bool doScan)
 {
+    saveEnsembleConfig();
+
     ofdmProcessor.set_scanMode(doScan);
     mscHandler.stopProcessing();
     ficHandler.clearEnsemble();
+
+    // A scan has to find out what is really on the channel
+    ensembleFrequency = input.getFrequency();
+    EnsembleConfig config;
+    if (ensembleCache and not doScan and ensembleFrequency != 0 and
+            ensembleCache->load(ensembleFrequency, config)) {
+        clog << "RadioReceiver: using cached configuration of ensemble 0x" <<
+            hex << config.ensembleId << dec << " with " <<
+            config.services.size() << " services" << endl;
+        ficHandler.fibProcessor.loadEnsembleConfig(config);
+    }
+
     ofdmProcessor.restart();
 }
 
 void RadioReceiver::restart_decoder()
 {
+    saveEnsembleConfig();
     mscHandler.stopProcessing();
     ficHandler.clearEnsemble();
 }
 
 void RadioReceiver::stop()
 {
+    saveEnsembleConfig();
     ofdmProcessor.stop();
     mscHandler.stopProcessing();
     ficHandler.clearEnsemble();
@@ -102,19 +133,30 @@ void RadioReceiver::stop()
 
 void RadioReceiver::setReceiverOptions(const RadioReceiverOptions rro)
 {
-    string fsm;
-    switch (rro.freqsyncMethod) {
-        case FreqsyncMethod::GetMiddle: fsm = "GetMiddle"; break;
-        case FreqsyncMethod::CorrelatePRS: fsm = "CorrelatePRS"; break;
-        case FreqsyncMethod::PatternOfZeros: fsm = "PatternOfZeros"; break;
-    }
-
     clog << "New Receiver Options: " <<
         "TII: " << rro.decodeTII <<
         " disable coarse corr: " << rro.disableCoarseCorrector <<
-        " freqsync: " << fsm <<
+        " freqsync: " << freqSyncMethodToString(rro.freqsyncMethod) <<
+        " CSI demapper: " << rro.csiWeightedDemapper <<
         " fft placement: " << fftPlacementMethodToString(rro.fftPlacementMethod) << endl;
     ofdmProcessor.setReceiverOptions(rro);
+    iqCapture.configure(rro.iqCapture);
+
+    if (rro.ensembleCacheDirectory.empty()) {
+        ensembleCache.reset();
+    }
+    else {
+        ensembleCache = make_unique<EnsembleCache>(rro.ensembleCacheDirectory);
+    }
+}
+
+void RadioReceiver::saveEnsembleConfig()
+{
+    if (ensembleCache and ensembleFrequency != 0 and
+            ficHandler.fibProcessor.isEnsembleComplete()) {
+        ensembleCache->save(ensembleFrequency,
+                ficHandler.fibProcessor.getEnsembleConfig());
+    }
 }
 
 bool RadioReceiver::playSingleProgramme(ProgrammeHandlerInterface& handler,
@@ -143,6 +185,11 @@ bool RadioReceiver::removeServiceToDecode(const Service& s)
     return false;
 }
 
+void RadioReceiver::stopServiceDecoders()
+{
+    mscHandler.stopProcessing();
+}
+
 bool RadioReceiver::playProgramme(ProgrammeHandlerInterface& handler,
         const Service& s, const std::string& dumpFileName, bool unique)
 {
@@ -228,3 +275,29 @@ RadioReceiverStats RadioReceiver::getReceiverStats() const
     s.timeLastFCT0Frame = ficHandler.fibProcessor.getTimeLastFCT0Frame();
     return s;
 }
+
+std::vector<float> RadioReceiver::getSpectrum(SpectrumEngine::Source source,
+        std::chrono::milliseconds maxWait) const
+{
+    return ofdmProcessor.getSpectrum(source, maxWait);
+}
+
+std::vector<transmitter_track_t> RadioReceiver::getTransmitterTracks() const
+{
+    return ofdmProcessor.getTransmitterTracks();
+}
+
+float RadioReceiver::getCoarseSyncConfidence() const
+{
+    return ofdmProcessor.getCoarseSyncConfidence();
+}
+
+float RadioReceiver::getSamplingClockOffset() const
+{
+    return ofdmProcessor.getSamplingClockOffset();
+}
+
+void RadioReceiver::triggerIQCapture()
+{
+    iqCapture.trigger(IQCaptureEvent::Manual);
+}
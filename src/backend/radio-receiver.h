@@ -38,7 +38,9 @@
 #include <string>
 #include "radio-controller.h"
 #include "radio-receiver-options.h"
+#include "ensemble-cache.h"
 #include "fic-handler.h"
+#include "iq-capture.h"
 #include "msc-handler.h"
 #include "ofdm-processor.h"
 
@@ -56,6 +58,7 @@ class RadioReceiver {
                 InputInterface& input,
                 RadioReceiverOptions rro,
                 int transmission_mode = 1);
+        ~RadioReceiver();
 
         /* Restart the receiver, and specify if we want
          * to scan or receive. */
@@ -80,6 +83,10 @@ class RadioReceiver {
 
         bool removeServiceToDecode(const Service& s);
 
+        /* Stop all service decoders, but keep the FIC database, so that
+         * the services can be started again with a new configuration. */
+        void stopServiceDecoders();
+
         uint16_t getEnsembleId(void) const;
         uint8_t getEnsembleEcc(void) const;
         DabLabel getEnsembleLabel(void) const;
@@ -102,14 +109,50 @@ class RadioReceiver {
 
         RadioReceiverStats getReceiverStats() const;
 
+        /* Averaged spectrum of the input signal or of the NULL symbol,
+         * in dB with the DC carrier in the middle, or an empty vector if
+         * none is available yet. The spectra are only computed while this
+         * is called regularly, and the first call after a pause can wait
+         * up to maxWait for them. */
+        std::vector<float> getSpectrum(SpectrumEngine::Source source,
+                std::chrono::milliseconds maxWait =
+                    std::chrono::milliseconds(0)) const;
+
+        /* Delay and level of the transmitters of an SFN, estimated from
+         * the channel impulse response, and associated to their TII code
+         * when it was decoded. Only available when TII decoding is
+         * enabled in the receiver options. */
+        std::vector<transmitter_track_t> getTransmitterTracks() const;
+
+        /* Confidence of the last coarse frequency acquisition, between 0
+         * and 1, or negative when not measured. See
+         * FreqsyncMethod::CorrelateSpectrum. */
+        float getCoarseSyncConfidence() const;
+
+        /* Sampling clock offset of the input device in ppm, estimated
+         * while the timing is tracked, and compensated by resampling. */
+        float getSamplingClockOffset() const;
+
+        /* Save the input samples around now to a file, like it happens
+         * for decoding anomalies when enabled in the receiver options. */
+        void triggerIQCapture(void);
+
     private:
+        // Store the ensemble configuration if it is complete
+        void saveEnsembleConfig(void);
+
         bool playProgramme(ProgrammeHandlerInterface& handler,
                 const Service& s,
                 const std::string& dumpFileName,
                 bool unique);
 
         DABParams params; // Defaults to TM1 parameters
+        InputInterface& input;
+        std::unique_ptr<EnsembleCache> ensembleCache;
+        // Frequency the current ensemble configuration belongs to
+        int ensembleFrequency = 0;
 
+        IQCapture iqCapture;
         MscHandler mscHandler;
         FicHandler ficHandler;
         OFDMProcessor ofdmProcessor;
@@ -0,0 +1,178 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "signal-presence.h"
+#include "MathHelper.h"
+
+// Half the width of an ensemble, the edges are left out of the measurement
+static constexpr int HALF_ENSEMBLE_WIDTH = 700000;
+
+// Part of the capture that is not affected by the anti-aliasing filter
+static constexpr double USABLE_BANDWIDTH = 0.9;
+
+// Resolution of the averaged spectrum
+static constexpr int FREQUENCY_RESOLUTION = 4000;
+
+// The noise floor is taken at this percentile of the spectrum. It has
+// to be low, because most of the band can be occupied by ensembles.
+static constexpr double NOISE_FLOOR_PERCENTILE = 0.1;
+
+float nullDipDepth(const DSPCOMPLEX *samples, size_t n, size_t window)
+{
+    if (window == 0 or n < window) {
+        return 1.0f;
+    }
+
+    double total = 0;
+    for (size_t i = 0; i < n; i++) {
+        total += l1_norm(samples[i]);
+    }
+    if (total == 0) {
+        return 1.0f;
+    }
+
+    double sum = 0;
+    for (size_t i = 0; i < window; i++) {
+        sum += l1_norm(samples[i]);
+    }
+
+    double minimum = sum;
+    for (size_t i = window; i < n; i++) {
+        sum += l1_norm(samples[i]) - l1_norm(samples[i - window]);
+        minimum = std::min(minimum, sum);
+    }
+
+    return (minimum / window) / (total / n);
+}
+
+static int fft_size_for(int sampleRate)
+{
+    int size = 64;
+    while (size < sampleRate / FREQUENCY_RESOLUTION) {
+        size *= 2;
+    }
+    return size;
+}
+
+ChannelOccupancy::ChannelOccupancy(int sampleRate) :
+    sampleRate(sampleRate),
+    fftSize(fft_size_for(sampleRate)),
+    fft(new fft::Forward(fftSize)),
+    window(fftSize),
+    powerSum(fftSize)
+{
+    // Hann window against the leakage of strong ensembles into the
+    // noise floor
+    for (int i = 0; i < fftSize; i++) {
+        window[i] = 0.5 - 0.5 * cos(2.0 * M_PI * i / fftSize);
+    }
+    pending.reserve(fftSize);
+}
+
+void ChannelOccupancy::reset()
+{
+    pending.clear();
+    std::fill(powerSum.begin(), powerSum.end(), 0.0f);
+    numBlocks = 0;
+}
+
+void ChannelOccupancy::add(const DSPCOMPLEX *samples, size_t n)
+{
+    DSPCOMPLEX *v = fft->getVector();
+
+    while (n > 0) {
+        const size_t num = std::min(n, (size_t)fftSize - pending.size());
+        pending.insert(pending.end(), samples, samples + num);
+        samples += num;
+        n -= num;
+
+        if (pending.size() == (size_t)fftSize) {
+            for (int i = 0; i < fftSize; i++) {
+                v[i] = pending[i] * window[i];
+            }
+            fft->do_FFT();
+            for (int i = 0; i < fftSize; i++) {
+                powerSum[i] += std::norm(v[i]);
+            }
+            numBlocks++;
+            pending.clear();
+        }
+    }
+}
+
+bool ChannelOccupancy::isMeasurable(int centreFrequency, int frequency) const
+{
+    return std::abs(frequency - centreFrequency) + HALF_ENSEMBLE_WIDTH <=
+        USABLE_BANDWIDTH * sampleRate / 2;
+}
+
+std::vector<float> ChannelOccupancy::measure(int centreFrequency,
+        const std::vector<int>& frequencies) const
+{
+    std::vector<float> result(frequencies.size(), 0.0f);
+    if (numBlocks == 0) {
+        return result;
+    }
+
+    // Bin of a frequency offset, with negative frequencies in the
+    // upper half of the FFT output
+    auto bin_of = [&](double offset) {
+        const int k = (int)lround(offset * fftSize / sampleRate);
+        return (k + fftSize) % fftSize;
+    };
+
+    const int usable = (int)(USABLE_BANDWIDTH * fftSize / 2);
+    std::vector<float> usablePower;
+    usablePower.reserve(2 * usable);
+    for (int k = -usable; k < usable; k++) {
+        usablePower.push_back(powerSum[(k + fftSize) % fftSize]);
+    }
+    auto percentile = usablePower.begin() + (size_t)(NOISE_FLOOR_PERCENTILE * usablePower.size());
+    std::nth_element(usablePower.begin(), percentile, usablePower.end());
+    const double noiseFloor = *percentile;
+
+    if (noiseFloor <= 0) {
+        return result;
+    }
+
+    for (size_t i = 0; i < frequencies.size(); i++) {
+        if (not isMeasurable(centreFrequency, frequencies[i])) {
+            continue;
+        }
+
+        const double offset = frequencies[i] - centreFrequency;
+        const int first = bin_of(offset - HALF_ENSEMBLE_WIDTH);
+        const int width = bin_of(2.0 * HALF_ENSEMBLE_WIDTH);
+
+        double power = 0;
+        for (int k = 0; k < width; k++) {
+            power += powerSum[(first + k) % fftSize];
+        }
+        result[i] = 10.0 * log10(power / width / noiseFloor);
+    }
+    return result;
+}
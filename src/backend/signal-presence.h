@@ -0,0 +1,83 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef SIGNAL_PRESENCE_H
+#define SIGNAL_PRESENCE_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "dab-constants.h"
+#include "fft.h"
+
+/* Cheap checks for the presence of a DAB signal on a short block of
+ * samples, so that a channel scan can skip empty channels without
+ * attempting a full synchronisation. */
+
+// Below this null dip depth, the block probably contains a DAB signal
+static constexpr float NULL_DIP_THRESHOLD = 0.8f;
+
+// Smallest average magnitude over a window of the given length, relative
+// to the average magnitude of the whole block. With a block longer than
+// a transmission frame and a window shorter than the null symbol, a DAB
+// signal gives the depth of the null symbol, well below one. On noise,
+// the value stays close to one.
+float nullDipDepth(const DSPCOMPLEX *samples, size_t n, size_t window);
+
+/* Estimates which DAB channels of a wideband capture are occupied.
+ * The power spectrum of the capture is averaged, and for each channel
+ * the average power over the width of an ensemble is compared to the
+ * noise floor, taken as a low percentile of the whole spectrum. */
+class ChannelOccupancy {
+    public:
+        ChannelOccupancy(int sampleRate);
+        ChannelOccupancy(const ChannelOccupancy&) = delete;
+        ChannelOccupancy& operator=(const ChannelOccupancy&) = delete;
+
+        void reset(void);
+
+        // Accumulate samples, any length
+        void add(const DSPCOMPLEX *samples, size_t n);
+
+        // Whether the whole ensemble at frequency lies inside the part
+        // of the capture that can be measured.
+        bool isMeasurable(int centreFrequency, int frequency) const;
+
+        // Ratio in dB between the power of each ensemble and the noise
+        // floor. Frequencies that cannot be measured give 0.
+        std::vector<float> measure(int centreFrequency,
+                const std::vector<int>& frequencies) const;
+
+    private:
+        const int sampleRate;
+        const int fftSize;
+        std::unique_ptr<fft::Forward> fft;
+        std::vector<float> window;
+        std::vector<DSPCOMPLEX> pending;
+        std::vector<float> powerSum;
+        size_t numBlocks = 0;
+};
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "spectrum-engine.h"
+
+// Stop computing when the spectra were not read for this long
+static const std::chrono::seconds IDLE_TIMEOUT(2);
+
+// Weight of a new spectrum in the moving average of the power
+static const float AVERAGING_FACTOR = 0.2f;
+
+using namespace std;
+
+SpectrumEngine::SpectrumEngine(const SpectrumSnapshot& snapshot,
+        size_t fftSize, int updatesPerSecond) :
+    snapshot(snapshot),
+    fftSize(fftSize),
+    interval(1000 / max(1, updatesPerSecond)),
+    fft(fftSize)
+{
+    thread = std::thread(&SpectrumEngine::workerthread, this);
+}
+
+SpectrumEngine::~SpectrumEngine()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wakeup.notify_all();
+    updated.notify_all();
+
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void SpectrumEngine::feedNullSymbol(const vector<DSPCOMPLEX>& nullSymbol)
+{
+    if (nullSymbol.size() < fftSize or not isActive()) {
+        return;
+    }
+
+    lock_guard<std::mutex> lock(nullMutex);
+    pendingNull.assign(nullSymbol.begin(), nullSymbol.begin() + fftSize);
+}
+
+vector<float> SpectrumEngine::read(Source source,
+        chrono::milliseconds maxWait) const
+{
+    unique_lock<std::mutex> lock(mutex);
+    const bool wasActive = isActive();
+    lastRead = chrono::steady_clock::now().time_since_epoch().count();
+
+    if (not wasActive) {
+        // Start computing right away, the worker sleeps until now
+        wakeup.notify_all();
+    }
+
+    updated.wait_for(lock, maxWait, [&]{
+            return not running or not result(source).empty(); });
+    return result(source);
+}
+
+const vector<float>& SpectrumEngine::result(Source source) const
+{
+    return source == Source::Signal ? signalDB : nullDB;
+}
+
+bool SpectrumEngine::isActive() const
+{
+    const auto last = lastRead.load();
+    if (last == 0) {
+        return false;
+    }
+
+    const auto now = chrono::steady_clock::now().time_since_epoch().count();
+    return chrono::steady_clock::duration(now - last) < IDLE_TIMEOUT;
+}
+
+vector<float> SpectrumEngine::transform(vector<float>& power,
+        const DSPCOMPLEX *samples)
+{
+    DSPCOMPLEX *buffer = fft.getVector();
+    copy(samples, samples + fftSize, buffer);
+    fft.do_FFT();
+
+    const bool first = power.empty();
+    power.resize(fftSize);
+
+    vector<float> dB(fftSize);
+    const size_t half = fftSize / 2;
+    for (size_t i = 0; i < fftSize; i++) {
+        const float p = norm(buffer[(i + half) % fftSize]);
+        power[i] = first ? p : power[i] + AVERAGING_FACTOR * (p - power[i]);
+        dB[i] = 10.0f * log10(power[i] + 1e-20f);
+    }
+    return dB;
+}
+
+void SpectrumEngine::workerthread()
+{
+    vector<float> signalPower;
+    vector<float> nullPower;
+    vector<DSPCOMPLEX> nullSymbol;
+
+    unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        if (not isActive()) {
+            signalPower.clear();
+            nullPower.clear();
+            signalDB.clear();
+            nullDB.clear();
+
+            // read() updates lastRead with the mutex held
+            wakeup.wait(lock, [&]{ return not running or isActive(); });
+            continue;
+        }
+
+        lock.unlock();
+
+        vector<float> newSignalDB;
+        const auto samples = snapshot.read(fftSize);
+        if (samples.size() == fftSize) {
+            newSignalDB = transform(signalPower, samples.data());
+        }
+
+        vector<float> newNullDB;
+        {
+            lock_guard<std::mutex> nullLock(nullMutex);
+            nullSymbol.swap(pendingNull);
+            pendingNull.clear();
+        }
+        if (nullSymbol.size() == fftSize) {
+            newNullDB = transform(nullPower, nullSymbol.data());
+        }
+
+        lock.lock();
+        if (not newSignalDB.empty()) {
+            signalDB = move(newSignalDB);
+        }
+        if (not newNullDB.empty()) {
+            nullDB = move(newNullDB);
+        }
+        updated.notify_all();
+
+        wakeup.wait_for(lock, interval, [&]{ return not running; });
+    }
+}
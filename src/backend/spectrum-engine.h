@@ -0,0 +1,104 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef SPECTRUM_ENGINE_H
+#define SPECTRUM_ENGINE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "dab-constants.h"
+#include "fft.h"
+#include "spectrum-snapshot.h"
+
+/* Computes the spectra shown by the GUI and the web interface, so that
+ * all plots, the waterfall included, consume the same result.
+ *
+ * The FFT plan is created once together with the engine. A worker thread
+ * transforms the latest block of the SpectrumSnapshot and the latest NULL
+ * symbol at most updatesPerSecond times per second, averages the power
+ * over successive updates, and publishes the result in dB with the DC
+ * carrier in the middle.
+ *
+ * Nothing is computed while nobody reads the spectra: the worker sleeps
+ * when read() was not called for a while, and restarts the averaging on
+ * the next read(). */
+class SpectrumEngine {
+    public:
+        enum class Source { Signal, NullSymbol };
+
+        SpectrumEngine(const SpectrumSnapshot& snapshot,
+                size_t fftSize, int updatesPerSecond);
+        ~SpectrumEngine();
+        SpectrumEngine(const SpectrumEngine&) = delete;
+        SpectrumEngine& operator=(const SpectrumEngine&) = delete;
+
+        // Only to be called from the receiver thread. The first fftSize
+        // samples are kept, and only while the spectra are being read.
+        void feedNullSymbol(const std::vector<DSPCOMPLEX>& nullSymbol);
+
+        // Can be called from any thread. Returns fftSize values in dB,
+        // or an empty vector if no spectrum is available yet. Waits up to
+        // maxWait for the first spectrum when there is none, which is
+        // the case on the first read after a pause.
+        std::vector<float> read(Source source,
+                std::chrono::milliseconds maxWait =
+                    std::chrono::milliseconds(0)) const;
+
+    private:
+        void workerthread(void);
+        bool isActive(void) const;
+        const std::vector<float>& result(Source source) const;
+        std::vector<float> transform(std::vector<float>& power,
+                const DSPCOMPLEX *samples);
+
+        const SpectrumSnapshot& snapshot;
+        const size_t fftSize;
+        const std::chrono::milliseconds interval;
+
+        // Only used by the worker thread
+        fft::Forward fft;
+
+        // Time of the last read(), zero if there was none yet
+        mutable std::atomic<std::chrono::steady_clock::rep> lastRead =
+            ATOMIC_VAR_INIT(0);
+
+        std::mutex nullMutex;
+        std::vector<DSPCOMPLEX> pendingNull;
+
+        mutable std::mutex mutex;
+        mutable std::condition_variable wakeup;
+        mutable std::condition_variable updated;
+        bool running = true;
+        std::vector<float> signalDB;
+        std::vector<float> nullDB;
+
+        std::thread thread;
+};
+
+#endif
@@ -0,0 +1,103 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include "spectrum-snapshot.h"
+
+// Give up after this many reads that overlapped with an update
+static const int MAX_READ_ATTEMPTS = 4;
+
+SpectrumSnapshot::SpectrumSnapshot(size_t blockLength, int updatesPerSecond) :
+    blockLength(blockLength),
+    interval(std::max(blockLength, (size_t)(INPUT_RATE / updatesPerSecond))),
+    staging(blockLength),
+    block(blockLength)
+{
+}
+
+void SpectrumSnapshot::feed(const DSPCOMPLEX *samples, size_t n)
+{
+    while (n > 0) {
+        if (samplesToSkip >= n) {
+            samplesToSkip -= n;
+            return;
+        }
+
+        samples += samplesToSkip;
+        n -= samplesToSkip;
+        samplesToSkip = 0;
+
+        const size_t num = std::min(n, blockLength - stagingFill);
+        std::copy(samples, samples + num, staging.begin() + stagingFill);
+        stagingFill += num;
+        samples += num;
+        n -= num;
+
+        if (stagingFill == blockLength) {
+            publish();
+            stagingFill = 0;
+            samplesToSkip = interval - blockLength;
+        }
+    }
+}
+
+void SpectrumSnapshot::publish()
+{
+    const uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    memcpy((void*)block.data(), staging.data(), blockLength * sizeof(DSPCOMPLEX));
+
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+std::vector<DSPCOMPLEX> SpectrumSnapshot::read(size_t size) const
+{
+    std::vector<DSPCOMPLEX> samples(std::min(size, blockLength));
+
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+        const uint32_t seq_before = sequence.load(std::memory_order_acquire);
+        if (seq_before == 0) {
+            break;
+        }
+
+        if (seq_before % 2 == 1) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        memcpy((void*)samples.data(), block.data(), samples.size() * sizeof(DSPCOMPLEX));
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (sequence.load(std::memory_order_relaxed) == seq_before) {
+            return samples;
+        }
+    }
+
+    return {};
+}
@@ -0,0 +1,72 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef SPECTRUM_SNAPSHOT_H
+#define SPECTRUM_SNAPSHOT_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "dab-constants.h"
+
+/* Keeps the latest block of input samples for the spectrum displays of
+ * the GUI and the web interface.
+ *
+ * The receiver thread feeds all samples it reads, but only copies one
+ * block of blockLength contiguous samples at most updatesPerSecond times
+ * per second. The block is published under a sequence lock, so readers
+ * in other threads never block the receiver: a reader that overlaps
+ * with an update simply retries. */
+class SpectrumSnapshot {
+    public:
+        SpectrumSnapshot(size_t blockLength, int updatesPerSecond);
+        SpectrumSnapshot(const SpectrumSnapshot&) = delete;
+        SpectrumSnapshot& operator=(const SpectrumSnapshot&) = delete;
+
+        // Only to be called from the receiver thread
+        void feed(const DSPCOMPLEX *samples, size_t n);
+
+        // Can be called from any thread. Returns at most size samples of
+        // the latest block, or an empty vector if no block is available.
+        std::vector<DSPCOMPLEX> read(size_t size) const;
+
+    private:
+        void publish(void);
+
+        const size_t blockLength;
+        const size_t interval;
+
+        // Receiver thread state
+        std::vector<DSPCOMPLEX> staging;
+        size_t stagingFill = 0;
+        size_t samplesToSkip = 0;
+
+        // Odd while the block is being written, zero until the first
+        // block was published.
+        std::atomic<uint32_t> sequence = ATOMIC_VAR_INIT(0);
+        std::vector<DSPCOMPLEX> block;
+};
+
+#endif
@@ -98,27 +98,46 @@ static const int tii_pattern[70][8] = { // {{{
     {1,1,1,0,1,0,0,0},
     {1,1,1,1,0,0,0,0} }; // }}}
 
-bool operator==(const CombPattern& lhs, const CombPattern& rhs)
-{
-    return lhs.comb == rhs.comb and lhs.pattern == rhs.pattern;
-}
+// Carriers in one block of 384 carriers, and pairs of carriers in a block
+static const int CARRIERS_PER_BLOCK = 384;
+static const int PAIRS_PER_BLOCK = CARRIERS_PER_BLOCK / 2;
+static const int NUM_COMBS = 24;
+static const int NUM_PATTERNS = 70;
+
+// The pair correlations are averaged over this many frames
+static const float AVERAGING_FRAMES = 8.0f;
+
+// A pair is on when the magnitude of its correlation, summed over the
+// blocks, exceeds this fraction of the summed PRS power. This corresponds
+// to 0.4 times the PRS power of a single block in mode I.
+static const float PAIR_THRESHOLD = 0.1f;
+
+// Range of delays in samples tried by analyse_phase()
+static const int MIN_DELAY = -4;
+static const int MAX_DELAY = 500;
 
-std::vector<carrier_t> CombPattern::generateCarriers() const
+// Number of frames over which the phase errors are summed before a
+// measurement is sent
+static const size_t PHASE_MEASUREMENTS = 5;
+
+std::vector<carrier_t> CombPattern::generateCarriers(int K) const
 {
     std::vector<carrier_t> carriers;
     carriers.reserve(32);
 
-    for (carrier_t k = 0; k < 384; k++) {
+    const int num_blocks = K / CARRIERS_PER_BLOCK;
+
+    for (int block = 0; block < num_blocks; block++) {
         for (int b = 0; b < 8; b++) {
-            if (k == 1 + 2*comb + 48*b and tii_pattern[pattern][b]) {
-                carriers.push_back(k - 769);
-                carriers.push_back(k - 769 + 1);
-                carriers.push_back(k - 385);
-                carriers.push_back(k - 385 + 1);
-                carriers.push_back(k);
-                carriers.push_back(k + 1);
-                carriers.push_back(k + 384);
-                carriers.push_back(k + 384 + 1);
+            if (tii_pattern[pattern][b]) {
+                for (int o = 0; o < 2; o++) {
+                    carrier_t k = -K/2 + block * CARRIERS_PER_BLOCK + 2*comb + 48*b + o;
+                    // The carrier 0 is not used
+                    if (k >= 0) {
+                        k++;
+                    }
+                    carriers.push_back(k);
+                }
             }
         }
     }
@@ -134,29 +153,55 @@ float tii_measurement_t::getDelayKm(void) const
     return delay_samples * km_per_sample;
 }
 
-TIIDecoder::TIIDecoder(const DABParams& params, RadioControllerInterface& ri) :
+TIIDecoder::TIIDecoder(const DABParams& params, RadioControllerInterface& ri,
+        CIRAnalyser& cirAnalyser) :
     m_radioInterface(ri),
+    m_cirAnalyser(cirAnalyser),
     m_params(params),
     m_fft_null(params.T_u),
     m_fft_prs(params.T_u)
 {
-    if (m_params.dabMode != 1) {
-        clog << "TII decoder does not support mode " << m_params.dabMode << endl;
+    m_num_blocks = m_params.K / CARRIERS_PER_BLOCK;
+
+    if (m_num_blocks == 0) {
+        clog << "TII decoder does not support mode " << (int)m_params.dabMode << endl;
         return;
     }
 
-    for (int c = 0; c < 24; c++) {
-        for (int p = 0; p < 70; p++) {
-            for (carrier_t k = 0; k < 384; k++) {
-                for (int b = 0; b < 8; b++) {
-                    if (k == 1 + 2*c + 48*b and tii_pattern[p][b]) {
-                        m_cp_per_carrier[k].emplace(c, p);
-                    }
+    const size_t num_pairs = m_num_blocks * PAIRS_PER_BLOCK;
+    m_pair_first_ix.resize(num_pairs);
+    m_pair_second_ix.resize(num_pairs);
+    for (int block = 0; block < m_num_blocks; block++) {
+        for (int i = 0; i < PAIRS_PER_BLOCK; i++) {
+            m_pair_first_ix[block * PAIRS_PER_BLOCK + i] = k_to_ix(block_carrier(block, 2*i));
+            m_pair_second_ix[block * PAIRS_PER_BLOCK + i] = k_to_ix(block_carrier(block, 2*i + 1));
+        }
+    }
+
+    m_first_re.resize(num_pairs);
+    m_first_im.resize(num_pairs);
+    m_second_re.resize(num_pairs);
+    m_second_im.resize(num_pairs);
+
+    m_pair_correlation.resize(PAIRS_PER_BLOCK);
+    m_prs_power.resize(PAIRS_PER_BLOCK);
+
+    // The pair with offset 2*c + 48*b in the block has index 24*b + c
+    m_candidate_pairs.resize(NUM_COMBS * NUM_PATTERNS);
+    for (int c = 0; c < NUM_COMBS; c++) {
+        for (int p = 0; p < NUM_PATTERNS; p++) {
+            auto& pairs = m_candidate_pairs[c * NUM_PATTERNS + p];
+            size_t n = 0;
+            for (int b = 0; b < 8; b++) {
+                if (tii_pattern[p][b]) {
+                    pairs.at(n++) = NUM_COMBS * b + c;
                 }
             }
         }
     }
 
+    m_error_per_correction.resize(NUM_COMBS * NUM_PATTERNS);
+
     m_thread = thread(&TIIDecoder::run, this);
 }
 
@@ -172,20 +217,54 @@ TIIDecoder::~TIIDecoder()
     }
 }
 
+carrier_t TIIDecoder::block_carrier(int block, int offset) const
+{
+    carrier_t k = -m_params.K/2 + block * CARRIERS_PER_BLOCK + offset;
+    // The carrier 0 is not used
+    if (k >= 0) {
+        k++;
+    }
+    return k;
+}
+
+int TIIDecoder::k_to_ix(carrier_t k) const
+{
+    if (k < 0)
+        return m_params.T_u + k;
+    else
+        return k;
+}
+
 void TIIDecoder::pushSymbols(
         const std::vector<complexf>& null,
         const std::vector<complexf>& prs)
 {
     unique_lock<mutex> lock(m_state_mutex);
-    if (m_state == State::Idle) {
-        m_prs = prs;
-        m_null = null;
-        m_state = State::NullPrsReady;
+    if (m_state == State::Abort or m_num_blocks == 0) {
+        return;
     }
+
+    // The worker takes the symbols over as soon as it wakes up, so that
+    // all frames are processed unless the worker falls behind by more
+    // than a frame.
+    m_pending_prs = prs;
+    m_pending_null = null;
+    m_state = State::NullPrsReady;
     lock.unlock();
     m_state_changed.notify_all();
 }
 
+void TIIDecoder::reset()
+{
+    lock_guard<mutex> lock(m_state_mutex);
+    if (m_state == State::NullPrsReady) {
+        m_state = State::Idle;
+    }
+
+    // The averages belong to the worker thread, which clears them
+    m_reset_requested = true;
+}
+
 void TIIDecoder::run()
 {
     const size_t spacing = m_params.T_u;
@@ -202,15 +281,26 @@ void TIIDecoder::run()
             break;
         }
 
+        m_null.swap(m_pending_null);
+        m_prs.swap(m_pending_prs);
+        m_state = State::Idle;
+        const bool reset_requested = m_reset_requested;
+        m_reset_requested = false;
         lock.unlock();
-        // We are in NullPrsReady state, and the state will not change now
+
+        if (reset_requested) {
+            m_averages_valid = false;
+            for (auto& meas : m_error_per_correction) {
+                meas = cp_error_measurement_t();
+            }
+        }
 
         // Take the NULL symbol from that frame, but skip the cyclic prefix and
         // truncate
         size_t null_skip = nullsize - spacing;
 
         if (m_null.size() != nullsize) {
-            throw out_of_range("NULL length: " + to_string(m_prs.size()) +
+            throw out_of_range("NULL length: " + to_string(m_null.size()) +
                     " vs " + to_string(nullsize));
         }
         copy(m_null.begin() + null_skip, m_null.begin() + null_skip + spacing,
@@ -225,160 +315,160 @@ void TIIDecoder::run()
         copy(m_prs.begin(), m_prs.begin() + spacing, m_fft_prs.getVector());
         m_fft_prs.do_FFT();
 
-        /* In TM1, the carriers repeat four times:
-         * [-768, -384[
-         * [-384, 0[
-         * ]0, 384]
-         * ]384, 768]
-         * A consequence of the fact that the 0 bin is never used is that the
-         * first carrier of each pair is even for negative k, odd for positive k
-         *
-         * We multiply the first carrier of the pair with the conjugate of the second
-         * carrier in the pair. As they have the same phase, this will make them
-         * correlate, whereas noise will not correlate. Also, we accumulate the
-         * measurements over the four blocks.
-         */
-        vector<complexf> blocks_multiplied(192);
-        vector<float> prs_power_sq(192);
-
-        /* Equivalent numpy code
-        blocks = [null_fft[-768:-384], null_fft[-384:], null_fft[1:385], null_fft[385:769]]
-        blocks_multiplied = np.zeros(384//2, dtype=np.complex128)
-        for block in blocks:
-            even_odd = block.reshape(-1, 2)
-            b = even_odd[...,0] * np.conj(even_odd[...,1])
-            blocks_multiplied += b
-        */
+        correlate_pairs();
 
-        for (size_t i = 0; i < 192; i++) {
-            const complexf *p = m_fft_prs.getVector();
-            prs_power_sq[i] = norm(p[1 + 2*i]);
+        // Which pairs are on
+        array<bool, PAIRS_PER_BLOCK> pair_on;
+        for (int i = 0; i < PAIRS_PER_BLOCK; i++) {
+            pair_on[i] = abs(m_pair_correlation[i]) > m_prs_power[i] * PAIR_THRESHOLD;
         }
 
-        const size_t k_start[] = {2048 - 768, 2048 - 384, 1, 385};
-        const complexf *n = m_fft_null.getVector();
-        for (size_t k : k_start) {
-            for (size_t i = 0; i < 192; i++) {
-                // The two consecutive carriers should have the
-                // same phase. By multiplying with the conjugate,
-                // we should get a value with low imaginary component.
-                // In terms of units, this resembles a norm.
-                blocks_multiplied[i] += n[k+2*i] * conj(n[k+2*i+1]);
+        // A candidate is likely when all its four pairs are on
+        vector<int> likely_candidates;
+        for (size_t cp = 0; cp < m_candidate_pairs.size(); cp++) {
+            const auto& pairs = m_candidate_pairs[cp];
+            if (pair_on[pairs[0]] and pair_on[pairs[1]] and
+                    pair_on[pairs[2]] and pair_on[pairs[3]]) {
+                likely_candidates.push_back(cp);
             }
         }
 
-        auto ix_to_k = [](int ix) -> carrier_t {
-            if (ix <= 1024)
-                return ix;
-            else
-                return ix - 2048; };
-
-        const float threshold_factor = 0.4f;
-
-        vector<carrier_t> carriers;
-        for (size_t i = 0; i < 192; i++) {
-            const float threshold = prs_power_sq[i] * threshold_factor;
-            if (abs(blocks_multiplied[i]) > threshold) {
-                // Convert back from "pair index" to k
-                const carrier_t k = ix_to_k(i*2 + 1);
-                carriers.push_back(k);
+        // Sometimes the number of likely CPs is huge because
+        // the threshold is wrong. Skip these cases.
+        if (likely_candidates.size() < 10) {
+            for (const int cp : likely_candidates) {
+                analyse_phase(cp);
             }
         }
+    }
+}
 
-        unordered_map<CombPattern, int> cp_count;
-        for (const carrier_t k : carriers) {
-            if (m_cp_per_carrier.count(k)) {
-                for (const auto& cps : m_cp_per_carrier[k]) {
-                    cp_count[cps]++;
-                }
-            }
-        }
+void TIIDecoder::correlate_pairs()
+{
+    const complexf *n = m_fft_null.getVector();
+    const complexf *p = m_fft_prs.getVector();
+    const size_t num_pairs = m_pair_first_ix.size();
 
-        size_t num_likely_cps = 0;
-        for (const auto& cp : cp_count) {
-            if (cp.second >= 4) {
-                num_likely_cps++;
-            }
+    for (size_t j = 0; j < num_pairs; j++) {
+        m_first_re[j] = n[m_pair_first_ix[j]].real();
+        m_first_im[j] = n[m_pair_first_ix[j]].imag();
+        m_second_re[j] = n[m_pair_second_ix[j]].real();
+        m_second_im[j] = n[m_pair_second_ix[j]].imag();
+    }
+
+    /* The two carriers of a pair should have the same phase. By
+     * multiplying the first carrier with the conjugate of the second,
+     * they correlate, whereas noise does not correlate. We accumulate
+     * the products over the blocks.
+     *
+     * Equivalent numpy code for mode I
+        blocks = [null_fft[-768:-384], null_fft[-384:], null_fft[1:385], null_fft[385:769]]
+        blocks_multiplied = np.zeros(384//2, dtype=np.complex128)
+        for block in blocks:
+            even_odd = block.reshape(-1, 2)
+            b = even_odd[...,0] * np.conj(even_odd[...,1])
+            blocks_multiplied += b
+     */
+    array<float, PAIRS_PER_BLOCK> corr_re = {};
+    array<float, PAIRS_PER_BLOCK> corr_im = {};
+    for (int block = 0; block < m_num_blocks; block++) {
+        const float *a_re = m_first_re.data() + block * PAIRS_PER_BLOCK;
+        const float *a_im = m_first_im.data() + block * PAIRS_PER_BLOCK;
+        const float *b_re = m_second_re.data() + block * PAIRS_PER_BLOCK;
+        const float *b_im = m_second_im.data() + block * PAIRS_PER_BLOCK;
+        for (int i = 0; i < PAIRS_PER_BLOCK; i++) {
+            corr_re[i] += a_re[i] * b_re[i] + a_im[i] * b_im[i];
+            corr_im[i] += a_im[i] * b_re[i] - a_re[i] * b_im[i];
         }
+    }
 
-        // Sometimes the number of likely CPs is huge because
-        // the threshold is wrong. Skip these cases.
-        if (num_likely_cps < 10) {
-            for (const auto& cp : cp_count) {
-                if (cp.second >= 4) {
-                    analyse_phase(cp.first);
-                }
-            }
+    array<float, PAIRS_PER_BLOCK> prs_power = {};
+    for (int block = 0; block < m_num_blocks; block++) {
+        for (int i = 0; i < PAIRS_PER_BLOCK; i++) {
+            prs_power[i] += norm(p[m_pair_first_ix[block * PAIRS_PER_BLOCK + i]]);
         }
+    }
 
-        lock.lock();
-        m_state = State::Idle;
-        lock.unlock();
+    if (not m_averages_valid) {
+        for (int i = 0; i < PAIRS_PER_BLOCK; i++) {
+            m_pair_correlation[i] = complexf(corr_re[i], corr_im[i]);
+            m_prs_power[i] = prs_power[i];
+        }
+        m_averages_valid = true;
+    }
+    else {
+        const float alpha = 1.0f / AVERAGING_FRAMES;
+        for (int i = 0; i < PAIRS_PER_BLOCK; i++) {
+            m_pair_correlation[i] += alpha *
+                (complexf(corr_re[i], corr_im[i]) - m_pair_correlation[i]);
+            m_prs_power[i] += alpha * (prs_power[i] - m_prs_power[i]);
+        }
     }
 }
 
-void TIIDecoder::analyse_phase(const CombPattern& cp)
+void TIIDecoder::analyse_phase(int candidate)
 {
-    const auto carriers = cp.generateCarriers();
+    const CombPattern cp(candidate / NUM_PATTERNS, candidate % NUM_PATTERNS);
+    const auto carriers = cp.generateCarriers(m_params.K);
 
     const complexf *n = m_fft_null.getVector();
     const complexf *p = m_fft_prs.getVector();
 
-    auto k_to_ix = [](carrier_t k) -> int {
-        if (k < 0)
-            return 2048 + k;
-        else
-            return k; };
-
     // Both TII carriers take the phase from the first PRS frequency of the pair.
-    // This assumes carriers is sorted.
-    vector<float> phases_prs(carriers.size());
+    // This assumes carriers is sorted. The phase difference is taken as the
+    // argument of the product with the conjugate, which keeps it in [-pi, pi].
+    vector<complexf> prs_conj(carriers.size());
 
     for (size_t i = 0; i < carriers.size(); i += 2) {
         const int ix = k_to_ix(carriers[i]);
 
-        phases_prs[i] = arg(p[ix]);
-        phases_prs[i+1] = arg(p[ix]);
+        prs_conj[i] = conj(p[ix]);
+        prs_conj[i+1] = conj(p[ix]);
+    }
+
+    // The rotation for a delay is obtained from the one of the previous
+    // delay, instead of calling polar() for every delay and carrier.
+    constexpr float pi = M_PI;
+    vector<complexf> rotators(carriers.size());
+    vector<complexf> steps(carriers.size());
+    for (size_t j = 0; j < carriers.size(); j++) {
+        const int ix = k_to_ix(carriers[j]);
+        rotators[j] = n[ix] * polar(1.0f, 2.0f * pi * MIN_DELAY * carriers[j] / m_params.T_u);
+        steps[j] = polar(1.0f, 2.0f * pi * carriers[j] / m_params.T_u);
     }
 
-    auto& meas = m_error_per_correction[cp];
+    auto& meas = m_error_per_correction[candidate];
+    meas.error_per_correction.resize(MAX_DELAY - MIN_DELAY, 0.0f);
 
-    for (int err = -4; err < 500; err++) {
+    for (int err = MIN_DELAY; err < MAX_DELAY; err++) {
         float abs_err = 0;
 
         for (size_t j = 0; j < carriers.size(); j++) {
-            const int ix = k_to_ix(carriers[j]);
-            constexpr float pi = M_PI;
-            complexf rotator = polar(1.0f, 2.0f * pi * err * carriers[j] / 2048.0f);
-            float delta = arg(n[ix] * rotator) - phases_prs[j];
+            float delta = arg(rotators[j] * prs_conj[j]);
             abs_err += abs(delta);
+            rotators[j] *= steps[j];
         }
-        meas.error_per_correction[err] += abs_err;
+        meas.error_per_correction[err - MIN_DELAY] += abs_err;
     }
 
     meas.num_measurements++;
 
-    if (meas.num_measurements >= 5) {
+    if (meas.num_measurements >= PHASE_MEASUREMENTS) {
         auto best = min_element(
                 meas.error_per_correction.begin(),
-                meas.error_per_correction.end(),
-                [](const pair<float, int>& lhs,
-                    const pair<float, int>& rhs) {
-                return lhs.second < rhs.second;
-                });
-
-        if (best != meas.error_per_correction.end()) {
-            tii_measurement_t m;
-            m.error = best->second;
-            m.delay_samples = best->first;
-            m.comb = cp.comb;
-            m.pattern = cp.pattern;
-
-            m_radioInterface.onTIIMeasurement(move(m));
-        }
+                meas.error_per_correction.end());
+
+        tii_measurement_t m;
+        m.error = *best;
+        m.delay_samples = MIN_DELAY + (best - meas.error_per_correction.begin());
+        m.comb = cp.comb;
+        m.pattern = cp.pattern;
 
-        meas.error_per_correction.clear();
+        m_cirAnalyser.associate(m);
+        m_radioInterface.onTIIMeasurement(move(m));
+
+        fill(meas.error_per_correction.begin(),
+                meas.error_per_correction.end(), 0.0f);
         meas.num_measurements = 0;
     }
 }
-
@@ -18,10 +18,10 @@
  *    along with welle.io; if not, write to the Free Software
  *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include "dab-constants.h"
-#include <unordered_map>
-#include <unordered_set>
 #include <list>
 #include <vector>
 #include <mutex>
@@ -30,6 +30,7 @@
 #include <complex>
 #include "fft.h"
 #include "radio-controller.h"
+#include "cir-analyser.h"
 
 using complexf = std::complex<float>;
 
@@ -44,26 +45,25 @@ struct CombPattern {
     int comb = 0; // From 0 to 24
     int pattern = 0; // From 0 to 70
 
-    std::vector<carrier_t> generateCarriers(void) const;
+    // The TII carriers for a transmission mode with K carriers, sorted
+    std::vector<carrier_t> generateCarriers(int K) const;
 };
 
-// Make CombPattern satisfy Hash and Compare
-bool operator==(const CombPattern& lhs, const CombPattern& rhs);
-
-namespace std {
-    template<> struct hash<CombPattern> {
-        typedef CombPattern argument_type;
-        typedef std::size_t result_type;
-        result_type operator()(argument_type const& cp) const noexcept
-        {
-            return cp.comb * 100 + cp.pattern;
-        }
-    };
-}
-
+/* Identifies the transmitters from the carrier pairs they switch on in
+ * the NULL symbol, see EN 300 401 Clause 14.8.
+ *
+ * The TII carriers are grouped in blocks of 384 carriers, which repeat
+ * K/384 times over the ensemble: four times in mode I, twice in mode IV
+ * and once in mode II. Mode III has no room for the TII patterns.
+ *
+ * Every NULL symbol is processed. The correlations of the two carriers
+ * of every pair, summed over the blocks, are averaged over several frames.
+ * All 1680 comb/pattern candidates are then scored from these 192 pair
+ * correlations, through a table of the four pairs of every candidate. */
 class TIIDecoder {
     public:
-        TIIDecoder(const DABParams& params, RadioControllerInterface& ri);
+        TIIDecoder(const DABParams& params, RadioControllerInterface& ri,
+                CIRAnalyser& cirAnalyser);
         ~TIIDecoder();
         TIIDecoder(const TIIDecoder& other) = delete;
         TIIDecoder& operator=(const TIIDecoder& other) = delete;
@@ -72,35 +72,65 @@ class TIIDecoder {
                 const std::vector<complexf>& null,
                 const std::vector<complexf>& prs);
 
+        // Forget the averages and the phase error sums, e.g. after a
+        // retune. Takes effect from the next pushed NULL symbol on.
+        void reset(void);
+
     private:
         void run(void);
-        void analyse_phase(const CombPattern& cp);
+        void correlate_pairs(void);
+        void analyse_phase(int candidate);
+        carrier_t block_carrier(int block, int offset) const;
+        int k_to_ix(carrier_t k) const;
 
         RadioControllerInterface& m_radioInterface;
+        CIRAnalyser& m_cirAnalyser;
         const DABParams& m_params;
 
+        // Filled by pushSymbols(), taken over by the worker thread
+        std::vector<complexf> m_pending_null;
+        std::vector<complexf> m_pending_prs;
+
         std::vector<complexf> m_null;
         std::vector<complexf> m_prs;
 
-        std::unordered_map<carrier_t, std::unordered_set<CombPattern> >
-            m_cp_per_carrier;
-
         enum class State { Idle, NullPrsReady, Abort };
 
         std::thread m_thread;
         std::mutex m_state_mutex;
         std::condition_variable m_state_changed;
         State m_state = State::Idle;
+        bool m_reset_requested = false;
 
         fft::Forward m_fft_null;
         fft::Forward m_fft_prs;
 
+        int m_num_blocks = 0;
+
+        // FFT bins of the first and second carriers of every pair, for
+        // all blocks one after the other.
+        std::vector<int> m_pair_first_ix;
+        std::vector<int> m_pair_second_ix;
+
+        // Carriers of the pairs gathered from the NULL symbol, split in
+        // real and imaginary parts so that the products vectorise
+        std::vector<float> m_first_re, m_first_im;
+        std::vector<float> m_second_re, m_second_im;
+
+        // Averaged over frames, one value per pair of a block
+        std::vector<complexf> m_pair_correlation;
+        std::vector<float> m_prs_power;
+        bool m_averages_valid = false;
+
+        // For every candidate comb * 70 + pattern, the four pairs it uses
+        std::vector<std::array<uint8_t, 4> > m_candidate_pairs;
+
         struct cp_error_measurement_t {
-            std::unordered_map<float, uint64_t> error_per_correction;
+            // Sum of the phase errors for every delay from
+            // MIN_DELAY to MAX_DELAY, empty until the first measurement
+            std::vector<float> error_per_correction;
             size_t num_measurements = 0;
         };
 
-        std::unordered_map<CombPattern,
-            cp_error_measurement_t> m_error_per_correction;
+        std::vector<cp_error_measurement_t> m_error_per_correction;
 };
-
@@ -47,8 +47,7 @@ static const int EXTIO_BASE_TYPE_SIZE = sizeof(float);
 
 CAirspy::CAirspy(RadioControllerInterface &radioController) :
     radioController(radioController),
-    SampleBuffer(256 * 1024),
-    SpectrumSampleBuffer(8192)
+    SampleBuffer(256 * 1024)
 {
     std::clog << "Airspy: " << "Open airspy" << std::endl;
 
@@ -126,7 +125,7 @@ bool CAirspy::restart(void)
         return true;
 
     SampleBuffer.FlushRingBuffer();
-    SpectrumSampleBuffer.FlushRingBuffer();
+    decimator.reset();
     result = airspy_set_sample_type(device, AIRSPY_SAMPLE_FLOAT32_IQ);
     if (result != AIRSPY_SUCCESS) {
         std::clog  << "Airspy: airspy_set_sample_type () failed: " << airspy_error_name((airspy_error)result) << "(" << result << ")" << std::endl;
@@ -187,28 +186,16 @@ int CAirspy::callback(airspy_transfer* transfer)
 // The AirSpy runs at 4096ksps, we need to decimate by two.
 int CAirspy::data_available(const DSPCOMPLEX* buf, size_t num_samples)
 {
-    if (num_samples % 2 != 0) {
-        throw std::runtime_error("CAirspy::data_available() needs an even number of IQ samples to be able to decimate");
-    }
-
-    const DSPCOMPLEX* sbuf = reinterpret_cast<const DSPCOMPLEX*>(buf);
-
-    std::vector<DSPCOMPLEX> temp(num_samples/2);
+    const auto& decimated = decimator.decimate(buf, num_samples);
 
-    float maxnorm = 0;
-
-    for (size_t i = 0; i < num_samples/2; i++) {
-        const auto z = 0.5f * (sbuf[2*i] + sbuf[2*i+1]);
-        temp[i] = z;
-
-        if (sw_agc and (num_frames % 10) == 0) {
+    if (sw_agc and (num_frames % 10) == 0) {
+        float maxnorm = 0;
+        for (const auto& z : decimated) {
             if (norm(z) > maxnorm) {
                 maxnorm = norm(z);
             }
         }
-    }
 
-    if (sw_agc and (num_frames % 10) == 0) {
         const float maxampl = sqrt(maxnorm);
         //  std::clog  << "Airspy: maxampl: " << maxampl << std::endl;
 
@@ -228,8 +215,7 @@ int CAirspy::data_available(const DSPCOMPLEX* buf, size_t num_samples)
 
     num_frames++;
 
-    SampleBuffer.putDataIntoBuffer(temp.data(), num_samples/2);
-    SpectrumSampleBuffer.putDataIntoBuffer(temp.data(), num_samples/2);
+    SampleBuffer.putDataIntoBuffer(decimated.data(), decimated.size());
 
     return 0;
 }
@@ -237,7 +223,6 @@ int CAirspy::data_available(const DSPCOMPLEX* buf, size_t num_samples)
 void CAirspy::reset(void)
 {
     SampleBuffer.FlushRingBuffer();
-    SpectrumSampleBuffer.FlushRingBuffer();
 }
 
 int32_t CAirspy::getSamples(DSPCOMPLEX* Buffer, int32_t Size)
@@ -245,16 +230,6 @@ int32_t CAirspy::getSamples(DSPCOMPLEX* Buffer, int32_t Size)
     return SampleBuffer.getDataFromBuffer(Buffer, Size);
 }
 
-std::vector<DSPCOMPLEX> CAirspy::getSpectrumSamples(int size)
-{
-    std::vector<DSPCOMPLEX> buf(size);
-    int sizeRead = SpectrumSampleBuffer.getDataFromBuffer(buf.data(), size);
-    if (sizeRead < size) {
-        buf.resize(sizeRead);
-    }
-    return buf;
-}
-
 int32_t CAirspy::getSamplesToRead(void)
 {
     return SampleBuffer.GetRingBufferReadAvailable();
@@ -38,6 +38,7 @@
 #include "dab-constants.h"
 #include "MathHelper.h"
 #include "ringbuffer.h"
+#include "halfband_decimator.h"
 
 #include <vector>
 
@@ -65,7 +66,6 @@ public:
     void stop(void);
     void reset(void);
     int32_t getSamples(DSPCOMPLEX* Buffer, int32_t Size);
-    std::vector<DSPCOMPLEX> getSpectrumSamples(int size);
     int32_t getSamplesToRead(void);
     float getGain(void) const;
     float setGain(int gain);
@@ -91,7 +91,7 @@ private:
     bool sw_agc = false;
     int currentLinearityGain = 10;
     RingBuffer<DSPCOMPLEX> SampleBuffer;
-    RingBuffer<DSPCOMPLEX> SpectrumSampleBuffer;
+    CHalfBandDecimator decimator;
     struct airspy_device *device;
 
     static int callback(airspy_transfer_t*);
@@ -0,0 +1,391 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include "channeliser.h"
+#include "dab-constants.h"
+
+using namespace std;
+
+// Half of the bandwidth of a DAB ensemble
+static constexpr int HALF_DAB_BANDWIDTH = 768000;
+// The low-pass passes HALF_DAB_BANDWIDTH and stops at INPUT_RATE/2
+static constexpr int FILTER_CUTOFF = (HALF_DAB_BANDWIDTH + INPUT_RATE/2) / 2;
+static constexpr int FILTER_TRANSITION = INPUT_RATE/2 - HALF_DAB_BANDWIDTH;
+static constexpr double FILTER_ATTENUATION_DB = 60.0;
+
+// Number of output samples per channel for each block read from the device
+static constexpr size_t OUTPUT_SAMPLES_PER_BLOCK = 8192;
+
+static double bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+// Kaiser-windowed sinc low-pass, see Oppenheim & Schafer for the formulas
+static vector<float> design_lowpass(int sampleRate)
+{
+    const double A = FILTER_ATTENUATION_DB;
+    const double delta_w = 2.0 * M_PI * FILTER_TRANSITION / sampleRate;
+    const double beta = 0.1102 * (A - 8.7);
+    const size_t num_taps = (size_t)ceil((A - 8.0) / (2.285 * delta_w)) + 1;
+
+    const double wc = 2.0 * M_PI * FILTER_CUTOFF / sampleRate;
+    const double centre = (num_taps - 1) / 2.0;
+
+    vector<double> h(num_taps);
+    double sum = 0;
+    for (size_t n = 0; n < num_taps; n++) {
+        const double t = n - centre;
+        const double sinc = (t == 0) ? wc / M_PI : sin(wc * t) / (M_PI * t);
+        const double r = t / centre;
+        const double window = bessel_i0(beta * sqrt(1.0 - r * r)) / bessel_i0(beta);
+        h[n] = sinc * window;
+        sum += h[n];
+    }
+
+    // Unity gain at DC, reversed so that the filter becomes a dot product
+    // with the history, and padded with zeros at the front.
+    const size_t padded_taps = (num_taps + 7) / 8 * 8;
+    vector<float> taps(padded_taps, 0.0f);
+    for (size_t n = 0; n < num_taps; n++) {
+        taps[padded_taps - 1 - n] = h[n] / sum;
+    }
+    return taps;
+}
+
+CChannelisedInput::CChannelisedInput(CChanneliser& channeliser, int frequency) :
+    channeliser(channeliser),
+    m_frequency(frequency),
+    m_sampleBuffer(1024 * 1024)
+{
+}
+
+void CChannelisedInput::setFrequency(int frequency)
+{
+    if (channeliser.isInBand(frequency)) {
+        m_frequency = frequency;
+    }
+    else {
+        std::clog << "Channeliser: " << frequency / 1000.0 <<
+            " kHz is outside of the captured band" << std::endl;
+    }
+}
+
+int CChannelisedInput::getFrequency() const
+{
+    return m_frequency;
+}
+
+bool CChannelisedInput::restart()
+{
+    return channeliser.start();
+}
+
+bool CChannelisedInput::is_ok()
+{
+    return channeliser.is_ok();
+}
+
+void CChannelisedInput::stop()
+{
+    // The wideband device is shared with the other channels, it is
+    // stopped together with the CChanneliser.
+}
+
+void CChannelisedInput::reset()
+{
+    m_sampleBuffer.FlushRingBuffer();
+}
+
+int32_t CChannelisedInput::getSamples(DSPCOMPLEX *buffer, int32_t size)
+{
+    return m_sampleBuffer.getDataFromBuffer(buffer, size);
+}
+
+int32_t CChannelisedInput::getSamplesToRead()
+{
+    return m_sampleBuffer.GetRingBufferReadAvailable();
+}
+
+float CChannelisedInput::setGain(int gainIndex)
+{
+    return channeliser.getWidebandInput().setGain(gainIndex);
+}
+
+float CChannelisedInput::getGain() const
+{
+    return channeliser.getWidebandInput().getGain();
+}
+
+int CChannelisedInput::getGainCount()
+{
+    return channeliser.getWidebandInput().getGainCount();
+}
+
+void CChannelisedInput::setAgc(bool agc)
+{
+    channeliser.getWidebandInput().setAgc(agc);
+}
+
+std::string CChannelisedInput::getDescription()
+{
+    return "Channelised " + channeliser.getWidebandInput().getDescription();
+}
+
+CDeviceID CChannelisedInput::getID()
+{
+    return CDeviceID::CHANNELISER;
+}
+
+CChanneliser::CChanneliser(std::unique_ptr<CVirtualInput>&& wideband, int sampleRate) :
+    m_wideband(move(wideband)),
+    m_sampleRate(sampleRate),
+    m_decimation(sampleRate / INPUT_RATE)
+{
+    if (not m_wideband) {
+        throw invalid_argument("Channeliser: no wideband input");
+    }
+
+    if (sampleRate <= 0 or sampleRate % INPUT_RATE != 0) {
+        throw invalid_argument("Channeliser: sample rate " +
+                to_string(sampleRate) + " is not a multiple of " +
+                to_string(INPUT_RATE));
+    }
+
+    m_taps = design_lowpass(sampleRate);
+    std::clog << "Channeliser: decimation " << m_decimation << ", " <<
+        m_taps.size() << " taps" << std::endl;
+}
+
+CChanneliser::~CChanneliser()
+{
+    stop();
+}
+
+void CChanneliser::setCentreFrequency(int frequency)
+{
+    m_centreFrequency = frequency;
+    m_wideband->setFrequency(frequency);
+}
+
+int CChanneliser::getCentreFrequency() const
+{
+    return m_centreFrequency;
+}
+
+bool CChanneliser::isInBand(int frequency) const
+{
+    // Keep the transition band of the channel filter inside the band
+    return abs(frequency - m_centreFrequency) + INPUT_RATE/2 <= m_sampleRate/2;
+}
+
+int CChanneliser::getSampleRate() const
+{
+    return m_sampleRate;
+}
+
+CChannelisedInput& CChanneliser::addChannel(int frequency)
+{
+    lock_guard<mutex> lock(m_startMutex);
+
+    if (m_running) {
+        throw logic_error("Channeliser: cannot add channel while running");
+    }
+
+    if (not isInBand(frequency)) {
+        throw out_of_range("Channeliser: " + to_string(frequency) +
+                " Hz is outside of the captured band");
+    }
+
+    m_channels.emplace_back(*this, frequency);
+    return m_channels.back();
+}
+
+void CChanneliser::removeChannels()
+{
+    lock_guard<mutex> lock(m_startMutex);
+
+    if (m_running) {
+        throw logic_error("Channeliser: cannot remove channels while running");
+    }
+
+    m_channels.clear();
+}
+
+bool CChanneliser::start()
+{
+    lock_guard<mutex> lock(m_startMutex);
+
+    if (m_running) {
+        return true;
+    }
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    if (not m_wideband->restart()) {
+        return false;
+    }
+
+    for (auto& c : m_channels) {
+        c.m_sampleBuffer.FlushRingBuffer();
+    }
+
+    m_running = true;
+    m_thread = std::thread(&CChanneliser::workerthread, this);
+    return true;
+}
+
+void CChanneliser::stop()
+{
+    lock_guard<mutex> lock(m_startMutex);
+
+    m_running = false;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_wideband->stop();
+}
+
+bool CChanneliser::is_ok()
+{
+    return m_running;
+}
+
+CVirtualInput& CChanneliser::getWidebandInput()
+{
+    return *m_wideband;
+}
+
+void CChanneliser::workerthread()
+{
+    const size_t block_size = OUTPUT_SAMPLES_PER_BLOCK * m_decimation;
+    std::vector<DSPCOMPLEX> block(block_size);
+
+    while (m_running) {
+        if ((size_t)m_wideband->getSamplesToRead() < block_size) {
+            if (not m_wideband->is_ok()) {
+                std::clog << "Channeliser: wideband input failed" << std::endl;
+                m_running = false;
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        const int32_t n = m_wideband->getSamples(block.data(), block_size);
+
+        for (auto& c : m_channels) {
+            processChannel(c, block.data(), n);
+        }
+    }
+}
+
+void CChanneliser::processChannel(CChannelisedInput& c,
+        const DSPCOMPLEX *in, size_t n)
+{
+    const size_t num_taps = m_taps.size();
+    const size_t history_len = num_taps - 1;
+
+    if (c.m_historyI.empty()) {
+        c.m_historyI.assign(history_len, 0.0f);
+        c.m_historyQ.assign(history_len, 0.0f);
+        c.m_nextOutput = history_len;
+    }
+
+    const int offset = c.m_frequency - m_centreFrequency;
+    if (offset != c.m_mixerFrequency) {
+        c.m_mixerFrequency = offset;
+        c.m_phaseStep = polar(1.0, -2.0 * M_PI * offset / m_sampleRate);
+    }
+
+    // Mix the channel down to baseband, appending to the history. The
+    // I and Q parts are kept in separate arrays for the filter.
+    c.m_historyI.resize(history_len + n);
+    c.m_historyQ.resize(history_len + n);
+    float *hist_i = c.m_historyI.data() + history_len;
+    float *hist_q = c.m_historyQ.data() + history_len;
+
+    std::complex<double> phasor = c.m_phasor;
+    for (size_t i = 0; i < n; i++) {
+        const std::complex<double> z = std::complex<double>(in[i]) * phasor;
+        hist_i[i] = z.real();
+        hist_q[i] = z.imag();
+        phasor *= c.m_phaseStep;
+    }
+    // Keep the rounding errors from accumulating
+    c.m_phasor = phasor / abs(phasor);
+
+    // Only compute every m_decimation-th output
+    const size_t length = history_len + n;
+    const float *taps = m_taps.data();
+    c.m_output.clear();
+
+    for (; c.m_nextOutput < length; c.m_nextOutput += m_decimation) {
+        const float *x_i = c.m_historyI.data() + c.m_nextOutput - history_len;
+        const float *x_q = c.m_historyQ.data() + c.m_nextOutput - history_len;
+
+        // Eight partial sums allow the compiler to use SIMD
+        // without -ffast-math
+        float acc_i[8] = {};
+        float acc_q[8] = {};
+        for (size_t k = 0; k + 8 <= num_taps; k += 8) {
+            for (size_t j = 0; j < 8; j++) {
+                acc_i[j] += taps[k + j] * x_i[k + j];
+                acc_q[j] += taps[k + j] * x_q[k + j];
+            }
+        }
+
+        float sum_i = 0;
+        float sum_q = 0;
+        for (size_t j = 0; j < 8; j++) {
+            sum_i += acc_i[j];
+            sum_q += acc_q[j];
+        }
+        c.m_output.emplace_back(sum_i, sum_q);
+    }
+
+    // Keep the last history_len samples for the next block
+    memmove(c.m_historyI.data(), c.m_historyI.data() + n, history_len * sizeof(float));
+    memmove(c.m_historyQ.data(), c.m_historyQ.data() + n, history_len * sizeof(float));
+    c.m_historyI.resize(history_len);
+    c.m_historyQ.resize(history_len);
+    c.m_nextOutput -= n;
+
+    c.m_sampleBuffer.putDataIntoBuffer(c.m_output.data(), c.m_output.size());
+}
@@ -0,0 +1,147 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef CHANNELISER_H
+#define CHANNELISER_H
+
+#include <atomic>
+#include <complex>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "virtual_input.h"
+#include "ringbuffer.h"
+
+class CChanneliser;
+
+/* One INPUT_RATE channel cut out of the wideband stream by the
+ * CChanneliser. Towards the RadioReceiver it behaves like any other input
+ * device. It can only be tuned to frequencies inside the band captured
+ * by the wideband device, gain settings are forwarded to that device. */
+class CChannelisedInput : public CVirtualInput
+{
+public:
+    CChannelisedInput(CChanneliser& channeliser, int frequency);
+    CChannelisedInput(const CChannelisedInput&) = delete;
+    CChannelisedInput operator=(const CChannelisedInput&) = delete;
+
+    virtual void setFrequency(int frequency);
+    virtual int getFrequency(void) const;
+    virtual bool restart(void);
+    virtual bool is_ok(void);
+    virtual void stop(void);
+    virtual void reset(void);
+    virtual int32_t getSamples(DSPCOMPLEX* buffer, int32_t size);
+    virtual int32_t getSamplesToRead(void);
+    virtual float setGain(int gainIndex);
+    virtual float getGain(void) const;
+    virtual int getGainCount(void);
+    virtual void setAgc(bool agc);
+    virtual std::string getDescription(void);
+    virtual CDeviceID getID(void);
+
+private:
+    friend class CChanneliser;
+
+    CChanneliser& channeliser;
+    std::atomic<int> m_frequency;
+
+    RingBuffer<DSPCOMPLEX> m_sampleBuffer;
+
+    // State of the mixer and decimator, only used by the channeliser thread
+    int m_mixerFrequency = 0;
+    std::complex<double> m_phasor = 1.0;
+    std::complex<double> m_phaseStep = 1.0;
+    std::vector<float> m_historyI;
+    std::vector<float> m_historyQ;
+    size_t m_nextOutput = 0;
+    std::vector<DSPCOMPLEX> m_output;
+};
+
+/* Splits the stream of a wideband device running at an integer multiple
+ * of INPUT_RATE into several INPUT_RATE channels, so that adjacent
+ * ensembles can be received with a single device.
+ *
+ * DAB blocks are on a 1.712 MHz raster, which does not coincide with
+ * the bins of a uniform filter bank at INPUT_RATE. Every channel is
+ * therefore mixed to baseband on its own, and then filtered with a
+ * polyphase decimator that only computes the output samples that are
+ * kept. All channels share the same low-pass prototype. */
+class CChanneliser
+{
+public:
+    // wideband must deliver samples at sampleRate, which has to be an
+    // integer multiple of INPUT_RATE.
+    CChanneliser(std::unique_ptr<CVirtualInput>&& wideband, int sampleRate);
+    ~CChanneliser();
+    CChanneliser(const CChanneliser&) = delete;
+    CChanneliser operator=(const CChanneliser&) = delete;
+
+    // Tune the wideband device. All channels must stay inside the band.
+    void setCentreFrequency(int frequency);
+    int getCentreFrequency(void) const;
+
+    // Add a channel, must be called before start(). Throws
+    // std::out_of_range if the frequency is outside the captured band.
+    CChannelisedInput& addChannel(int frequency);
+
+    // Remove all channels, must be called before start(). The references
+    // returned by addChannel() become invalid.
+    void removeChannels(void);
+
+    // Whether a channel at this frequency fits into the captured band
+    bool isInBand(int frequency) const;
+
+    int getSampleRate(void) const;
+
+    bool start(void);
+    void stop(void);
+    bool is_ok(void);
+
+    CVirtualInput& getWidebandInput(void);
+
+private:
+    void workerthread(void);
+    void processChannel(CChannelisedInput& channel,
+            const DSPCOMPLEX *in, size_t n);
+
+    std::unique_ptr<CVirtualInput> m_wideband;
+    const int m_sampleRate;
+    const int m_decimation;
+    std::atomic<int> m_centreFrequency = ATOMIC_VAR_INIT(0);
+
+    // Low-pass prototype, reversed and zero-padded to a multiple of
+    // eight taps so that the dot product vectorises.
+    std::vector<float> m_taps;
+
+    std::mutex m_startMutex;
+    std::list<CChannelisedInput> m_channels;
+    std::atomic<bool> m_running = ATOMIC_VAR_INIT(false);
+    std::thread m_thread;
+};
+
+#endif // CHANNELISER_H
@@ -0,0 +1,148 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "halfband_decimator.h"
+
+constexpr size_t CHalfBandDecimator::HALFBAND_FOLDED_TAPS;
+constexpr size_t CHalfBandDecimator::EVEN_HISTORY;
+constexpr size_t CHalfBandDecimator::ODD_HISTORY;
+
+// Kaiser window parameter. With 39 taps, this gives less than 0.01 dB
+// ripple up to 768 kHz and 70 dB attenuation from 1.28 MHz, the lowest
+// frequency that aliases onto the DAB signal after decimation.
+static constexpr double KAISER_BETA = 7.0;
+
+static double bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+CHalfBandDecimator::CHalfBandDecimator()
+{
+    // Windowed sinc with cutoff at a quarter of the input rate. Of the
+    // full filter, only the taps at an odd distance from the centre are
+    // non-zero. They go into m_taps, from the outermost one inwards.
+    const size_t num_taps = 4 * HALFBAND_FOLDED_TAPS - 1;
+    const double centre = (num_taps - 1) / 2.0;
+
+    std::vector<double> h(num_taps);
+    double sum = 0;
+    for (size_t n = 0; n < num_taps; n++) {
+        const double t = n - centre;
+        const double sinc = (t == 0) ? 0.5 : sin(M_PI * t / 2.0) / (M_PI * t);
+        const double r = t / centre;
+        h[n] = sinc * bessel_i0(KAISER_BETA * sqrt(1.0 - r * r)) /
+            bessel_i0(KAISER_BETA);
+        sum += h[n];
+    }
+
+    // Unity gain at DC
+    m_taps.resize(HALFBAND_FOLDED_TAPS);
+    for (size_t i = 0; i < HALFBAND_FOLDED_TAPS; i++) {
+        m_taps[i] = h[2 * i] / sum;
+    }
+    m_centreTap = h[(num_taps - 1) / 2] / sum;
+
+    reset();
+}
+
+void CHalfBandDecimator::reset()
+{
+    m_even.assign(EVEN_HISTORY, 0.0f);
+    m_odd.assign(ODD_HISTORY, 0.0f);
+    m_havePending = false;
+}
+
+const std::vector<DSPCOMPLEX>& CHalfBandDecimator::decimate(
+        const DSPCOMPLEX *in, size_t num_samples)
+{
+    // Split the input into the even and odd phases, after the history
+    size_t n = 0;
+    const size_t num_pairs = (num_samples + (m_havePending ? 1 : 0)) / 2;
+
+    m_even.resize(EVEN_HISTORY + num_pairs);
+    m_odd.resize(ODD_HISTORY + num_pairs);
+
+    DSPCOMPLEX *even = m_even.data() + EVEN_HISTORY;
+    DSPCOMPLEX *odd = m_odd.data() + ODD_HISTORY;
+
+    size_t pair = 0;
+    if (m_havePending and num_pairs > 0) {
+        even[0] = m_pending;
+        odd[0] = in[0];
+        n = 1;
+        pair = 1;
+        m_havePending = false;
+    }
+
+    for (; pair < num_pairs; pair++, n += 2) {
+        even[pair] = in[n];
+        odd[pair] = in[n + 1];
+    }
+
+    if (n < num_samples) {
+        m_pending = in[n];
+        m_havePending = true;
+    }
+
+    // y[m] = c * o[m - K] + sum_i g[i] * (e[m - i] + e[m - (2K - 1 - i)])
+    // with c close to 0.5
+    // The complex samples are processed as interleaved floats, as all
+    // taps are real.
+    m_output.resize(num_pairs);
+    float *y = reinterpret_cast<float*>(m_output.data());
+    const float *e = reinterpret_cast<const float*>(m_even.data());
+    const float *o = reinterpret_cast<const float*>(m_odd.data());
+    const size_t len = 2 * num_pairs;
+
+    for (size_t j = 0; j < len; j++) {
+        y[j] = m_centreTap * o[j];
+    }
+
+    for (size_t i = 0; i < HALFBAND_FOLDED_TAPS; i++) {
+        const float g = m_taps[i];
+        const float *a = e + 2 * i;
+        const float *b = e + 2 * (EVEN_HISTORY - i);
+        for (size_t j = 0; j < len; j++) {
+            y[j] += g * (a[j] + b[j]);
+        }
+    }
+
+    // Keep the history for the next call
+    std::copy(m_even.end() - EVEN_HISTORY, m_even.end(), m_even.begin());
+    std::copy(m_odd.end() - ODD_HISTORY, m_odd.end(), m_odd.begin());
+    m_even.resize(EVEN_HISTORY);
+    m_odd.resize(ODD_HISTORY);
+
+    return m_output;
+}
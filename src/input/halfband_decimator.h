@@ -0,0 +1,74 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef HALFBAND_DECIMATOR_H
+#define HALFBAND_DECIMATOR_H
+
+#include <vector>
+#include <cstddef>
+#include "dab-constants.h"
+
+/* Decimates a complex stream by two with a half-band FIR, for the
+ * input devices that deliver 2 * INPUT_RATE.
+ *
+ * Only every other tap of a half-band filter is non-zero, and the
+ * filter is symmetric. The input is split into its even and odd phases,
+ * so that every output sample costs HALFBAND_FOLDED_TAPS multiplications
+ * plus the centre tap. The loops run over the output samples, which the
+ * compiler vectorises for SSE, AVX or NEON depending on the target flags.
+ *
+ * All buffers are kept between calls, so that no allocation happens once
+ * the block size has been seen. */
+class CHalfBandDecimator
+{
+public:
+    CHalfBandDecimator();
+
+    // Decimate num_samples samples. The returned vector is valid until
+    // the next call. With an odd num_samples, the last sample is kept for
+    // the next call.
+    const std::vector<DSPCOMPLEX>& decimate(const DSPCOMPLEX *in, size_t num_samples);
+
+    // Clear the filter history
+    void reset(void);
+
+private:
+    // The filter has 4 * HALFBAND_FOLDED_TAPS - 1 taps, 39 in total
+    static constexpr size_t HALFBAND_FOLDED_TAPS = 10;
+    static constexpr size_t EVEN_HISTORY = 2 * HALFBAND_FOLDED_TAPS - 1;
+    static constexpr size_t ODD_HISTORY = HALFBAND_FOLDED_TAPS;
+
+    std::vector<float> m_taps;
+    float m_centreTap = 0.5f;
+
+    std::vector<DSPCOMPLEX> m_even;
+    std::vector<DSPCOMPLEX> m_odd;
+    std::vector<DSPCOMPLEX> m_output;
+
+    bool m_havePending = false;
+    DSPCOMPLEX m_pending;
+};
+
+#endif // HALFBAND_DECIMATOR_H
@@ -0,0 +1,588 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include "iq_container.h"
+#include "dab-constants.h"
+
+static const char FILE_MAGIC[4] = {'W', 'I', 'Q', 'F'};
+static const char CHUNK_MAGIC[4] = {'W', 'I', 'Q', 'C'};
+static const char TRAILER_MAGIC[4] = {'W', 'I', 'Q', 'X'};
+static const uint16_t FORMAT_VERSION = 1;
+
+static const size_t FILE_HEADER_SIZE = 16;
+static const size_t CHUNK_HEADER_SIZE = 36;
+static const size_t TRAILER_SIZE = 16;
+
+// Refuse chunk sizes from the file header that would need an unreasonable
+// amount of memory to decode
+static const uint32_t MAX_SAMPLES_PER_CHUNK =
+    16 * CIQContainerWriter::DEFAULT_SAMPLES_PER_CHUNK;
+
+// Longest unary prefix of the Rice code, longer values are escaped
+static const int RICE_MAX_QUOTIENT = 16;
+static const int RICE_MAX_PARAMETER = 7;
+
+// Step of the optimal 16 level uniform quantiser for a gaussian source,
+// relative to the standard deviation
+static const float QUANTISER_STEP_PER_SIGMA = 0.3352f;
+
+static int seek64(FILE *f, int64_t offset, int whence)
+{
+#if defined(_WIN32)
+    return _fseeki64(f, offset, whence);
+#else
+    return fseeko(f, offset, whence);
+#endif
+}
+
+static int64_t tell64(FILE *f)
+{
+#if defined(_WIN32)
+    return _ftelli64(f);
+#else
+    return ftello(f);
+#endif
+}
+
+static void put_le(std::vector<uint8_t>& buf, uint64_t value, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; i++) {
+        buf.push_back((value >> (8 * i)) & 0xFF);
+    }
+}
+
+static uint64_t get_le(const uint8_t *buf, size_t bytes)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        value |= (uint64_t)buf[i] << (8 * i);
+    }
+    return value;
+}
+
+static uint32_t float_bits(float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static float bits_float(uint32_t u)
+{
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static inline uint8_t zigzag(uint8_t sample)
+{
+    const int v = (int)sample - 128;
+    return (v >= 0) ? 2 * v : -2 * v - 1;
+}
+
+static inline uint8_t unzigzag(uint32_t z)
+{
+    const int v = (z & 1) ? -(int)((z + 1) / 2) : (int)(z / 2);
+    return v + 128;
+}
+
+class BitWriter {
+public:
+    BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    // length must not exceed 56 bits
+    void put(uint64_t bits, int length) {
+        acc = (acc << length) | bits;
+        num_bits += length;
+        while (num_bits >= 8) {
+            num_bits -= 8;
+            out.push_back((acc >> num_bits) & 0xFF);
+        }
+    }
+
+    void flush() {
+        if (num_bits > 0) {
+            out.push_back((acc << (8 - num_bits)) & 0xFF);
+            num_bits = 0;
+        }
+    }
+
+private:
+    std::vector<uint8_t>& out;
+    uint64_t acc = 0;
+    int num_bits = 0;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t *data, size_t size) : data(data), size(size) {}
+
+    // Make at least 32 bits available, past the end zeros are read
+    void refill() {
+        while (num_bits <= 56) {
+            acc = (acc << 8) | (pos < size ? data[pos] : 0);
+            pos++;
+            num_bits += 8;
+        }
+    }
+
+    uint32_t peek(int length) const {
+        return (acc >> (num_bits - length)) & ((1ull << length) - 1);
+    }
+
+    void skip(int length) { num_bits -= length; }
+
+    bool overrun() const { return pos > size + 8; }
+
+private:
+    const uint8_t *data;
+    size_t size;
+    size_t pos = 0;
+    uint64_t acc = 0;
+    int num_bits = 0;
+};
+
+static void encode_rice(const uint8_t *iq, size_t n, IQChunk& chunk)
+{
+    // Choose the parameter that gives the shortest code
+    std::vector<size_t> histogram(256, 0);
+    for (size_t i = 0; i < n; i++) {
+        histogram[zigzag(iq[i])]++;
+    }
+
+    size_t best_length = SIZE_MAX;
+    int best_k = 0;
+    for (int k = 0; k <= RICE_MAX_PARAMETER; k++) {
+        size_t length = 0;
+        for (uint32_t z = 0; z < 256; z++) {
+            const uint32_t q = z >> k;
+            length += histogram[z] * ((q < RICE_MAX_QUOTIENT) ?
+                    q + 1 + k : RICE_MAX_QUOTIENT + 8);
+        }
+        if (length < best_length) {
+            best_length = length;
+            best_k = k;
+        }
+    }
+
+    chunk.riceParameter = best_k;
+    chunk.payload.clear();
+    chunk.payload.reserve(best_length / 8 + 1);
+
+    BitWriter writer(chunk.payload);
+    const uint32_t mask = (1u << best_k) - 1;
+    for (size_t i = 0; i < n; i++) {
+        const uint32_t z = zigzag(iq[i]);
+        const uint32_t q = z >> best_k;
+        if (q < RICE_MAX_QUOTIENT) {
+            // q ones, a zero, and the k low bits
+            const uint64_t unary = ((1ull << q) - 1) << 1;
+            writer.put((unary << best_k) | (z & mask), q + 1 + best_k);
+        }
+        else {
+            writer.put(((1ull << RICE_MAX_QUOTIENT) - 1) << 8 | z,
+                    RICE_MAX_QUOTIENT + 8);
+        }
+    }
+    writer.flush();
+}
+
+static bool decode_rice(const IQChunk& chunk, uint8_t *iq, size_t n)
+{
+    const int k = chunk.riceParameter;
+    if (k > RICE_MAX_PARAMETER) {
+        return false;
+    }
+
+    BitReader reader(chunk.payload.data(), chunk.payload.size());
+    for (size_t i = 0; i < n; i++) {
+        reader.refill();
+
+        uint32_t prefix = reader.peek(RICE_MAX_QUOTIENT);
+        int q = 0;
+        while (q < RICE_MAX_QUOTIENT and (prefix & (1u << (RICE_MAX_QUOTIENT - 1)))) {
+            q++;
+            prefix <<= 1;
+        }
+
+        if (q == RICE_MAX_QUOTIENT) {
+            reader.skip(RICE_MAX_QUOTIENT);
+            iq[i] = unzigzag(reader.peek(8));
+            reader.skip(8);
+        }
+        else {
+            reader.skip(q + 1);
+            const uint32_t low = k ? reader.peek(k) : 0;
+            reader.skip(k);
+            iq[i] = unzigzag(((uint32_t)q << k) | low);
+        }
+    }
+
+    return not reader.overrun();
+}
+
+static void encode_4bit(const uint8_t *iq, size_t n, IQChunk& chunk)
+{
+    double sum_squares = 0;
+    for (size_t i = 0; i < n; i++) {
+        const double v = (double)iq[i] - 128.0;
+        sum_squares += v * v;
+    }
+    const float sigma = n ? std::sqrt(sum_squares / n) : 0.0f;
+    const float step = std::max(QUANTISER_STEP_PER_SIGMA * sigma, 1.0f);
+    const float inv_step = 1.0f / step;
+
+    chunk.step = step;
+    chunk.payload.assign((n + 1) / 2, 0);
+    for (size_t i = 0; i < n; i++) {
+        int q = (int)std::floor(((float)iq[i] - 128.0f) * inv_step);
+        q = std::min(std::max(q, -8), 7) + 8;
+        chunk.payload[i / 2] |= (i % 2 == 0) ? (q << 4) : q;
+    }
+}
+
+static bool decode_4bit(const IQChunk& chunk, uint8_t *iq, size_t n)
+{
+    if (chunk.payload.size() < (n + 1) / 2) {
+        return false;
+    }
+
+    uint8_t levels[16];
+    for (int q = 0; q < 16; q++) {
+        const float v = 128.0f + (q - 8 + 0.5f) * chunk.step;
+        levels[q] = std::min(std::max(std::lround(v), 0l), 255l);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t b = chunk.payload[i / 2];
+        iq[i] = levels[(i % 2 == 0) ? (b >> 4) : (b & 0x0F)];
+    }
+    return true;
+}
+
+void encodeIQChunk(const uint8_t *iq, size_t numSamples, IQCodec codec, IQChunk& chunk)
+{
+    chunk.codec = codec;
+    chunk.numSamples = numSamples;
+    chunk.riceParameter = 0;
+    chunk.step = 0.0f;
+
+    switch (codec) {
+        case IQCodec::Lossless:
+            encode_rice(iq, 2 * numSamples, chunk);
+            break;
+        case IQCodec::Quantised4Bit:
+            encode_4bit(iq, 2 * numSamples, chunk);
+            break;
+    }
+}
+
+bool decodeIQChunk(const IQChunk& chunk, std::vector<uint8_t>& iq)
+{
+    iq.resize(2 * (size_t)chunk.numSamples);
+
+    switch (chunk.codec) {
+        case IQCodec::Lossless:
+            return decode_rice(chunk, iq.data(), iq.size());
+        case IQCodec::Quantised4Bit:
+            return decode_4bit(chunk, iq.data(), iq.size());
+    }
+    return false;
+}
+
+CIQContainerWriter::CIQContainerWriter(IQCodec codec, uint32_t samplesPerChunk) :
+    codec(codec),
+    samplesPerChunk(samplesPerChunk)
+{
+}
+
+CIQContainerWriter::~CIQContainerWriter()
+{
+    close();
+}
+
+bool CIQContainerWriter::open(const std::string& fileName)
+{
+    file = fopen(fileName.c_str(), "wb");
+    if (file == nullptr) {
+        std::clog << "IQContainer: Cannot open " << fileName << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> header(FILE_MAGIC, FILE_MAGIC + 4);
+    put_le(header, FORMAT_VERSION, 2);
+    put_le(header, 0, 2);
+    put_le(header, INPUT_RATE, 4);
+    put_le(header, samplesPerChunk, 4);
+
+    ok = fwrite(header.data(), header.size(), 1, file) == 1;
+    bytesWritten = header.size();
+    pending.reserve(2 * (size_t)samplesPerChunk);
+    return ok;
+}
+
+bool CIQContainerWriter::write(const uint8_t *iq, size_t numSamples,
+        int64_t timestamp_us, int frequency, float gain)
+{
+    size_t done = 0;
+    while (ok and done < numSamples) {
+        if (pending.empty()) {
+            pendingTimestamp_us = timestamp_us +
+                (int64_t)done * 1000000 / INPUT_RATE;
+            pendingFrequency = frequency;
+            pendingGain = gain;
+        }
+
+        const size_t missing = samplesPerChunk - pending.size() / 2;
+        const size_t num = std::min(missing, numSamples - done);
+        pending.insert(pending.end(), iq + 2 * done, iq + 2 * (done + num));
+        done += num;
+
+        if (pending.size() / 2 == samplesPerChunk) {
+            ok = writeChunk();
+        }
+    }
+    return ok;
+}
+
+bool CIQContainerWriter::writeChunk()
+{
+    encodeIQChunk(pending.data(), pending.size() / 2, codec, chunk);
+    chunk.timestamp_us = pendingTimestamp_us;
+    chunk.frequency = pendingFrequency;
+    chunk.gain = pendingGain;
+    pending.clear();
+
+    std::vector<uint8_t> header(CHUNK_MAGIC, CHUNK_MAGIC + 4);
+    put_le(header, (uint8_t)chunk.codec, 1);
+    put_le(header, chunk.riceParameter, 1);
+    put_le(header, 0, 2);
+    put_le(header, chunk.numSamples, 4);
+    put_le(header, chunk.payload.size(), 4);
+    put_le(header, (uint64_t)chunk.timestamp_us, 8);
+    put_le(header, (uint32_t)chunk.frequency, 4);
+    put_le(header, float_bits(chunk.gain), 4);
+    put_le(header, float_bits(chunk.step), 4);
+
+    index.push_back(bytesWritten);
+
+    if (fwrite(header.data(), header.size(), 1, file) != 1 or
+            (not chunk.payload.empty() and
+             fwrite(chunk.payload.data(), chunk.payload.size(), 1, file) != 1)) {
+        std::clog << "IQContainer: write error" << std::endl;
+        return false;
+    }
+    bytesWritten += header.size() + chunk.payload.size();
+    return true;
+}
+
+bool CIQContainerWriter::close()
+{
+    if (file == nullptr) {
+        return false;
+    }
+
+    if (ok and not pending.empty()) {
+        ok = writeChunk();
+    }
+
+    if (ok) {
+        std::vector<uint8_t> trailer;
+        for (const auto offset : index) {
+            put_le(trailer, offset, 8);
+        }
+        put_le(trailer, bytesWritten, 8);
+        put_le(trailer, index.size(), 4);
+        trailer.insert(trailer.end(), TRAILER_MAGIC, TRAILER_MAGIC + 4);
+
+        ok = fwrite(trailer.data(), trailer.size(), 1, file) == 1;
+        bytesWritten += trailer.size();
+    }
+
+    ok = (fclose(file) == 0) and ok;
+    file = nullptr;
+    return ok;
+}
+
+bool CIQContainerReader::open(FILE *file)
+{
+    this->file = file;
+    index.clear();
+
+    uint8_t header[FILE_HEADER_SIZE];
+    if (seek64(file, 0, SEEK_SET) != 0 or
+            fread(header, sizeof(header), 1, file) != 1 or
+            memcmp(header, FILE_MAGIC, 4) != 0) {
+        std::clog << "IQContainer: not a .wiq file" << std::endl;
+        return false;
+    }
+
+    if (get_le(header + 4, 2) != FORMAT_VERSION) {
+        std::clog << "IQContainer: unsupported version " <<
+            get_le(header + 4, 2) << std::endl;
+        return false;
+    }
+
+    sampleRate = get_le(header + 8, 4);
+    samplesPerChunk = get_le(header + 12, 4);
+
+    if (samplesPerChunk == 0 or samplesPerChunk > MAX_SAMPLES_PER_CHUNK) {
+        std::clog << "IQContainer: invalid chunk size " <<
+            samplesPerChunk << std::endl;
+        return false;
+    }
+
+    if (seek64(file, 0, SEEK_END) != 0) {
+        return false;
+    }
+    const uint64_t file_size = tell64(file);
+
+    if (not readIndex(file_size)) {
+        index.clear();
+        std::clog << "IQContainer: no index, scanning the file" << std::endl;
+        if (not scanChunks(file_size)) {
+            return false;
+        }
+    }
+
+    std::clog << "IQContainer: " << index.size() << " chunks of " <<
+        samplesPerChunk << " samples" << std::endl;
+    return true;
+}
+
+bool CIQContainerReader::readIndex(uint64_t file_size)
+{
+    if (file_size < FILE_HEADER_SIZE + TRAILER_SIZE) {
+        return false;
+    }
+
+    uint8_t trailer[TRAILER_SIZE];
+    if (seek64(file, -(int64_t)TRAILER_SIZE, SEEK_END) != 0 or
+            fread(trailer, sizeof(trailer), 1, file) != 1 or
+            memcmp(trailer + 12, TRAILER_MAGIC, 4) != 0) {
+        return false;
+    }
+
+    const uint64_t index_offset = get_le(trailer, 8);
+    const size_t num_chunks = get_le(trailer + 8, 4);
+
+    // The index lies between the chunks and the trailer
+    const uint64_t index_end = file_size - TRAILER_SIZE;
+    if (num_chunks > (index_end - FILE_HEADER_SIZE) / 8 or
+            index_offset < FILE_HEADER_SIZE or
+            index_offset > index_end - 8 * num_chunks) {
+        std::clog << "IQContainer: invalid index" << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> raw(8 * num_chunks);
+    if (seek64(file, index_offset, SEEK_SET) != 0 or
+            (num_chunks > 0 and fread(raw.data(), raw.size(), 1, file) != 1)) {
+        return false;
+    }
+
+    // Chunks are stored in order, each one at least a header long
+    uint64_t min_offset = FILE_HEADER_SIZE;
+    index.resize(num_chunks);
+    for (size_t i = 0; i < num_chunks; i++) {
+        index[i] = get_le(raw.data() + 8 * i, 8);
+        if (index[i] < min_offset or
+                index[i] + CHUNK_HEADER_SIZE > index_offset) {
+            std::clog << "IQContainer: invalid index" << std::endl;
+            return false;
+        }
+        min_offset = index[i] + CHUNK_HEADER_SIZE;
+    }
+
+    dataEnd = index_offset;
+    return true;
+}
+
+bool CIQContainerReader::scanChunks(uint64_t file_size)
+{
+    dataEnd = file_size;
+
+    uint64_t offset = FILE_HEADER_SIZE;
+    uint8_t header[CHUNK_HEADER_SIZE];
+    while (seek64(file, offset, SEEK_SET) == 0 and
+            fread(header, sizeof(header), 1, file) == 1 and
+            memcmp(header, CHUNK_MAGIC, 4) == 0) {
+        const uint64_t next = offset + CHUNK_HEADER_SIZE + get_le(header + 12, 4);
+        if (next > file_size) {
+            // Truncated last chunk
+            break;
+        }
+        index.push_back(offset);
+        offset = next;
+    }
+    return true;
+}
+
+bool CIQContainerReader::readChunk(size_t chunkIndex, IQChunk& chunk)
+{
+    if (chunkIndex >= index.size()) {
+        return false;
+    }
+
+    uint8_t header[CHUNK_HEADER_SIZE];
+    if (seek64(file, index[chunkIndex], SEEK_SET) != 0 or
+            fread(header, sizeof(header), 1, file) != 1 or
+            memcmp(header, CHUNK_MAGIC, 4) != 0) {
+        std::clog << "IQContainer: cannot read chunk " << chunkIndex << std::endl;
+        return false;
+    }
+
+    // The payload ends before the next chunk
+    const uint64_t payload_offset = index[chunkIndex] + CHUNK_HEADER_SIZE;
+    const uint64_t payload_end = chunkIndex + 1 < index.size() ?
+        index[chunkIndex + 1] : dataEnd;
+    const uint32_t numSamples = get_le(header + 8, 4);
+    const uint32_t payloadSize = get_le(header + 12, 4);
+    if (numSamples > samplesPerChunk or
+            payload_offset + payloadSize > payload_end) {
+        std::clog << "IQContainer: invalid chunk " << chunkIndex << std::endl;
+        return false;
+    }
+
+    chunk.codec = (IQCodec)header[4];
+    chunk.riceParameter = header[5];
+    chunk.numSamples = numSamples;
+    chunk.payload.resize(payloadSize);
+    chunk.timestamp_us = (int64_t)get_le(header + 16, 8);
+    chunk.frequency = (int32_t)get_le(header + 24, 4);
+    chunk.gain = bits_float(get_le(header + 28, 4));
+    chunk.step = bits_float(get_le(header + 32, 4));
+
+    if (not chunk.payload.empty() and
+            fread(chunk.payload.data(), chunk.payload.size(), 1, file) != 1) {
+        std::clog << "IQContainer: truncated chunk " << chunkIndex << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,150 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef IQ_CONTAINER_H
+#define IQ_CONTAINER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/* Chunked container for u8 IQ recordings (.wiq files).
+ *
+ * The samples are split into chunks of a fixed number of samples, by
+ * default one transmission frame in mode I. Every chunk is compressed on
+ * its own and carries the time of its first sample, the frequency and
+ * the gain, so that chunks can be decoded independently and in parallel.
+ * An index of the chunk offsets at the end of the file allows to jump to
+ * any chunk in constant time. If the index is missing, e.g. because the
+ * recording was interrupted, it is rebuilt by scanning the chunk headers.
+ *
+ * All values are stored in little endian.
+ *
+ *   file header:  "WIQF", u16 version, u16 flags, u32 sample rate,
+ *                 u32 samples per chunk
+ *   chunks:       "WIQC", u8 codec, u8 rice parameter, u16 reserved,
+ *                 u32 number of samples, u32 payload size,
+ *                 i64 timestamp in us since the epoch, i32 frequency in Hz,
+ *                 f32 gain in dB, f32 quantiser step, payload
+ *   index:        u64 offset of every chunk
+ *   trailer:      u64 offset of the index, u32 number of chunks, "WIQX"
+ */
+
+enum class IQCodec : uint8_t {
+    // Centred samples, zigzag mapped and Rice coded, with the Rice
+    // parameter chosen per chunk. Typically 15-25% smaller than u8.
+    Lossless = 0,
+    // Uniform 4-bit quantiser scaled to the RMS of the chunk, half
+    // the size of u8. Good enough for DAB reception.
+    Quantised4Bit = 1,
+};
+
+struct IQChunk {
+    IQCodec codec = IQCodec::Lossless;
+    uint8_t riceParameter = 0;
+    float step = 0.0f;
+    uint32_t numSamples = 0;
+    int64_t timestamp_us = 0;
+    int32_t frequency = 0;
+    float gain = 0.0f;
+    std::vector<uint8_t> payload;
+};
+
+// Compress numSamples u8 IQ samples (2 * numSamples bytes) into chunk.
+// The metadata fields of chunk are left untouched.
+void encodeIQChunk(const uint8_t *iq, size_t numSamples, IQCodec codec, IQChunk& chunk);
+
+// Decompress a chunk into u8 IQ samples. Does not depend on any state
+// and can be called concurrently for different chunks.
+bool decodeIQChunk(const IQChunk& chunk, std::vector<uint8_t>& iq);
+
+class CIQContainerWriter {
+public:
+    // One transmission frame in mode I
+    static const uint32_t DEFAULT_SAMPLES_PER_CHUNK = 196608;
+
+    CIQContainerWriter(IQCodec codec,
+            uint32_t samplesPerChunk = DEFAULT_SAMPLES_PER_CHUNK);
+    ~CIQContainerWriter();
+    CIQContainerWriter(const CIQContainerWriter&) = delete;
+    CIQContainerWriter& operator=(const CIQContainerWriter&) = delete;
+
+    bool open(const std::string& fileName);
+
+    // Append u8 IQ samples. timestamp_us is the time of the first sample.
+    bool write(const uint8_t *iq, size_t numSamples,
+            int64_t timestamp_us, int frequency, float gain);
+
+    // Write the last chunk and the index. Called by the destructor.
+    bool close(void);
+
+    uint64_t getBytesWritten(void) const { return bytesWritten; }
+
+private:
+    bool writeChunk(void);
+
+    const IQCodec codec;
+    const uint32_t samplesPerChunk;
+    FILE *file = nullptr;
+    bool ok = false;
+    uint64_t bytesWritten = 0;
+
+    std::vector<uint8_t> pending;
+    int64_t pendingTimestamp_us = 0;
+    int32_t pendingFrequency = 0;
+    float pendingGain = 0.0f;
+
+    IQChunk chunk;
+    std::vector<uint64_t> index;
+};
+
+class CIQContainerReader {
+public:
+    // Does not take ownership of the file
+    bool open(FILE *file);
+
+    size_t getNumChunks(void) const { return index.size(); }
+    uint32_t getSamplesPerChunk(void) const { return samplesPerChunk; }
+    uint32_t getSampleRate(void) const { return sampleRate; }
+
+    // Read the compressed chunk, which can then be decoded in any thread
+    bool readChunk(size_t chunkIndex, IQChunk& chunk);
+
+private:
+    bool readIndex(uint64_t fileSize);
+    bool scanChunks(uint64_t fileSize);
+
+    FILE *file = nullptr;
+    uint32_t sampleRate = 0;
+    uint32_t samplesPerChunk = 0;
+    std::vector<uint64_t> index;
+
+    // Offset of the index, or the file size if there is none. No chunk
+    // can extend past it.
+    uint64_t dataEnd = 0;
+};
+
+#endif // IQ_CONTAINER_H
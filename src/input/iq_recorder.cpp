@@ -0,0 +1,353 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <iostream>
+#include "iq_recorder.h"
+#include "dab-constants.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#endif
+
+// Size of the writes to disk. Large writes are cheap on SD cards and
+// flash, and leave the disk idle most of the time.
+static const size_t WRITE_BLOCK_SIZE = 1024 * 1024;
+
+// Report dropped samples at most this often
+static const int64_t REPORT_INTERVAL_US = 10 * 1000000;
+
+static int64_t now_us(void)
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(
+            system_clock::now().time_since_epoch()).count();
+}
+
+static bool ends_with(const std::string& s, const std::string& suffix)
+{
+    return s.size() >= suffix.size() and
+        s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static uint32_t power_of_two(size_t size)
+{
+    uint32_t bufferSize = 1;
+    while (bufferSize < size) {
+        bufferSize *= 2;
+    }
+    return bufferSize;
+}
+
+CIQRecorder::CIQRecorder(const std::string& fileName,
+        uint64_t maxFileSize, int maxFileDuration, size_t bufferSize) :
+    fileName(fileName),
+    maxFileSize(maxFileSize),
+    maxFileDuration(maxFileDuration),
+    isContainer(ends_with(fileName, ".wiq")),
+    codec(ends_with(fileName, ".q4.wiq") ?
+            IQCodec::Quantised4Bit : IQCodec::Lossless),
+    buffer(power_of_two(std::max(bufferSize, 2 * WRITE_BLOCK_SIZE)))
+{
+}
+
+CIQRecorder::~CIQRecorder()
+{
+    stop();
+}
+
+bool CIQRecorder::start()
+{
+    if (running) {
+        return true;
+    }
+
+    if (not openFile()) {
+        return false;
+    }
+
+    ok = true;
+    running = true;
+    thread = std::thread(&CIQRecorder::run, this);
+    return true;
+}
+
+void CIQRecorder::stop()
+{
+    if (not running) {
+        return;
+    }
+
+    running = false;
+    dataAvailable.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void CIQRecorder::push(const uint8_t *data, size_t length, int frequency, float gain)
+{
+    if (not running) {
+        return;
+    }
+
+    this->frequency = frequency;
+    this->gain = gain;
+
+    // Keep I and Q in order after an odd number of bytes was dropped
+    if (skipByte and length > 0) {
+        data++;
+        length--;
+        skipByte = false;
+    }
+
+    if (not ok or (size_t)buffer.GetRingBufferWriteAvailable() < length) {
+        buffer.onDroppedData(length);
+        skipByte = (length % 2) == 1;
+        return;
+    }
+
+    buffer.putDataIntoBuffer(data, length);
+
+    if ((size_t)buffer.GetRingBufferReadAvailable() >= WRITE_BLOCK_SIZE) {
+        dataAvailable.notify_one();
+    }
+}
+
+void CIQRecorder::run()
+{
+    while (running) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            dataAvailable.wait_for(lock, std::chrono::milliseconds(100), [&]() {
+                    return not running or
+                        (size_t)buffer.GetRingBufferReadAvailable() >= WRITE_BLOCK_SIZE;
+                    });
+        }
+
+        writeBuffered(false);
+        reportDrops(false);
+    }
+
+    writeBuffered(true);
+    closeFile();
+    reportDrops(true);
+}
+
+void CIQRecorder::writeBuffered(bool drain)
+{
+    while (true) {
+        const size_t available = buffer.GetRingBufferReadAvailable();
+        if (available == 0 or (available < WRITE_BLOCK_SIZE and not drain)) {
+            break;
+        }
+
+        // Age of the oldest sample in the buffer
+        const int64_t timestamp_us = now_us() -
+            (int64_t)(available / 2) * 1000000 / INPUT_RATE;
+
+        // Write straight out of the ring buffer, without copying
+        void *region1 = nullptr;
+        void *region2 = nullptr;
+        int32_t size1 = 0;
+        int32_t size2 = 0;
+        buffer.GetRingBufferReadRegions(std::min(available, WRITE_BLOCK_SIZE),
+                &region1, &size1, &region2, &size2);
+
+        if (ok) {
+            ok = writeBlock(static_cast<const uint8_t*>(region1), size1, timestamp_us) and
+                writeBlock(static_cast<const uint8_t*>(region2), size2,
+                        timestamp_us + (int64_t)(size1 / 2) * 1000000 / INPUT_RATE);
+            if (not ok) {
+                std::clog << "IQRecorder: write to " << currentFileName <<
+                    " failed, stopping the recording" << std::endl;
+                closeFile();
+            }
+        }
+
+        if (not ok) {
+            buffer.onDroppedData(size1 + size2);
+        }
+
+        buffer.AdvanceRingBufferReadIndex(size1 + size2);
+    }
+}
+
+bool CIQRecorder::writeBlock(const uint8_t *data, size_t length, int64_t timestamp_us)
+{
+    if (length == 0) {
+        return true;
+    }
+
+    const bool sizeExceeded = maxFileSize > 0 and fileBytes >= maxFileSize;
+    const bool durationExceeded = maxFileDuration > 0 and
+        now_us() - fileStart_us >= (int64_t)maxFileDuration * 1000000;
+    if (sizeExceeded or durationExceeded) {
+        closeFile();
+        if (not openFile()) {
+            return false;
+        }
+    }
+
+    if (container) {
+        const uint64_t before = container->getBytesWritten();
+        if (not container->write(data, length / 2, timestamp_us, frequency, gain)) {
+            return false;
+        }
+        // Chunks are only written once complete
+        const uint64_t written = container->getBytesWritten() - before;
+        fileBytes += written;
+        bytesWritten += written;
+        return true;
+    }
+
+    if (fwrite(data, length, 1, rawFile) != 1) {
+        return false;
+    }
+
+#if defined(__linux__)
+    // Start the write-back of this block, wait for the previous one and
+    // drop it from the page cache. This is what O_DIRECT would give us,
+    // without its alignment constraints, and prevents hours of recording
+    // from pushing everything else out of memory on small devices.
+    const int fd = fileno(rawFile);
+    sync_file_range(fd, fileBytes, length, SYNC_FILE_RANGE_WRITE);
+    if (fileBytes > lastSyncOffset) {
+        sync_file_range(fd, lastSyncOffset, fileBytes - lastSyncOffset,
+                SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise(fd, lastSyncOffset, fileBytes - lastSyncOffset,
+                POSIX_FADV_DONTNEED);
+        lastSyncOffset = fileBytes;
+    }
+#endif
+
+    fileBytes += length;
+    bytesWritten += length;
+    return true;
+}
+
+std::string CIQRecorder::nextFileName()
+{
+    if (maxFileSize == 0 and maxFileDuration == 0) {
+        return fileName;
+    }
+
+    // Keep the sample format in the extension, CRAWFile relies on it
+    std::string extension;
+    for (const char *e : {".q4.wiq", ".u8.iq"}) {
+        if (ends_with(fileName, e)) {
+            extension = e;
+        }
+    }
+    if (extension.empty()) {
+        const size_t dot = fileName.find_last_of('.');
+        const size_t slash = fileName.find_last_of("/\\");
+        if (dot != std::string::npos and
+                (slash == std::string::npos or dot > slash)) {
+            extension = fileName.substr(dot);
+        }
+    }
+    const std::string stem = fileName.substr(0, fileName.size() - extension.size());
+
+    const time_t now = time(nullptr);
+    char timestamp[32];
+    strftime(timestamp, sizeof(timestamp), "_%Y%m%d_%H%M%S", localtime(&now));
+
+    // Several files can be started within one second if the size limit is small
+    std::string name = stem + timestamp;
+    if (timestamp == lastFileTimestamp) {
+        name += "_" + std::to_string(++filesInSameSecond);
+    }
+    else {
+        lastFileTimestamp = timestamp;
+        filesInSameSecond = 0;
+    }
+    name += extension;
+    return name;
+}
+
+bool CIQRecorder::openFile()
+{
+    currentFileName = nextFileName();
+    fileBytes = 0;
+    lastSyncOffset = 0;
+    fileStart_us = now_us();
+
+    if (isContainer) {
+        container.reset(new CIQContainerWriter(codec));
+        if (not container->open(currentFileName)) {
+            container.reset();
+            std::clog << "IQRecorder: cannot open " << currentFileName << std::endl;
+            return false;
+        }
+    }
+    else {
+        rawFile = fopen(currentFileName.c_str(), "wb");
+        if (rawFile == nullptr) {
+            std::clog << "IQRecorder: cannot open " << currentFileName << std::endl;
+            return false;
+        }
+        // Our blocks are already large, avoid the copy into the stdio buffer
+        setvbuf(rawFile, nullptr, _IONBF, 0);
+    }
+
+    std::clog << "IQRecorder: recording to " << currentFileName << std::endl;
+    return true;
+}
+
+void CIQRecorder::closeFile()
+{
+    if (container) {
+        const uint64_t before = container->getBytesWritten();
+        container->close();
+        bytesWritten += container->getBytesWritten() - before;
+        container.reset();
+    }
+
+    if (rawFile) {
+        fclose(rawFile);
+        rawFile = nullptr;
+    }
+}
+
+void CIQRecorder::reportDrops(bool force)
+{
+    const int64_t now = now_us();
+    if (not force and now - lastReport_us < REPORT_INTERVAL_US) {
+        return;
+    }
+    lastReport_us = now;
+
+    const uint64_t dropped = buffer.GetDroppedElements();
+    if (dropped != reportedDroppedBytes) {
+        std::clog << "IQRecorder: dropped " << dropped - reportedDroppedBytes <<
+            " bytes (" << dropped << " in total)" << std::endl;
+        reportedDroppedBytes = dropped;
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef IQ_RECORDER_H
+#define IQ_RECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "iq_container.h"
+#include "ringbuffer.h"
+
+/* Streams the u8 IQ samples of the record tap to disk. The input thread
+ * only copies into a ring buffer and never waits for the disk; a writer
+ * thread empties the buffer in large blocks. If the disk cannot keep up
+ * and the buffer overflows, the samples are dropped and counted.
+ *
+ * The file name selects the format like for writeRecordBufferToFile():
+ * .wiq and .q4.wiq write a compressed container, anything else raw u8.
+ * When a maximum size or duration is given, the recording is split into
+ * several files, and the time at which each file was started is inserted
+ * before the extension, e.g. capture_20200301_154500.iq */
+class CIQRecorder {
+public:
+    // About one second of samples
+    static const size_t DEFAULT_BUFFER_SIZE = 4 * 1024 * 1024;
+
+    // maxFileSize in bytes and maxFileDuration in seconds, 0 for no limit
+    CIQRecorder(const std::string& fileName,
+            uint64_t maxFileSize = 0,
+            int maxFileDuration = 0,
+            size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    ~CIQRecorder();
+    CIQRecorder(const CIQRecorder&) = delete;
+    CIQRecorder& operator=(const CIQRecorder&) = delete;
+
+    // Open the first file and start the writer thread
+    bool start(void);
+
+    // Write out what is still buffered and close the file
+    void stop(void);
+
+    // Called by the input thread, never blocks
+    void push(const uint8_t *data, size_t length, int frequency, float gain);
+
+    uint64_t getBytesWritten(void) const { return bytesWritten; }
+    uint64_t getDroppedBytes(void) const { return buffer.GetDroppedElements(); }
+
+    // False after a write error, all further samples are dropped
+    bool isOK(void) const { return ok; }
+
+private:
+    void run(void);
+    void writeBuffered(bool drain);
+    bool writeBlock(const uint8_t *data, size_t length, int64_t timestamp_us);
+    bool openFile(void);
+    void closeFile(void);
+    std::string nextFileName(void);
+    void reportDrops(bool force);
+
+    const std::string fileName;
+    const uint64_t maxFileSize;
+    const int maxFileDuration;
+    const bool isContainer;
+    const IQCodec codec;
+
+    RingBuffer<uint8_t> buffer;
+    bool skipByte = false;
+    std::atomic<int> frequency = ATOMIC_VAR_INIT(0);
+    std::atomic<float> gain = ATOMIC_VAR_INIT(0.0f);
+
+    std::atomic<bool> running = ATOMIC_VAR_INIT(false);
+    std::atomic<bool> ok = ATOMIC_VAR_INIT(true);
+    std::mutex mutex;
+    std::condition_variable dataAvailable;
+    std::thread thread;
+
+    // Only used by the writer thread
+    FILE *rawFile = nullptr;
+    std::unique_ptr<CIQContainerWriter> container;
+    std::string currentFileName;
+    std::string lastFileTimestamp;
+    int filesInSameSecond = 0;
+    uint64_t fileBytes = 0;
+    int64_t fileStart_us = 0;
+    uint64_t lastSyncOffset = 0;
+
+    std::atomic<uint64_t> bytesWritten = ATOMIC_VAR_INIT(0);
+    uint64_t reportedDroppedBytes = 0;
+    int64_t lastReport_us = 0;
+};
+
+#endif // IQ_RECORDER_H
@@ -45,8 +45,7 @@ lms_info_str_t limedevices [10];
 
 CLimeSDR::CLimeSDR(RadioControllerInterface &radioController) :
     radioController(radioController),
-    SampleBuffer(256 * 1024),
-    SpectrumSampleBuffer(8192)
+    SampleBuffer(256 * 1024)
 {
     std::clog << "LimeSDR: " << "Open LimeSDR" << std::endl;
 
@@ -210,7 +209,6 @@ void CLimeSDR::limesdr_thread_run()
                 temp[i] = DSPCOMPLEX(localBuffer[2*i] / 2048.0, localBuffer[2*i+1] / 2048.0);
             }
             SampleBuffer.putDataIntoBuffer (temp.data(), res);
-            SpectrumSampleBuffer.putDataIntoBuffer (temp.data(), res);
             amountRead += res;
             res = LMS_GetStreamStatus (&stream, &streamStatus);
             underruns += streamStatus. underrun;
@@ -253,16 +251,6 @@ int32_t CLimeSDR::getSamples(DSPCOMPLEX* Buffer, int32_t Size)
     return SampleBuffer.getDataFromBuffer(Buffer, Size);
 }
 
-std::vector<DSPCOMPLEX> CLimeSDR::getSpectrumSamples(int size)
-{
-    std::vector<DSPCOMPLEX> buf(size);
-    int sizeRead = SpectrumSampleBuffer.getDataFromBuffer(buf.data(), size);
-    if (sizeRead < size) {
-        buf.resize(sizeRead);
-    }
-    return buf;
-}
-
 int32_t CLimeSDR::getSamplesToRead(void)
 {
     return SampleBuffer.GetRingBufferReadAvailable();
@@ -54,7 +54,6 @@ public:
     void stop(void);
     void reset(void);
     int32_t getSamples(DSPCOMPLEX* Buffer, int32_t Size);
-    std::vector<DSPCOMPLEX> getSpectrumSamples(int size);
     int32_t getSamplesToRead(void);
     float getGain(void) const;
     float setGain(int gain);
@@ -83,7 +82,6 @@ private:
 
     bool sw_agc = false;
     RingBuffer<DSPCOMPLEX> SampleBuffer;
-    RingBuffer<DSPCOMPLEX> SpectrumSampleBuffer;
 };
 
 #endif // __LIMESDR__
@@ -67,13 +67,6 @@ int32_t CNullDevice::getSamples(DSPCOMPLEX *Buffer, int32_t Size)
     return Size;
 }
 
-std::vector<DSPCOMPLEX> CNullDevice::getSpectrumSamples(int size)
-{
-    std::vector<DSPCOMPLEX> sampleBuffer(size);
-    std::fill(sampleBuffer.begin(), sampleBuffer.end(), 0);
-    return sampleBuffer;
-}
-
 int32_t CNullDevice::getSamplesToRead()
 {
     return 0;
@@ -30,8 +30,10 @@
  *
  */
 
+#include <algorithm>
 #include <string>
 #include <iostream>
+#include <cstring>
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -58,6 +60,15 @@ static inline int64_t getMyTime(void)
 
 #define INPUT_FRAMEBUFFERSIZE 8 * 32768
 
+static int seek64(FILE *f, int64_t offset)
+{
+#if defined(_WIN32)
+    return _fseeki64(f, offset, SEEK_SET);
+#else
+    return fseeko(f, offset, SEEK_SET);
+#endif
+}
+
 CRAWFile::CRAWFile(RadioControllerInterface& radioController,
         bool throttle, bool rewind) :
     radioController(radioController),
@@ -66,8 +77,7 @@ CRAWFile::CRAWFile(RadioControllerInterface& radioController,
     fileName(""),
     fileFormat(CRAWFileFormat::Unknown),
     IQByteSize(1),
-    SampleBuffer(INPUT_FRAMEBUFFERSIZE),
-    SpectrumSampleBuffer(8*2048)
+    SampleBuffer(INPUT_FRAMEBUFFERSIZE)
 {
 }
 
@@ -120,7 +130,15 @@ void CRAWFile::reset()
 void CRAWFile::rewind()
 {
     if (filePointer) {
-        fseek(filePointer, 0, SEEK_SET);
+        seekRequest = 0;
+        endReached = false;
+    }
+}
+
+void CRAWFile::seekToFrame(size_t frame)
+{
+    if (filePointer) {
+        seekRequest = (int64_t)frame * DABParams(1).T_F;
         endReached = false;
     }
 }
@@ -157,6 +175,13 @@ CDeviceID CRAWFile::getID()
     return CDeviceID::RAWFILE;
 }
 
+bool CRAWFile::supportsRecording() const
+{
+    // The bytes read from the file are copied to the record tap
+    return fileFormat == CRAWFileFormat::U8 or
+        fileFormat == CRAWFileFormat::WIQ;
+}
+
 bool ends_with(const std::string& value, const std::string& ending)
 {
     if (ending.size() > value.size()) return false;
@@ -178,6 +203,10 @@ void CRAWFile::setFileName(const std::string& fileName,
         return;
     }
 
+    if (not openContainer()) {
+        return;
+    }
+
     readerOK = true;
     readerPausing = true;
     currPos = 0;
@@ -198,12 +227,32 @@ void CRAWFile::setFileHandle(int handle, const std::string& fileFormat)
         return;
     }
 
+    if (not openContainer()) {
+        return;
+    }
+
     readerOK = true;
     readerPausing = true;
     currPos = 0;
     thread = std::thread(&CRAWFile::run, this);
 }
 
+bool CRAWFile::openContainer()
+{
+    if (fileFormat != CRAWFileFormat::WIQ) {
+        return true;
+    }
+
+    container = std::make_unique<CIQContainerReader>();
+    if (not container->open(filePointer)) {
+        container.reset();
+        radioController.onMessage(message_level_t::Error,
+                QT_TRANSLATE_NOOP("CRadioController", "Unknown RAW file format"));
+        return false;
+    }
+    return true;
+}
+
 std::string CRAWFile::getFileName() const
 {
     return fileName;
@@ -224,18 +273,6 @@ int32_t CRAWFile::getSamples(DSPCOMPLEX* V, int32_t size)
     return convertSamples(SampleBuffer, V, size);
 }
 
-std::vector<DSPCOMPLEX> CRAWFile::getSpectrumSamples(int size)
-{
-    std::vector<DSPCOMPLEX> buffer(size);
-
-    int sizeRead = convertSamples(SpectrumSampleBuffer, buffer.data(), size);
-    if (sizeRead < size) {
-        buffer.resize(sizeRead);
-    }
-
-    return buffer;
-}
-
 int32_t CRAWFile::getSamplesToRead(void)
 {
     return SampleBuffer.GetRingBufferReadAvailable() / 2;
@@ -279,7 +316,6 @@ void CRAWFile::run(void)
             t = bufferSize;
         }
         SampleBuffer.putDataIntoBuffer(bi.data(), t);
-        SpectrumSampleBuffer.putDataIntoBuffer(bi.data(), t);
         putIntoRecordBuffer(*bi.data(), t);
         int64_t t_to_wait = nextStop - getMyTime();
         if (throttle and t_to_wait > 0)
@@ -300,6 +336,15 @@ int32_t CRAWFile::readBuffer(uint8_t* data, int32_t length)
         return 0;
     }
 
+    const int64_t seek = seekRequest.exchange(-1);
+    if (seek >= 0) {
+        applySeek(seek);
+    }
+
+    if (container) {
+        return readContainer(data, length);
+    }
+
     n = fread(data, sizeof(uint8_t), length, filePointer);
     currPos += n;
     if (n < length) {
@@ -309,7 +354,98 @@ int32_t CRAWFile::readBuffer(uint8_t* data, int32_t length)
             radioController.onMessage(message_level_t::Information,
                     QT_TRANSLATE_NOOP("CRadioController", "End of file, restarting"));
             SampleBuffer.FlushRingBuffer();
-            SpectrumSampleBuffer.FlushRingBuffer();
+            radioController.onRestartService();
+        }
+        else {
+            radioController.onMessage(message_level_t::Information, QT_TRANSLATE_NOOP("CRadioController", "End of file"));
+            endReached = true;
+            return 0;
+        }
+    }
+    return n & ~01;
+}
+
+void CRAWFile::applySeek(int64_t sample)
+{
+    if (container) {
+        const uint32_t samplesPerChunk = container->getSamplesPerChunk();
+        decodeQueue.clear();
+        nextChunkToDecode = sample / samplesPerChunk;
+        chunkSkipBytes = (sample % samplesPerChunk) * 2;
+        currentChunk.clear();
+        currentChunkPos = 0;
+        currPos = sample * 2;
+    }
+    else {
+        seek64(filePointer, sample * IQByteSize);
+        currPos = sample * IQByteSize;
+    }
+
+    SampleBuffer.FlushRingBuffer();
+    endReached = false;
+}
+
+bool CRAWFile::nextContainerChunk()
+{
+    // Keep one decoder busy per core, within reason
+    const size_t depth = std::min(std::max(std::thread::hardware_concurrency(), 2u), 4u);
+
+    while (decodeQueue.size() < depth and
+            nextChunkToDecode < container->getNumChunks()) {
+        IQChunk chunk;
+        if (not container->readChunk(nextChunkToDecode, chunk)) {
+            nextChunkToDecode = container->getNumChunks();
+            break;
+        }
+        nextChunkToDecode++;
+
+        decodeQueue.push_back(std::async(std::launch::async,
+                    [](const IQChunk& c) {
+                        std::vector<uint8_t> iq;
+                        if (not decodeIQChunk(c, iq)) {
+                            std::clog << "RAWFile: corrupt chunk" << std::endl;
+                            iq.clear();
+                        }
+                        return iq;
+                    }, std::move(chunk)));
+    }
+
+    if (decodeQueue.empty()) {
+        return false;
+    }
+
+    currentChunk = decodeQueue.front().get();
+    decodeQueue.pop_front();
+    currentChunkPos = std::min(chunkSkipBytes, currentChunk.size());
+    chunkSkipBytes = 0;
+    return true;
+}
+
+int32_t CRAWFile::readContainer(uint8_t* data, int32_t length)
+{
+    int32_t n = 0;
+    while (n < length) {
+        if (currentChunkPos >= currentChunk.size()) {
+            if (not nextContainerChunk()) {
+                break;
+            }
+            continue;
+        }
+
+        const size_t num = std::min((size_t)(length - n),
+                currentChunk.size() - currentChunkPos);
+        memcpy(data + n, currentChunk.data() + currentChunkPos, num);
+        currentChunkPos += num;
+        n += num;
+    }
+    currPos += n;
+
+    if (n < length) {
+        if (autoRewind) {
+            applySeek(0);
+            std::clog << "RAWFile:"  << "End of file, restarting" << std::endl;
+            radioController.onMessage(message_level_t::Information,
+                    QT_TRANSLATE_NOOP("CRadioController", "End of file, restarting"));
             radioController.onRestartService();
         }
         else {
@@ -333,8 +469,8 @@ int32_t CRAWFile::convertSamples(RingBuffer<uint8_t>& Buffer, DSPCOMPLEX *V, int
 
     int32_t amount = Buffer.getDataFromBuffer(temp.data(), IQByteSize * size);
 
-    // Unsigned 8-bit
-    if (fileFormat == CRAWFileFormat::U8) {
+    // Unsigned 8-bit, also used for the decoded .wiq chunks
+    if (fileFormat == CRAWFileFormat::U8 or fileFormat == CRAWFileFormat::WIQ) {
         for (int i = 0; i < amount / 2; i++)
             V[i] = DSPCOMPLEX(float(temp[2 * i] - 128) / 128.0,
                               float(temp[2 * i + 1] - 128) / 128.0);
@@ -392,6 +528,11 @@ void CRAWFile::setFileFormat(const std::string &fileFormat)
         this->fileFormat = CRAWFileFormat::COMPLEXF;
         IQByteSize = 8;
     }
+    else if(fileFormat == "wiq" or
+            (fileFormat == "auto" and ends_with(fileName, ".wiq"))) {
+        this->fileFormat = CRAWFileFormat::WIQ;
+        IQByteSize = 2;
+    }
     else if (fileFormat == "auto") {
         // Default to u8 for backward compatibility
         this->fileFormat = CRAWFileFormat::U8;
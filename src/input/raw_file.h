@@ -35,14 +35,18 @@
 
 #include <thread>
 #include <atomic>
+#include <deque>
+#include <future>
+#include <memory>
 
 #include "virtual_input.h"
+#include "iq_container.h"
 #include "dab-constants.h"
 #include "ringbuffer.h"
 #include "radio-controller.h"
 
 // Enum of available input device
-enum class CRAWFileFormat {U8, S8, S16LE, S16BE, COMPLEXF, Unknown};
+enum class CRAWFileFormat {U8, S8, S16LE, S16BE, COMPLEXF, WIQ, Unknown};
 
 class CRAWFile : public CVirtualInput {
 public:
@@ -55,7 +59,6 @@ public:
     void setFrequency(int Frequency);
     int getFrequency(void) const;
     int32_t getSamples(DSPCOMPLEX*, int32_t);
-    std::vector<DSPCOMPLEX> getSpectrumSamples(int size);
     int32_t getSamplesToRead(void);
     bool restart(void);
     bool is_ok(void);
@@ -68,6 +71,7 @@ public:
     void setAgc(bool AGC);
     std::string getDescription(void);
     CDeviceID getID(void);
+    bool supportsRecording(void) const;
 
     // Specific methods
     void setFileName(const std::string& FileName, const std::string& FileFormat);
@@ -76,6 +80,10 @@ public:
 
     bool endWasReached() const { return endReached; }
 
+    // Continue reading at the start of the given transmission frame,
+    // counted in mode I frames from the beginning of the file.
+    void seekToFrame(size_t frame);
+
 private:
     RadioControllerInterface& radioController;
     bool throttle;
@@ -86,11 +94,14 @@ private:
 
     void run(void);
     int32_t readBuffer(uint8_t*, int32_t);
+    int32_t readContainer(uint8_t*, int32_t);
+    bool nextContainerChunk(void);
+    void applySeek(int64_t sample);
     int32_t convertSamples(RingBuffer<uint8_t>& Buffer, DSPCOMPLEX* V, int32_t size);
     void setFileFormat(const std::string& fileFormat);
+    bool openContainer(void);
 
     RingBuffer<uint8_t> SampleBuffer;
-    RingBuffer<uint8_t> SpectrumSampleBuffer;
     FILE* filePointer = nullptr;
     bool readerOK = false;
     bool readerPausing = false;
@@ -98,6 +109,18 @@ private:
     std::atomic<bool> ExitCondition = ATOMIC_VAR_INIT(false);
     int64_t currPos = 0;
 
+    // Sample to seek to, applied by the reader thread
+    std::atomic<int64_t> seekRequest = ATOMIC_VAR_INIT(-1);
+
+    // .wiq recordings. The chunks following the current one are decoded
+    // in parallel in the background.
+    std::unique_ptr<CIQContainerReader> container;
+    std::deque<std::future<std::vector<uint8_t> > > decodeQueue;
+    size_t nextChunkToDecode = 0;
+    std::vector<uint8_t> currentChunk;
+    size_t currentChunkPos = 0;
+    size_t chunkSkipBytes = 0;
+
     std::thread thread;
 };
 
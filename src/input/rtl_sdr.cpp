@@ -55,8 +55,7 @@ int __attribute__((weak)) rtlsdr_set_bias_tee(rtlsdr_dev_t *dev, int on)
 
 CRTL_SDR::CRTL_SDR(RadioControllerInterface& radioController) :
     radioController(radioController),
-    sampleBuffer(1024 * 1024),
-    spectrumSampleBuffer(8192)
+    sampleBuffer(1024 * 1024)
 {
     open_device();
 }
@@ -155,7 +154,6 @@ bool CRTL_SDR::restart(void)
     }
 
     sampleBuffer.FlushRingBuffer();
-    spectrumSampleBuffer.FlushRingBuffer();
     ret = rtlsdr_reset_buffer(device);
     if (ret < 0)
         return false;
@@ -270,6 +268,11 @@ CDeviceID CRTL_SDR::getID()
     return CDeviceID::RTL_SDR;
 }
 
+bool CRTL_SDR::supportsRecording() const
+{
+    return true;
+}
+
 void CRTL_SDR::agc_timer_thread(void)
 {
     while (rtlsdrRunning && not rtlsdrUnplugged) {
@@ -312,40 +315,30 @@ void CRTL_SDR::agc_timer_thread(void)
     }
 }
 
-int32_t CRTL_SDR::getSamples(DSPCOMPLEX *buffer, int32_t size)
+RawSampleFormat CRTL_SDR::getRawSampleFormat(void) const
 {
-    std::vector<uint8_t> tempBuffer(2 * size);
-
-    int32_t amount = sampleBuffer.getDataFromBuffer(tempBuffer.data(), 2 * size);
-
-    // Normalise samples
-    for (int i = 0; i < amount / 2; i++) {
-        buffer[i] = DSPCOMPLEX(
-                (float(tempBuffer[2 * i] - 128)) / 128.0,
-                (float(tempBuffer[2 * i + 1] - 128)) / 128.0);
-    }
+    RawSampleFormat format;
+    format.type = RawSampleFormat::Type::U8;
+    format.offset = 128.0f;
+    format.scale = 1.0f / 128.0f;
+    return format;
+}
 
+int32_t CRTL_SDR::getRawSamples(void *buffer, int32_t size)
+{
+    int32_t amount = sampleBuffer.getDataFromBuffer(buffer, 2 * size);
     return amount / 2;
 }
 
-std::vector<DSPCOMPLEX> CRTL_SDR::getSpectrumSamples(int size)
+int32_t CRTL_SDR::getSamples(DSPCOMPLEX *buffer, int32_t size)
 {
-    std::vector<uint8_t> tempBuffer(2 * size);
-
-    // Get samples
-    int32_t amount = spectrumSampleBuffer.getDataFromBuffer(
-            tempBuffer.data(), 2 * size);
-
-    std::vector<DSPCOMPLEX> buffer(amount / 2);
-
-    // Convert samples into generic format
-    for (int i = 0; i < amount / 2; i++) {
-        buffer[i] = DSPCOMPLEX(
-                (float(tempBuffer[2 * i] - 128)) / 128.0,
-                (float(tempBuffer[2 * i + 1] - 128)) / 128.0);
+    if (sampleScratch.size() < 2 * (size_t)size) {
+        sampleScratch.resize(2 * size);
     }
 
-    return buffer;
+    int32_t amount = getRawSamples(sampleScratch.data(), size);
+    convertRawSamples(sampleScratch.data(), getRawSampleFormat(), buffer, amount);
+    return amount;
 }
 
 int32_t CRTL_SDR::getSamplesToRead(void)
@@ -372,7 +365,6 @@ void CRTL_SDR::rtlsdr_read_callback(uint8_t* buf, uint32_t len, void* ctx)
         if ((len - tmp) > 0)
             rtlsdr->sampleCounter += len - tmp;
 
-        rtlsdr->spectrumSampleBuffer.putDataIntoBuffer(buf, len);
         rtlsdr->putIntoRecordBuffer(*buf, len);
 
         // Check if device is overloaded
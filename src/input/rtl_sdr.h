@@ -61,7 +61,8 @@ public:
     void stop(void);
     void reset(void);
     int32_t getSamples(DSPCOMPLEX *buffer, int32_t size);
-    std::vector<DSPCOMPLEX> getSpectrumSamples(int size);
+    RawSampleFormat getRawSampleFormat(void) const;
+    int32_t getRawSamples(void *buffer, int32_t size);
     int32_t getSamplesToRead(void);
     void setFrequency(int Frequency);
     int getFrequency(void) const;
@@ -73,6 +74,7 @@ public:
     bool setDeviceParam(DeviceParam param, int value);
 
     CDeviceID getID(void);
+    bool supportsRecording(void) const;
 
 private:
     std::thread agcThread;
@@ -95,7 +97,8 @@ private:
     void agc_timer_thread(void);
 
     RingBuffer<uint8_t> sampleBuffer;
-    RingBuffer<uint8_t> spectrumSampleBuffer;
+    // Conversion buffer for getSamples()
+    std::vector<uint8_t> sampleScratch;
     struct rtlsdr_dev *device = nullptr;
     int32_t sampleCounter = 0;
 
@@ -30,6 +30,7 @@
  *
  */
 
+#include <algorithm>
 #include <iostream>
 #include <sys/time.h>
 
@@ -62,6 +63,12 @@ enum rtlsdr_tuner {
 
 #define ONE_BYTE 8
 
+// Maximum number of bytes per recv() call
+#define RECEIVE_CHUNK_SIZE (256 * 1024)
+// Number of samples the receiver may read ahead of the nominal rate
+#define RELEASE_AHEAD_SAMPLES 32768
+#define STATS_INTERVAL_US 10000000
+
 static inline int64_t getMyTime(void)
 {
     struct timeval tv;
@@ -72,9 +79,7 @@ static inline int64_t getMyTime(void)
 
 CRTL_TCP_Client::CRTL_TCP_Client(RadioControllerInterface& radioController) :
     radioController(radioController),
-    sampleBuffer(32 * 32768),
-    sampleNetworkBuffer(256 * 32768),
-    spectrumSampleBuffer(8192)
+    sampleBuffer(256 * 32768)
 {
     memset(&dongleInfo, 0, sizeof(dongle_info_t));
     dongleInfo.tuner_type = RTLSDR_TUNER_UNKNOWN;
@@ -106,7 +111,7 @@ bool CRTL_TCP_Client::restart(void)
     // Clean up stale thread objects from previous failed starts before
     // creating new worker threads. Assigning over a joinable std::thread
     // would call std::terminate.
-    if (agcThread.joinable() || receiveThread.joinable() || networkBufferThread.joinable()) {
+    if (agcThread.joinable() || receiveThread.joinable()) {
         std::unique_lock<std::mutex> lock(mutex);
         sock.close();
         rtlsdrRunning = false;
@@ -120,15 +125,10 @@ bool CRTL_TCP_Client::restart(void)
         if (agcThread.joinable()) {
             agcThread.join();
         }
-        if (networkBufferThread.joinable()) {
-            networkBufferThread.join();
-        }
     }
 
     rtlsdrRunning = true;
 
-    networkBufferThread = std::thread(&CRTL_TCP_Client::networkBufferCopy, this);
-
     receiveThread = std::thread(&CRTL_TCP_Client::receiveAndReconnect, this);
 
     // Wait so that the other thread has a chance to establish the connection
@@ -169,206 +169,288 @@ void CRTL_TCP_Client::stop(void)
         agcThread.join();
     }
 
-    if (networkBufferThread.joinable()) {
-        networkBufferThread.join();
-    }
-
     connected = false;
 }
 
-static int32_t read_convert_from_buffer(
-        RingBuffer<uint8_t>& buffer,
-        DSPCOMPLEX *v, int32_t size)
+RawSampleFormat CRTL_TCP_Client::getRawSampleFormat(void) const
 {
-    int32_t amount, i;
-    std::vector<uint8_t> tempBuffer(2 * size);
-
-    // Get data from the ring buffer
-    amount = buffer.getDataFromBuffer(tempBuffer.data(), 2 * size);
-    for (i = 0; i < amount / 2; i ++)
-        v[i] = DSPCOMPLEX(((float)tempBuffer[2 * i] - 128.0f) / 128.0f,
-                          ((float)tempBuffer[2 * i + 1] - 128.0f) / 128.0f);
-    return amount / 2;
+    RawSampleFormat format;
+    format.type = RawSampleFormat::Type::U8;
+    format.offset = 128.0f;
+    format.scale = 1.0f / 128.0f;
+    return format;
 }
 
-int32_t CRTL_TCP_Client::getSamples(DSPCOMPLEX *v, int32_t size)
+int32_t CRTL_TCP_Client::getRawSamples(void *buffer, int32_t size)
 {
-    return read_convert_from_buffer(sampleBuffer, v, size);
+    const int32_t amount = sampleBuffer.getDataFromBuffer(buffer, 2 * size) / 2;
+    samplesReleased += amount;
+    return amount;
 }
 
-std::vector<DSPCOMPLEX> CRTL_TCP_Client::getSpectrumSamples(int size)
+int32_t CRTL_TCP_Client::getSamples(DSPCOMPLEX *v, int32_t size)
 {
-    std::vector<DSPCOMPLEX> buffer(size);
-    int sizeRead = read_convert_from_buffer(spectrumSampleBuffer, buffer.data(), size);
-    if (sizeRead < size) {
-        buffer.resize(sizeRead);
+    if (sampleScratch.size() < 2 * (size_t)size) {
+        sampleScratch.resize(2 * size);
     }
-    return buffer;
+
+    const int32_t amount = getRawSamples(sampleScratch.data(), size);
+    convertRawSamples(sampleScratch.data(), getRawSampleFormat(), v, amount);
+    return amount;
 }
 
 int32_t CRTL_TCP_Client::getSamplesToRead(void)
 {
-    return sampleBuffer.GetRingBufferReadAvailable() / 2;
+    // Hold the samples back until the jitter buffer is filled, then
+    // release them at the nominal sample rate.
+    if (not bufferPrefilled) {
+        releasing = false;
+        return 0;
+    }
+
+    const int64_t now = getMyTime();
+    if (not releasing) {
+        releasing = true;
+        releaseStart_us = now;
+        samplesReleased = 0;
+    }
+
+    const int64_t available = sampleBuffer.GetRingBufferReadAvailable() / 2;
+    int64_t allowed = (now - releaseStart_us) * INPUT_RATE / 1000000 +
+        RELEASE_AHEAD_SAMPLES - samplesReleased;
+
+    if (allowed > available) {
+        // The network did not deliver in time. Do not accumulate credit
+        // that would later let the receiver drain the buffer in a burst.
+        releaseStart_us = now - (samplesReleased + available - RELEASE_AHEAD_SAMPLES) *
+            1000000 / INPUT_RATE;
+        allowed = available;
+    }
+
+    return std::max<int64_t>(allowed, 0);
 }
 
 void CRTL_TCP_Client::reset(void)
 {
+    bufferPrefilled = false;
     sampleBuffer.FlushRingBuffer();
-    sampleNetworkBuffer.FlushRingBuffer();
-    spectrumSampleBuffer.FlushRingBuffer();
-    firstFilledNetworkBuffer = false;
 }
 
-void CRTL_TCP_Client::receiveData(void)
+bool CRTL_TCP_Client::handleReceiveError()
 {
-    std::vector<uint8_t> buffer(8192);
+#if defined(_WIN32)
+    const int error = WSAGetLastError();
+    if (error == WSAEINTR ||
+            error == WSAECONNABORTED ||
+            error == WSAENOTSOCK) {
+        return true;
+    }
+    else if (error == WSAECONNRESET || error == WSAEBADF) {
+        handleDisconnect();
+    }
+    else {
+        std::clog << "RTL_TCP_CLIENT recv error: " << error << std::endl;
+        handleDisconnect();
+    }
+#else
+    if (errno == EAGAIN || errno == EINTR) {
+        return true;
+    }
+    else if (errno == ECONNRESET || errno == EBADF) {
+        handleDisconnect();
+    }
+    else {
+        std::string errstr = strerror(errno);
+        std::clog << "RTL_TCP_CLIENT recv error: " << errstr << std::endl;
+        handleDisconnect();
+    }
+#endif
+    return false;
+}
 
+bool CRTL_TCP_Client::receiveDongleInfo()
+{
+    std::array<uint8_t, sizeof(dongle_info_t)> buffer;
     size_t read = 0;
 
     while (sock.valid() && read < buffer.size()) {
-        const size_t remain = buffer.size() - read;
-
-        ssize_t ret = sock.recv(buffer.data() + read, remain, 0);
+        ssize_t ret = sock.recv(buffer.data() + read, buffer.size() - read, 0);
 
         if (ret == 0) {
             handleDisconnect();
         }
         else if (ret == -1) {
-#if defined(_WIN32)
-            if (WSAGetLastError() == WSAEINTR ||
-                    WSAGetLastError() == WSAECONNABORTED ||
-                    WSAGetLastError() == WSAENOTSOCK) {
-                continue;
-            }
-            else if (WSAGetLastError() == WSAECONNRESET || WSAGetLastError() == WSAEBADF) {
-                handleDisconnect();
+            if (not handleReceiveError()) {
+                return false;
             }
-            else {
-                int error = WSAGetLastError();
-                std::clog << "RTL_TCP_CLIENT recv error: " << error << std::endl;
-                handleDisconnect();
-                return;
-            }
-#else
-            if (errno == EAGAIN) {
-                continue;
-            }
-            else if (errno == EINTR) {
-                continue;
-            }
-            else if (errno == ECONNRESET || errno == EBADF) {
-                handleDisconnect();
-            }
-            else {
-                std::string errstr = strerror(errno);
-                std::clog << "RTL_TCP_CLIENT recv error: " << errstr << std::endl;
-                handleDisconnect();
-                return;
-            }
-#endif
         }
         else {
             read += ret;
         }
 
         if (not rtlsdrRunning) {
-            break;
+            return false;
         }
     }
 
-    if (read == 0 || !connected || !sock.valid()) {
-        return;
+    if (read < buffer.size() || !connected || !sock.valid()) {
+        // Incomplete first packet (e.g. connection closed during startup).
+        return false;
     }
 
-    size_t payloadOffset = 0;
-
-    if (firstData) {
-        if (read < sizeof(dongle_info_t)) {
-            // Incomplete first packet (e.g. connection closed during startup).
-            return;
+    firstData = false;
+
+    // Get dongle information
+    ::memcpy(&dongleInfo, buffer.data(), sizeof(dongle_info_t));
+
+    // Convert the byte order
+    dongleInfo.tuner_type = ntohl(dongleInfo.tuner_type);
+    dongleInfo.tuner_gain_count = ntohl(dongleInfo.tuner_gain_count);
+
+    if(dongleInfo.magic[0] == 'R' &&
+            dongleInfo.magic[1] == 'T' &&
+            dongleInfo.magic[2] == 'L' &&
+            dongleInfo.magic[3] == '0') {
+        std::string TunerType;
+        switch(dongleInfo.tuner_type)
+        {
+            case RTLSDR_TUNER_UNKNOWN: TunerType = "Unknown"; break;
+            case RTLSDR_TUNER_E4000: TunerType = "E4000"; break;
+            case RTLSDR_TUNER_FC0012: TunerType = "FC0012"; break;
+            case RTLSDR_TUNER_FC0013: TunerType = "FC0013"; break;
+            case RTLSDR_TUNER_FC2580: TunerType = "FC2580"; break;
+            case RTLSDR_TUNER_R820T: TunerType = "R820T"; break;
+            case RTLSDR_TUNER_R828D: TunerType = "R828D"; break;
+            default: TunerType = "Unknown";
         }
+        std::clog << "RTL_TCP_CLIENT: Tuner type: " <<
+            dongleInfo.tuner_type << " " << TunerType << std::endl;
+        std::clog << "RTL_TCP_CLIENT: Tuner gain count: " <<
+            dongleInfo.tuner_gain_count << std::endl;
+        
+        // Always use manual gain, the AGC is implemented in software
+        setGainMode(1);
+        setGain(currentGainCount);
+        sendRate(INPUT_RATE);
+        sendVFO(frequency);  
 
-        firstData = false;
-
-        // Get dongle information
-        ::memcpy(&dongleInfo, buffer.data(), sizeof(dongle_info_t));
-
-        // Convert the byte order
-        dongleInfo.tuner_type = ntohl(dongleInfo.tuner_type);
-        dongleInfo.tuner_gain_count = ntohl(dongleInfo.tuner_gain_count);
-
-        if(dongleInfo.magic[0] == 'R' &&
-                dongleInfo.magic[1] == 'T' &&
-                dongleInfo.magic[2] == 'L' &&
-                dongleInfo.magic[3] == '0') {
-            std::string TunerType;
-            switch(dongleInfo.tuner_type)
-            {
-                case RTLSDR_TUNER_UNKNOWN: TunerType = "Unknown"; break;
-                case RTLSDR_TUNER_E4000: TunerType = "E4000"; break;
-                case RTLSDR_TUNER_FC0012: TunerType = "FC0012"; break;
-                case RTLSDR_TUNER_FC0013: TunerType = "FC0013"; break;
-                case RTLSDR_TUNER_FC2580: TunerType = "FC2580"; break;
-                case RTLSDR_TUNER_R820T: TunerType = "R820T"; break;
-                case RTLSDR_TUNER_R828D: TunerType = "R828D"; break;
-                default: TunerType = "Unknown";
-            }
-            std::clog << "RTL_TCP_CLIENT: Tuner type: " <<
-                dongleInfo.tuner_type << " " << TunerType << std::endl;
-            std::clog << "RTL_TCP_CLIENT: Tuner gain count: " <<
-                dongleInfo.tuner_gain_count << std::endl;
-            
-            // Always use manual gain, the AGC is implemented in software
-            setGainMode(1);
-            setGain(currentGainCount);
-            sendRate(INPUT_RATE);
-            sendVFO(frequency);  
-
-            payloadOffset = sizeof(dongle_info_t);
-        }
-        else {
-            std::clog << "RTL_TCP_CLIENT: Didn't find the \"RTL0\" magic key." <<
-                std::endl;
-            handleDisconnect();
-            agcRunning = false;
-            rtlsdrRunning = false;
+    }
+    else {
+        std::clog << "RTL_TCP_CLIENT: Didn't find the \"RTL0\" magic key." <<
+            std::endl;
+        handleDisconnect();
+        agcRunning = false;
+        rtlsdrRunning = false;
+        return false;
+    }
+
+    std::clog << "RTL_TCP_CLIENT: Socket receive buffer " <<
+        sock.getReceiveBufferSize() << " bytes" << std::endl;
+    return true;
+}
+
+void CRTL_TCP_Client::receiveData(void)
+{
+    if (firstData) {
+        if (not receiveDongleInfo()) {
             return;
         }
+        statsStart_us = lastReceive_us = getMyTime();
     }
 
-    if (read <= payloadOffset) {
+    // Receive directly into the free part of the sample buffer, which
+    // can be split in two regions when it wraps around.
+    void *region1 = nullptr;
+    void *region2 = nullptr;
+    int32_t size1 = 0;
+    int32_t size2 = 0;
+    sampleBuffer.GetRingBufferWriteRegions(RECEIVE_CHUNK_SIZE,
+            &region1, &size1, &region2, &size2);
+
+    if (size1 == 0) {
+        // The receiver does not keep up. Stop reading, so that TCP flow
+        // control slows down the server instead of us dropping samples.
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        bufferFullTime_us += 1000;
         return;
     }
 
-    const size_t payloadSize = read - payloadOffset;
-    sampleNetworkBuffer.putDataIntoBuffer(buffer.data() + payloadOffset, payloadSize);
-
-    // First fill the complete buffer to avoid sound outtages if the stream data rate is not stable e.g. over WIFI
-    if(!firstFilledNetworkBuffer) {
-        float bufferFill = (float) sampleNetworkBuffer.GetRingBufferReadAvailable() / sampleNetworkBuffer.GetBufferSize() * 100;
-
-        // Wait for 50% filled buffer
-        if(bufferFill >= 50)
-            firstFilledNetworkBuffer = true;
+    ssize_t ret = sock.recv(region1, size1, region2, size2, 0);
 
-        if((getMyTime() - oldTime_us > 100e3) || firstFilledNetworkBuffer) {
-            //std::clog << "RTL_TCP_CLIENT: Fill network buffer " << bufferFill << "%" << std::endl;
-            oldTime_us = getMyTime();
-        }
+    if (ret == 0) {
+        handleDisconnect();
+        return;
+    }
+    else if (ret == -1) {
+        handleReceiveError();
+        return;
     }
-
 
     // Check if device is overloaded
     minAmplitude = 255;
     maxAmplitude = 0;
 
-    for (size_t i = payloadOffset; i < read; i++) {
-        const auto b = buffer[i];
+    const size_t in_region1 = std::min((size_t)ret, (size_t)size1);
+    const uint8_t *data = static_cast<const uint8_t*>(region1);
+    for (size_t i = 0; i < (size_t)ret; i++) {
+        if (i == in_region1) {
+            data = static_cast<const uint8_t*>(region2) - in_region1;
+        }
+        const auto b = data[i];
         if (minAmplitude > b)
             minAmplitude = b;
         if (maxAmplitude < b)
             maxAmplitude = b;
     }
+
+    putIntoRecordBuffer(*static_cast<uint8_t*>(region1), in_region1);
+    if ((size_t)ret > in_region1) {
+        putIntoRecordBuffer(*static_cast<uint8_t*>(region2), ret - in_region1);
+    }
+
+    sampleBuffer.AdvanceRingBufferWriteIndex(ret);
+
+    // First fill half of the buffer to avoid sound outtages if the stream
+    // data rate is not stable e.g. over WIFI
+    if (not bufferPrefilled and
+            sampleBuffer.GetRingBufferReadAvailable() >= sampleBuffer.GetBufferSize() / 2) {
+        bufferPrefilled = true;
+    }
+
+    updateReceiveStats(ret);
+}
+
+void CRTL_TCP_Client::updateReceiveStats(size_t bytes)
+{
+    const int64_t now = getMyTime();
+
+    numReceiveCalls++;
+    receivedBytes += bytes;
+    maxReceiveGap_us = std::max(maxReceiveGap_us, now - lastReceive_us);
+    lastReceive_us = now;
+
+    if (now - statsStart_us >= STATS_INTERVAL_US) {
+        const float fill = 100.0f * sampleBuffer.GetRingBufferReadAvailable() /
+            sampleBuffer.GetBufferSize();
+        const float rate = 1e6f * receivedBytes / 2 / (now - statsStart_us);
+
+        std::clog << "RTL_TCP_CLIENT: " << rate / 1e3 << " kS/s, " <<
+            numReceiveCalls << " receives of " <<
+            receivedBytes / numReceiveCalls << " bytes on average, " <<
+            "max gap " << maxReceiveGap_us / 1000 << " ms, " <<
+            "buffer " << (int)fill << "% full";
+        if (bufferFullTime_us > 0) {
+            std::clog << ", receiver stalled during " <<
+                bufferFullTime_us / 1000 << " ms";
+        }
+        std::clog << std::endl;
+
+        statsStart_us = now;
+        maxReceiveGap_us = 0;
+        bufferFullTime_us = 0;
+        numReceiveCalls = 0;
+        receivedBytes = 0;
+    }
 }
 
 void CRTL_TCP_Client::handleDisconnect()
@@ -467,6 +549,23 @@ CDeviceID CRTL_TCP_Client::getID()
     return CDeviceID::RTL_TCP;
 }
 
+bool CRTL_TCP_Client::supportsRecording() const
+{
+    return true;
+}
+
+bool CRTL_TCP_Client::setDeviceParam(DeviceParam param, int value)
+{
+    switch (param) {
+        case DeviceParam::RTLTCPReceiveBufferSize:
+            // Takes effect on the next connection
+            receiveBufferSize = value;
+            return true;
+        default:
+            return false;
+    }
+}
+
 void CRTL_TCP_Client::setServerAddress(const std::string& serverAddress)
 {
     this->serverAddress = serverAddress;
@@ -492,7 +591,8 @@ void CRTL_TCP_Client::receiveAndReconnect()
                     serverAddress << ":" << serverPort << std::endl;
 
                 try {
-                    connected = sock.connect(serverAddress, serverPort, 2);
+                    connected = sock.connect(serverAddress, serverPort, 2,
+                            receiveBufferSize);
                 }
                 catch(const std::runtime_error& e) {
                     std::clog << "RTL_TCP_CLIENT: " << e.what() << std::endl;
@@ -566,66 +666,6 @@ void CRTL_TCP_Client::receiveAndReconnect()
     }
 }
 
-#define NETWORK_BUFFER_READ_SAMPLES 32768
-void CRTL_TCP_Client::networkBufferCopy()
-{
-    try {
-        std::vector<uint8_t> tempBuffer(NETWORK_BUFFER_READ_SAMPLES * 2);
-
-        while (rtlsdrRunning) {
-            if(!firstFilledNetworkBuffer) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                nextStop_us = getMyTime();
-                continue;
-            }
-
-            int32_t samples = NETWORK_BUFFER_READ_SAMPLES;
-
-            // Figure out the max samples to read from network buffer
-            int32_t samplesInBuffer = sampleNetworkBuffer.GetRingBufferReadAvailable() / 2;
-            if(samplesInBuffer < samples)
-                samples = samplesInBuffer;
-
-            if(samples == 0) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                nextStop_us = getMyTime();
-                continue;
-            }
-
-            // Read data
-            int32_t amount = sampleNetworkBuffer.getDataFromBuffer(tempBuffer.data(), 2 * samples);
-
-            // Write data to standard buffers
-            sampleBuffer.putDataIntoBuffer(tempBuffer.data(), amount);
-            spectrumSampleBuffer.putDataIntoBuffer(tempBuffer.data(), amount);
-
-            if(getMyTime() - oldTime_us > 500e3) { // 500 ms
-
-                // float bufferFill = (float) sampleNetworkBuffer.GetRingBufferReadAvailable() / sampleNetworkBuffer.GetBufferSize() * 100;
-                //std::clog << "RTL_TCP_CLIENT: Network buffer fill level " << bufferFill << "%" << std::endl;
-
-                oldTime_us = getMyTime();
-            }
-
-
-            uint32_t period_us = samples / ((float) INPUT_RATE / 1e6);
-            nextStop_us += period_us;
-            int64_t timeToWait_us = nextStop_us - getMyTime();
-
-            // Send thread to sleep
-            std::this_thread::sleep_for(std::chrono::microseconds(timeToWait_us));
-        }
-    }
-    catch (const std::exception& e) {
-        std::clog << "RTL_TCP_CLIENT network thread exception: " << e.what() << std::endl;
-        rtlsdrRunning = false;
-    }
-    catch (...) {
-        std::clog << "RTL_TCP_CLIENT network thread unknown exception" << std::endl;
-        rtlsdrRunning = false;
-    }
-}
-
 void CRTL_TCP_Client::agcTimer(void)
 {
     try {
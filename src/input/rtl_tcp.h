@@ -34,6 +34,7 @@
 #define __RTL_TCP_CLIENT
 
 #include <array>
+#include <atomic>
 #include <string>
 #include <thread>
 #include <mutex>
@@ -61,7 +62,8 @@ public:
     bool restart(void);
     bool is_ok(void);
     int32_t getSamples(DSPCOMPLEX* V, int32_t size);
-    std::vector<DSPCOMPLEX> getSpectrumSamples(int size);
+    RawSampleFormat getRawSampleFormat(void) const;
+    int32_t getRawSamples(void *buffer, int32_t size);
     int32_t getSamplesToRead(void);
     void reset(void);
     float getGain(void) const;
@@ -70,6 +72,8 @@ public:
     void setAgc(bool AGC);
     std::string getDescription(void);
     CDeviceID getID(void);
+    bool supportsRecording(void) const;
+    bool setDeviceParam(DeviceParam param, int value);
 
     // Specific methods
     void setServerAddress(const std::string& serverAddress);
@@ -81,16 +85,17 @@ private:
     void stop(void);
     void agcTimer(void);
     void receiveData(void);
+    bool receiveDongleInfo(void);
+    bool handleReceiveError(void);
     void receiveAndReconnect(void);
-    void networkBufferCopy(void);
     void handleDisconnect(void);
+    void updateReceiveStats(size_t bytes);
 
     std::mutex mutex;
     Socket sock;
     std::thread receiveThread;
     bool agcRunning = false;
     std::thread agcThread;
-    std::thread networkBufferThread;
 
     float currentGain = 0;
     uint16_t currentGainCount = 0;
@@ -99,18 +104,34 @@ private:
     bool isAGC = true;
     bool isHwAGC = false;
     int frequency = kHz(220000);
+    // The network data is received directly into this buffer, which
+    // also serves as jitter buffer.
     RingBuffer<uint8_t> sampleBuffer;
-    RingBuffer<uint8_t> sampleNetworkBuffer;
-    RingBuffer<uint8_t> spectrumSampleBuffer;
+    // Conversion buffer for getSamples()
+    std::vector<uint8_t> sampleScratch;
     bool connected = false;
     bool rtlsdrRunning = false;
     std::string serverAddress = "127.0.0.1";
     uint16_t serverPort = 1234;
 
     bool firstData = true;
-    bool firstFilledNetworkBuffer = false;
-    int64_t oldTime_us = 0;
-    int64_t nextStop_us = 0;
+    int receiveBufferSize = 1024 * 1024;
+
+    // Set by the receive thread once the sample buffer is half full.
+    // From then on, the samples are released to the receiver at the
+    // nominal sample rate, see getSamplesToRead().
+    std::atomic<bool> bufferPrefilled = ATOMIC_VAR_INIT(false);
+    bool releasing = false;
+    int64_t releaseStart_us = 0;
+    int64_t samplesReleased = 0;
+
+    // Receive statistics, logged periodically by the receive thread
+    int64_t statsStart_us = 0;
+    int64_t lastReceive_us = 0;
+    int64_t maxReceiveGap_us = 0;
+    int64_t bufferFullTime_us = 0;
+    size_t numReceiveCalls = 0;
+    size_t receivedBytes = 0;
     dongle_info_t dongleInfo;
 
     // Gain values for the different tuners
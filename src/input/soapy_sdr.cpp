@@ -44,8 +44,7 @@ using namespace std;
 
 CSoapySdr::CSoapySdr(RadioControllerInterface& radioController) :
     radioController(radioController),
-    m_sampleBuffer(1024 * 1024),
-    m_spectrumSampleBuffer(8192)
+    m_sampleBuffer(1024 * 1024)
 {
     //enumerate devices
     const std::string args ="";
@@ -96,7 +95,6 @@ bool CSoapySdr::restart()
     }
 
     m_sampleBuffer.FlushRingBuffer();
-    m_spectrumSampleBuffer.FlushRingBuffer();
 
     try {
         m_device = SoapySDR::Device::make(m_driver_args);
@@ -119,11 +117,11 @@ bool CSoapySdr::restart()
     }
     std::clog << ss.str().c_str() << std::endl;
 
-    m_device->setMasterClockRate(INPUT_RATE*16);
+    m_device->setMasterClockRate(m_sample_rate*16);
     std::clog << "SoapySDR master clock rate set to " <<
         m_device->getMasterClockRate()/1000.0 << " kHz" << std::endl;
 
-    m_device->setSampleRate(SOAPY_SDR_RX, 0, INPUT_RATE);
+    m_device->setSampleRate(SOAPY_SDR_RX, 0, m_sample_rate);
     std::clog << "SoapySDR:Actual RX rate: " <<
         m_device->getSampleRate(SOAPY_SDR_RX, 0) / 1000.0 <<
         " ksps." << std::endl;
@@ -207,16 +205,6 @@ int32_t CSoapySdr::getSamples(DSPCOMPLEX *Buffer, int32_t Size)
     return amount;
 }
 
-std::vector<DSPCOMPLEX> CSoapySdr::getSpectrumSamples(int size)
-{
-    std::vector<DSPCOMPLEX> sampleBuffer(size);
-    int32_t amount = m_spectrumSampleBuffer.getDataFromBuffer(sampleBuffer.data(), size);
-    if (amount < size) {
-        sampleBuffer.resize(amount);
-    }
-    return sampleBuffer;
-}
-
 int32_t CSoapySdr::getSamplesToRead()
 {
     return m_sampleBuffer.GetRingBufferReadAvailable();
@@ -357,6 +345,23 @@ bool CSoapySdr::setDeviceParam(DeviceParam param, const std::string& value)
     return false;
 }
 
+bool CSoapySdr::setDeviceParam(DeviceParam param, int value)
+{
+    switch (param) {
+        case DeviceParam::SoapySDRSampleRate:
+            if (m_sample_rate != value) {
+                m_sample_rate = value;
+                if (m_running) {
+                    stop();
+                    restart();
+                }
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
 void CSoapySdr::workerthread()
 {
     std::vector<size_t> channels;
@@ -380,22 +385,45 @@ void CSoapySdr::workerthread()
 
 void CSoapySdr::process(SoapySDR::Stream *stream)
 {
+    // Stream MTU is in samples, not bytes. It does not change while the
+    // stream is set up.
+    assert(m_device != nullptr);
+    const size_t mtu = m_device->getStreamMTU(stream);
+
+    // Only used when the sample ring is full and the samples get dropped
+    std::vector<DSPCOMPLEX> discardBuffer;
+    size_t droppedSamples = 0;
+
     size_t frames = 0;
     while (m_running) {
         frames++;
 
-        // Stream MTU is in samples, not bytes.
-        const size_t mtu = m_device->getStreamMTU(stream);
-
-        const size_t samps_to_read = mtu; // Always read MTU samples
-        std::vector<DSPCOMPLEX> buf(samps_to_read);
+        // Let the device write straight into the sample ring. When the
+        // free region wraps around, the first part is filled now and the
+        // rest on the next iteration.
+        void *region1 = nullptr;
+        void *region2 = nullptr;
+        int32_t size1 = 0;
+        int32_t size2 = 0;
+        m_sampleBuffer.GetRingBufferWriteRegions(mtu,
+                &region1, &size1, &region2, &size2);
+
+        DSPCOMPLEX *buf = static_cast<DSPCOMPLEX*>(region1);
+        size_t samps_to_read = size1;
+        const bool ring_full = (size1 == 0);
+        if (ring_full) {
+            if (discardBuffer.empty()) {
+                discardBuffer.resize(mtu);
+            }
+            buf = discardBuffer.data();
+            samps_to_read = mtu;
+        }
 
         void *buffs[1];
-        buffs[0] = buf.data();
+        buffs[0] = buf;
 
         int flags = 0;
         long long timeNs = 0;
-        assert(m_device != nullptr);
         int ret = m_device->readStream(
                 stream, buffs, samps_to_read, flags, timeNs);
 
@@ -415,13 +443,11 @@ void CSoapySdr::process(SoapySDR::Stream *stream)
             m_running = false;
         }
         else {
-            buf.resize(ret);
-
             if (m_sw_agc and (frames % 200) == 0) {
                 float maxnorm = 0;
-                for (const DSPCOMPLEX& z : buf) {
-                    if (norm(z) > maxnorm) {
-                        maxnorm = norm(z);
+                for (int i = 0; i < ret; i++) {
+                    if (norm(buf[i]) > maxnorm) {
+                        maxnorm = norm(buf[i]);
                     }
                 }
 
@@ -435,8 +461,22 @@ void CSoapySdr::process(SoapySDR::Stream *stream)
                 }
             }
 
-            m_sampleBuffer.putDataIntoBuffer(buf.data(), ret);
-            m_spectrumSampleBuffer.putDataIntoBuffer(buf.data(), ret);
+            if (ring_full) {
+                m_sampleBuffer.onDroppedData(ret);
+                if (droppedSamples == 0) {
+                    std::clog << "SoapySDR: sample buffer full, dropping samples" << std::endl;
+                }
+                droppedSamples += ret;
+                continue;
+            }
+
+            if (droppedSamples > 0) {
+                std::clog << "SoapySDR: dropped " << droppedSamples <<
+                    " samples" << std::endl;
+                droppedSamples = 0;
+            }
+
+            m_sampleBuffer.AdvanceRingBufferWriteIndex(ret);
         }
     }
 }
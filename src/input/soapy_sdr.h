@@ -52,7 +52,6 @@ public:
     virtual void stop(void);
     virtual void reset(void);
     virtual int32_t getSamples(DSPCOMPLEX* Buffer, int32_t Size);
-    virtual std::vector<DSPCOMPLEX> getSpectrumSamples(int size);
     virtual int32_t getSamplesToRead(void);
     virtual float setGain(int gainIndex);
     virtual float getGain(void) const;
@@ -61,6 +60,7 @@ public:
     virtual std::string getDescription(void);
     virtual CDeviceID getID(void);
     virtual bool setDeviceParam(DeviceParam param, const std::string& value);
+    virtual bool setDeviceParam(DeviceParam param, int value);
 
 private:
     void setDriverArgs(const std::string& args);
@@ -71,6 +71,8 @@ private:
 
     RadioControllerInterface& radioController;
     int m_freq = 0;
+    // Anything else than INPUT_RATE is only useful with the CChanneliser
+    int m_sample_rate = INPUT_RATE;
     std::string m_driver_args;
     std::string m_antenna;
     std::string m_clock_source;
@@ -79,7 +81,6 @@ private:
     bool m_sw_agc = false;
 
     RingBuffer<DSPCOMPLEX> m_sampleBuffer;
-    RingBuffer<DSPCOMPLEX> m_spectrumSampleBuffer;
 
     std::vector<double> m_gains;
 
@@ -30,26 +30,63 @@
 #ifndef __VIRTUAL_INPUT
 #define __VIRTUAL_INPUT
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 #include "dab-constants.h"
 #include "radio-controller.h"
 #include "ringbuffer.h"
+#include "iq_container.h"
+#include "iq_recorder.h"
 
 enum class CDeviceID {
-    UNKNOWN, NULLDEVICE, AIRSPY, RAWFILE, RTL_SDR, RTL_TCP, SOAPYSDR, ANDROID_RTL_SDR, LIMESDR};
+    UNKNOWN, NULLDEVICE, AIRSPY, RAWFILE, RTL_SDR, RTL_TCP, SOAPYSDR, ANDROID_RTL_SDR, LIMESDR, CHANNELISER};
 
 class CVirtualInput : public InputInterface {
 public:
     virtual ~CVirtualInput() {}
     virtual CDeviceID getID(void) = 0;
 
+    // Whether the input feeds the record tap, which holds u8 samples
+    virtual bool supportsRecording(void) const { return false; }
+
     void writeRecordBufferToFile(std::string &fileanme) {
         if(!recordBuffer)
             return;
 
+        auto ends_with = [&](const std::string& suffix) {
+            return fileanme.size() >= suffix.size() and
+                fileanme.compare(fileanme.size() - suffix.size(), suffix.size(), suffix) == 0;
+        };
+
+        // Files ending in .wiq are written as compressed container,
+        // .q4.wiq selects the lossy 4-bit codec.
+        if (ends_with(".wiq")) {
+            const auto available = recordBuffer->GetRingBufferReadAvailable();
+            std::vector<uint8_t> iq(available & ~1);
+            recordBuffer->getDataFromBuffer(iq.data(), iq.size());
+
+            using namespace std::chrono;
+            const int64_t now_us = duration_cast<microseconds>(
+                    system_clock::now().time_since_epoch()).count();
+            const int64_t start_us = now_us - (int64_t)(iq.size() / 2) * 1000000 / INPUT_RATE;
+
+            CIQContainerWriter writer(ends_with(".q4.wiq") ?
+                    IQCodec::Quantised4Bit : IQCodec::Lossless);
+            if (not writer.open(fileanme)) {
+                std::clog << "VirtualInput: cannot open " << fileanme << std::endl;
+                return;
+            }
+            writer.write(iq.data(), iq.size() / 2, start_us, getFrequency(), getGain());
+            writer.close();
+            return;
+        }
+
         std::ofstream rawStream(fileanme, std::ios::binary);
 
         while (1) {
@@ -82,8 +119,57 @@ public:
         }
     }
 
+    // Stream the record tap to disk until stopRecording() is called.
+    // maxFileSize in bytes and maxFileDuration in seconds select when
+    // to start a new file, 0 means no limit. See CIQRecorder.
+    bool startRecording(const std::string& fileName,
+            uint64_t maxFileSize = 0, int maxFileDuration = 0) {
+        std::unique_ptr<CIQRecorder> r(
+                new CIQRecorder(fileName, maxFileSize, maxFileDuration));
+        if (not r->start())
+            return false;
+
+        std::lock_guard<std::mutex> lock(recorderMutex);
+        recorder = std::move(r);
+        recordingActive = true;
+        return true;
+    }
+
+    void stopRecording(void) {
+        std::unique_ptr<CIQRecorder> r;
+        {
+            std::lock_guard<std::mutex> lock(recorderMutex);
+            recordingActive = false;
+            r = std::move(recorder);
+        }
+        // The remaining samples are written when r is destroyed
+    }
+
+    bool isRecording(void) const {
+        std::lock_guard<std::mutex> lock(recorderMutex);
+        return recorder and recorder->isOK();
+    }
+
+    uint64_t getRecordedBytes(void) const {
+        std::lock_guard<std::mutex> lock(recorderMutex);
+        return recorder ? recorder->getBytesWritten() : 0;
+    }
+
+    uint64_t getRecordingDroppedBytes(void) const {
+        std::lock_guard<std::mutex> lock(recorderMutex);
+        return recorder ? recorder->getDroppedBytes() : 0;
+    }
+
 protected:
     void putIntoRecordBuffer(uint8_t &data, uint32_t size) {
+        // Called for every block of samples, only take the lock while
+        // recording
+        if (recordingActive) {
+            std::lock_guard<std::mutex> lock(recorderMutex);
+            if (recorder)
+                recorder->push(&data, size, getFrequency(), getGain());
+        }
+
         if(!recordBuffer)
             return;
 
@@ -93,6 +179,10 @@ protected:
 
 private:
     std::unique_ptr<RingBuffer<uint8_t>> recordBuffer;
+
+    mutable std::mutex recorderMutex;
+    std::unique_ptr<CIQRecorder> recorder;
+    std::atomic<bool> recordingActive = ATOMIC_VAR_INIT(false);
 };
 
 #endif
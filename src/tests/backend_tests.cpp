@@ -36,6 +36,13 @@
 
 #include "radio-receiver.h"
 #include "raw_file.h"
+#include "iq_container.h"
+#include "ensemble-cache.h"
+#include "fib-processor.h"
+#include "fractional-resampler.h"
+#include "channeliser.h"
+#include "halfband_decimator.h"
+#include "signal-presence.h"
 
 class TestRadioInterface : public RadioControllerInterface {
     public:
@@ -55,7 +62,15 @@ class TestRadioInterface : public RadioControllerInterface {
         virtual void onConstellationPoints(std::vector<DSPCOMPLEX>&& data) override { (void)data; }
         virtual void onMessage(message_level_t level, const std::string& text, const std::string& text2 = std::string()) override { (void) level; (void)text; (void)text2;}
 
-        virtual void onTIIMeasurement(tii_measurement_t&& m) override { (void)m; }
+        virtual void onTIIMeasurement(tii_measurement_t&& m) override {
+            std::lock_guard<std::mutex> lock(tiiMutex);
+            tiiMeasurements.push_back(m);
+        }
+        virtual void onRestartService(void) override { restartCount++; }
+
+        int restartCount = 0;
+        std::mutex tiiMutex;
+        std::vector<tii_measurement_t> tiiMeasurements;
 };
 
 class TestProgrammeHandler: public ProgrammeHandlerInterface {
@@ -80,6 +95,39 @@ public:
     virtual void onPADLengthError(size_t announced_xpad_len, size_t xpad_len) override { (void)announced_xpad_len; (void) xpad_len;}
 };
 
+// Wideband input that delivers a single tone
+class TestWidebandInput : public CVirtualInput {
+    public:
+        TestWidebandInput(int sampleRate, int toneOffset) :
+            phaseStep(2 * M_PI * toneOffset / sampleRate) {}
+
+        virtual void setFrequency(int frequency) override { this->frequency = frequency; }
+        virtual int getFrequency(void) const override { return frequency; }
+        virtual bool restart(void) override { return true; }
+        virtual bool is_ok(void) override { return true; }
+        virtual void stop(void) override { }
+        virtual void reset(void) override { }
+        virtual int32_t getSamples(DSPCOMPLEX* buffer, int32_t size) override {
+            for (int32_t i = 0; i < size; i++) {
+                buffer[i] = std::polar(1.0f, (float)phase);
+                phase = fmod(phase + phaseStep, 2 * M_PI);
+            }
+            return size;
+        }
+        virtual int32_t getSamplesToRead(void) override { return 1 << 20; }
+        virtual float setGain(int /*gain*/) override { return 0; }
+        virtual float getGain(void) const override { return 0; }
+        virtual int getGainCount(void) override { return 0; }
+        virtual void setAgc(bool /*agc*/) override { }
+        virtual std::string getDescription(void) override { return "Test tone"; }
+        virtual CDeviceID getID(void) override { return CDeviceID::UNKNOWN; }
+
+    private:
+        int frequency = 0;
+        const double phaseStep;
+        double phase = 0;
+};
+
 class BackendTests : public QObject
 {
     Q_OBJECT
@@ -93,6 +141,17 @@ private slots:
     void cleanupTestCase() {}
     void testTuneToService();
     void testDLS();
+    void testIQContainer();
+    void testIQFileSeek();
+    void testIQCapture();
+    void testEnsembleCache();
+    void testEnsembleCacheChecks();
+    void testFractionalResampler();
+    void testChanneliser();
+    void testHalfBandDecimator();
+    void testTIIDecoder();
+    void testCSIDemapper();
+    void testSignalPresence();
 
 private:
     void runRadio(const std::string &rawFileName,
@@ -192,6 +251,722 @@ void BackendTests::testDLS()
     QCOMPARE(isOK, true);
 }
 
+void BackendTests::testIQContainer()
+{
+    const uint32_t samplesPerChunk = 4096;
+    const size_t numSamples = 3 * samplesPerChunk + 1000;
+
+    std::mt19937 gen(42);
+    std::normal_distribution<float> noise(0.0f, 20.0f);
+    std::vector<uint8_t> iq(2 * numSamples);
+    for (auto& b : iq) {
+        b = std::min(std::max(128.0f + noise(gen), 0.0f), 255.0f);
+    }
+
+    const std::string fileName = "test_iq_container.wiq";
+    {
+        CIQContainerWriter writer(IQCodec::Lossless, samplesPerChunk);
+        QVERIFY(writer.open(fileName));
+        QVERIFY(writer.write(iq.data(), numSamples, 0, 227360000, 10.0f));
+        QVERIFY(writer.close());
+        QVERIFY(writer.getBytesWritten() < iq.size());
+    }
+
+    FILE *f = fopen(fileName.c_str(), "rb");
+    QVERIFY(f != nullptr);
+
+    CIQContainerReader reader;
+    QVERIFY(reader.open(f));
+    QCOMPARE(reader.getNumChunks(), (size_t)4);
+    QCOMPARE(reader.getSamplesPerChunk(), samplesPerChunk);
+
+    // Chunks can be decoded in any order
+    for (size_t i = reader.getNumChunks(); i-- > 0;) {
+        IQChunk chunk;
+        std::vector<uint8_t> decoded;
+        QVERIFY(reader.readChunk(i, chunk));
+        QVERIFY(decodeIQChunk(chunk, decoded));
+        QCOMPARE(chunk.frequency, 227360000);
+
+        const size_t offset = 2 * i * samplesPerChunk;
+        QCOMPARE(decoded.size(), std::min(iq.size() - offset, (size_t)2 * samplesPerChunk));
+        QVERIFY(std::equal(decoded.begin(), decoded.end(), iq.begin() + offset));
+    }
+
+    fclose(f);
+    std::remove(fileName.c_str());
+
+    // The lossy codec keeps every sample within half a quantiser step,
+    // apart from the few beyond the 16 levels, and halves the size
+    {
+        CIQContainerWriter writer(IQCodec::Quantised4Bit, samplesPerChunk);
+        QVERIFY(writer.open(fileName));
+        QVERIFY(writer.write(iq.data(), numSamples, 0, 227360000, 10.0f));
+        QVERIFY(writer.close());
+        QVERIFY(writer.getBytesWritten() < iq.size() / 2 + 1024);
+    }
+
+    f = fopen(fileName.c_str(), "rb");
+    QVERIFY(f != nullptr);
+
+    CIQContainerReader q4reader;
+    QVERIFY(q4reader.open(f));
+    QCOMPARE(q4reader.getNumChunks(), (size_t)4);
+
+    double sumSquaredError = 0;
+    double sumSquares = 0;
+    for (size_t i = 0; i < q4reader.getNumChunks(); i++) {
+        IQChunk chunk;
+        std::vector<uint8_t> decoded;
+        QVERIFY(q4reader.readChunk(i, chunk));
+        QVERIFY(decodeIQChunk(chunk, decoded));
+        QVERIFY(chunk.codec == IQCodec::Quantised4Bit);
+
+        const size_t offset = 2 * i * samplesPerChunk;
+        QCOMPARE(decoded.size(), std::min(iq.size() - offset, (size_t)2 * samplesPerChunk));
+        for (size_t j = 0; j < decoded.size(); j++) {
+            const float original = (float)iq[offset + j] - 128.0f;
+            const float error = (float)decoded[j] - 128.0f - original;
+            if (std::abs(original) < 7 * chunk.step) {
+                QVERIFY(std::abs(error) <= chunk.step / 2 + 0.5f);
+            }
+            sumSquaredError += error * error;
+            sumSquares += original * original;
+        }
+    }
+    // About 20 dB SNR for Gaussian samples
+    QVERIFY(10 * log10(sumSquares / sumSquaredError) > 18.0);
+
+    fclose(f);
+    std::remove(fileName.c_str());
+
+    // Sizes read from a damaged file are checked before allocating
+    {
+        CIQContainerWriter writer(IQCodec::Lossless, samplesPerChunk);
+        QVERIFY(writer.open(fileName));
+        QVERIFY(writer.write(iq.data(), numSamples, 0, 227360000, 10.0f));
+        QVERIFY(writer.close());
+    }
+
+    const auto patch = [](FILE *file, long offset, int whence, uint32_t value) {
+        const uint8_t le[4] = {(uint8_t)value, (uint8_t)(value >> 8),
+            (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+        return fseek(file, offset, whence) == 0 and
+            fwrite(le, sizeof(le), 1, file) == 1 and fflush(file) == 0;
+    };
+
+    f = fopen(fileName.c_str(), "r+b");
+    QVERIFY(f != nullptr);
+
+    // An index claiming more chunks than fit in the file is ignored,
+    // and the chunks are found by scanning the file instead
+    QVERIFY(patch(f, -8, SEEK_END, 0x7FFFFFFF));
+    CIQContainerReader scanReader;
+    QVERIFY(scanReader.open(f));
+    QCOMPARE(scanReader.getNumChunks(), (size_t)4);
+
+    // A chunk longer than the space up to the next one, or with more
+    // samples than the file header allows, is rejected
+    IQChunk chunk;
+    QVERIFY(patch(f, 16 + 12, SEEK_SET, 0x7FFFFFFF));
+    QVERIFY(not scanReader.readChunk(0, chunk));
+    QVERIFY(patch(f, 16 + 12, SEEK_SET, 0));
+    QVERIFY(patch(f, 16 + 8, SEEK_SET, samplesPerChunk + 1));
+    QVERIFY(not scanReader.readChunk(0, chunk));
+    QVERIFY(scanReader.readChunk(1, chunk));
+
+    fclose(f);
+    std::remove(fileName.c_str());
+}
+
+void BackendTests::testIQFileSeek()
+{
+    // Three transmission frames, with chunks that do not line up with them
+    const size_t T_F = DABParams(1).T_F;
+    const uint32_t samplesPerChunk = 100000;
+    const size_t numSamples = 3 * T_F;
+
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<uint8_t> iq(2 * numSamples);
+    for (auto& b : iq) {
+        b = byte(gen);
+    }
+
+    const std::string fileName = "test_iq_seek.wiq";
+    {
+        CIQContainerWriter writer(IQCodec::Lossless, samplesPerChunk);
+        QVERIFY(writer.open(fileName));
+        QVERIFY(writer.write(iq.data(), numSamples, 0, 227360000, 10.0f));
+        QVERIFY(writer.close());
+    }
+
+    {
+        TestRadioInterface radioInterface;
+        CRAWFile rawFile(radioInterface, false, false);
+        rawFile.setFileName(fileName, "auto");
+        QVERIFY(rawFile.is_ok());
+
+        // The reader is paused until restart(), nothing before the seek
+        // point gets into the sample buffer
+        rawFile.seekToFrame(2);
+        QVERIFY(rawFile.restart());
+
+        const int32_t num = 32768;
+        std::vector<DSPCOMPLEX> samples(num);
+        QCOMPARE(rawFile.getSamples(samples.data(), num), num);
+
+        const size_t offset = 2 * (2 * T_F);
+        for (int32_t i = 0; i < num; i++) {
+            const DSPCOMPLEX expected(
+                    float(iq[offset + 2 * i] - 128) / 128.0f,
+                    float(iq[offset + 2 * i + 1] - 128) / 128.0f);
+            QCOMPARE(samples[i], expected);
+        }
+    }
+
+    std::remove(fileName.c_str());
+}
+
+void BackendTests::testIQCapture()
+{
+    RawSampleFormat format;
+    format.type = RawSampleFormat::Type::S16;
+
+    IQCaptureSettings settings;
+    settings.enabled = true;
+    settings.fileNamePrefix = "test_iq_capture";
+    settings.preTriggerSeconds = 1;
+    settings.postTriggerSeconds = 1;
+
+    // Sample i holds i in I and -i in Q, wrapping at 16 bits
+    const size_t blockSize = 8192;
+    const size_t triggerSample = 3 * INPUT_RATE / 2;
+    {
+        IQCapture capture(format);
+        capture.configure(settings);
+
+        std::vector<int16_t> block(2 * blockSize);
+        for (size_t fed = 0; fed < triggerSample + 2 * INPUT_RATE; fed += blockSize) {
+            if (fed == triggerSample) {
+                capture.trigger(IQCaptureEvent::Manual);
+            }
+            for (size_t i = 0; i < blockSize; i++) {
+                block[2 * i] = (int16_t)(fed + i);
+                block[2 * i + 1] = -(int16_t)(fed + i);
+            }
+            capture.feed(block.data(), blockSize);
+        }
+        // The destructor waits for the file to be written
+    }
+
+    const QStringList files = QDir().entryList(
+            QStringList() << "test_iq_capture_*_manual.s16le.iq", QDir::Files);
+    QCOMPARE(files.size(), 1);
+    const std::string fileName = files[0].toStdString();
+
+    std::vector<uint8_t> data;
+    FILE *f = fopen(fileName.c_str(), "rb");
+    QVERIFY(f != nullptr);
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(f);
+    std::remove(fileName.c_str());
+
+    // The pre-trigger seconds before the event, then the post-trigger
+    // seconds, as little-endian 16-bit values
+    const size_t numSamples = (settings.preTriggerSeconds +
+            settings.postTriggerSeconds) * INPUT_RATE;
+    QCOMPARE(data.size(), 4 * numSamples);
+
+    const size_t firstSample = triggerSample - settings.preTriggerSeconds * INPUT_RATE;
+    for (size_t i = 0; i < numSamples; i++) {
+        const uint16_t I = (uint16_t)(int16_t)(firstSample + i);
+        const uint16_t Q = (uint16_t)-(int16_t)(firstSample + i);
+        const uint8_t *s = data.data() + 4 * i;
+        QVERIFY(s[0] == (I & 0xFF) and s[1] == (I >> 8) and
+                s[2] == (Q & 0xFF) and s[3] == (Q >> 8));
+    }
+}
+
+void BackendTests::testEnsembleCache()
+{
+    EnsembleConfig config;
+    config.ensembleId = 0x4FFF;
+    config.ensembleLabel.fig1_label = "Test ensemble   ";
+    config.ensembleLabel.segment_count = 1;
+    config.ensembleLabel.extended_label_charset = CharacterSet::UnicodeUtf8;
+    config.ensembleLabel.segments[0] = {'T', 'e', 's', 't'};
+
+    Service service(0x4DAA);
+    service.serviceLabel.fig1_label = "Test service    ";
+    service.language = -1;
+    config.services.push_back(service);
+
+    ServiceComponent component;
+    component.SId = service.serviceId;
+    component.subchannelId = 5;
+    component.ASCTy = 63;
+    config.components.push_back(component);
+
+    Subchannel subchannel;
+    subchannel.subChId = 5;
+    subchannel.startAddr = 100;
+    subchannel.length = 72;
+    subchannel.protectionSettings.eepLevel = EEPProtectionLevel::EEP_2;
+    config.subChannels.push_back(subchannel);
+
+    const int frequency = 227360000;
+    EnsembleCache cache(".");
+    QVERIFY(cache.save(frequency, config));
+
+    EnsembleConfig loaded;
+    QVERIFY(cache.load(frequency, loaded));
+    QCOMPARE(loaded.ensembleId, config.ensembleId);
+    QCOMPARE(loaded.ensembleLabel.utf8_label(), std::string("Test"));
+    QCOMPARE(loaded.services.size(), (size_t)1);
+    QCOMPARE(loaded.services[0].serviceId, service.serviceId);
+    QCOMPARE(loaded.services[0].language, service.language);
+    QCOMPARE(loaded.components.size(), (size_t)1);
+    QCOMPARE(loaded.components[0].subchannelId, component.subchannelId);
+    QCOMPARE(loaded.components[0].ASCTy, component.ASCTy);
+    QCOMPARE(loaded.subChannels.size(), (size_t)1);
+    QCOMPARE(loaded.subChannels[0].length, subchannel.length);
+    QCOMPARE(loaded.subChannels[0].protection(), subchannel.protection());
+
+    QVERIFY(not cache.load(frequency + 1, loaded));
+
+    std::remove(("./ensemble-" + std::to_string(frequency) + ".bin").c_str());
+}
+
+// Pack the FIGs into a FIB with one bit per byte, as the FIC handler
+// passes it to the FIBProcessor, and fill the rest with the end marker
+static std::vector<uint8_t> fibBits(std::vector<uint8_t> figs)
+{
+    figs.resize(30, 0xFF);
+    std::vector<uint8_t> bits(256, 0);
+    for (size_t i = 0; i < figs.size(); i++) {
+        for (int b = 0; b < 8; b++) {
+            bits[8 * i + b] = (figs[i] >> (7 - b)) & 1;
+        }
+    }
+    return bits;
+}
+
+void BackendTests::testEnsembleCacheChecks()
+{
+    EnsembleConfig config;
+    config.ensembleId = 0x4FFF;
+    for (uint32_t sId : {0x4DAA, 0x4DAB}) {
+        config.services.emplace_back(sId);
+
+        ServiceComponent component;
+        component.SId = sId;
+        component.subchannelId = sId & 0x0F;
+        component.ASCTy = 63;
+        config.components.push_back(component);
+    }
+
+    // FIG 0/0 and FIG 0/2 with one DAB+ component in the given subchannel
+    const auto fig0_0 = [](uint16_t eId) {
+        return std::vector<uint8_t>{0x05, 0x00,
+            (uint8_t)(eId >> 8), (uint8_t)eId, 0x00, 0x00};
+    };
+    const auto fig0_2 = [](uint16_t sId, uint8_t subChId) {
+        return std::vector<uint8_t>{0x06, 0x02,
+            (uint8_t)(sId >> 8), (uint8_t)sId, 0x01, 0x3F,
+            (uint8_t)(subChId << 2)};
+    };
+
+    TestRadioInterface radioInterface;
+
+    // The cached configuration belongs to another ensemble
+    {
+        FIBProcessor fibProcessor(radioInterface);
+        fibProcessor.loadEnsembleConfig(config);
+
+        auto fib = fibBits(fig0_0(0x1234));
+        fibProcessor.processFIB(fib.data(), 0);
+        QCOMPARE(radioInterface.restartCount, 1);
+        QCOMPARE(fibProcessor.getEnsembleId(), (uint16_t)0x1234);
+        QVERIFY(fibProcessor.getServiceList().empty());
+    }
+
+    // Confirming a cached component keeps the decoders running,
+    // moving it to another subchannel restarts them
+    {
+        radioInterface.restartCount = 0;
+        FIBProcessor fibProcessor(radioInterface);
+        fibProcessor.loadEnsembleConfig(config);
+
+        auto figs = fig0_0(0x4FFF);
+        const auto confirm = fig0_2(0x4DAA, 0x0A);
+        figs.insert(figs.end(), confirm.begin(), confirm.end());
+        auto fib = fibBits(figs);
+        fibProcessor.processFIB(fib.data(), 0);
+        QCOMPARE(radioInterface.restartCount, 0);
+
+        fib = fibBits(fig0_2(0x4DAA, 0x0C));
+        fibProcessor.processFIB(fib.data(), 0);
+        QCOMPARE(radioInterface.restartCount, 1);
+        const auto components = fibProcessor.getComponents(Service(0x4DAA));
+        QCOMPARE(components.size(), (size_t)1);
+        QCOMPARE(components.front().subchannelId, (int16_t)0x0C);
+    }
+
+    // A cached service that the FIC does not signal any more disappears
+    // once its repeat counter, decremented every second, runs out
+    {
+        FIBProcessor fibProcessor(radioInterface);
+        fibProcessor.loadEnsembleConfig(config);
+
+        auto fib = fibBits(fig0_2(0x4DAA, 0x0A));
+        for (int i = 0; i < 4; i++) {
+            fibProcessor.processFIB(fib.data(), 0);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        }
+        QCOMPARE(fibProcessor.getServiceList().size(), (size_t)2);
+
+        fibProcessor.processFIB(fib.data(), 0);
+        const auto services = fibProcessor.getServiceList();
+        QCOMPARE(services.size(), (size_t)1);
+        QCOMPARE(services[0].serviceId, (uint32_t)0x4DAA);
+        QVERIFY(fibProcessor.getComponents(Service(0x4DAB)).empty());
+    }
+}
+
+void BackendTests::testFractionalResampler()
+{
+    // A carrier near the edge of the ensemble, sampled with a clock
+    // that is 30 ppm too fast
+    const double ratio = 1.0 + 30e-6;
+    const double f = 0.37;
+    auto tone = [f](double t) {
+        return std::polar(1.0f, (float)fmod(2 * M_PI * f * t, 2 * M_PI));
+    };
+
+    FractionalResampler resampler;
+    resampler.setRatio(ratio);
+
+    size_t consumed = 0;
+    size_t produced = 0;
+    float maxError = 0;
+    for (size_t block = 0; block < 100; block++) {
+        const size_t n = 1000 + 37 * block;
+        std::vector<DSPCOMPLEX> in(resampler.inputLength(n));
+        for (size_t i = 0; i < in.size(); i++) {
+            in[i] = tone(consumed + i);
+        }
+        std::vector<DSPCOMPLEX> out(n);
+        resampler.process(in.data(), out.data(), n);
+        consumed += in.size();
+
+        // The output is delayed by half of the 12 taps
+        for (size_t k = 0; k < n; k++) {
+            if (produced + k > 12) {
+                const double t = (produced + k) * ratio - 6;
+                maxError = std::max(maxError, std::abs(out[k] - tone(t)));
+            }
+        }
+        produced += n;
+    }
+
+    QVERIFY(std::abs(consumed - produced * ratio) < 2.0);
+    QVERIFY(maxError < 0.02f);
+}
+
+void BackendTests::testChanneliser()
+{
+    // Two adjacent ensembles, 12A and 12B, with a tone inside 12B
+    const int sampleRate = 4 * INPUT_RATE;
+    const int freq12A = 223936000;
+    const int freq12B = 225648000;
+    const int centre = (freq12A + freq12B) / 2;
+
+    CChanneliser channeliser(std::unique_ptr<CVirtualInput>(
+                new TestWidebandInput(sampleRate, freq12B - centre + 20000)),
+            sampleRate);
+    channeliser.setCentreFrequency(centre);
+
+    // All channels have to be added before the first one is started
+    auto& in12A = channeliser.addChannel(freq12A);
+    auto& in12B = channeliser.addChannel(freq12B);
+    QVERIFY(in12A.restart());
+    QVERIFY(in12B.restart());
+    QVERIFY_EXCEPTION_THROWN(channeliser.addChannel(freq12A), std::logic_error);
+
+    const int32_t length = 100000;
+    for (int i = 0; i < 500; i++) {
+        if (in12A.getSamplesToRead() >= length and
+                in12B.getSamplesToRead() >= length) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    QVERIFY(in12A.getSamplesToRead() >= length);
+    QVERIFY(in12B.getSamplesToRead() >= length);
+
+    auto power = [length](CChannelisedInput& in) {
+        std::vector<DSPCOMPLEX> samples(length);
+        in.getSamples(samples.data(), length);
+        // Skip the start-up of the filter
+        float sum = 0;
+        for (int32_t i = length / 2; i < length; i++) {
+            sum += std::norm(samples[i]);
+        }
+        return sum / (length / 2);
+    };
+
+    const float power12A = power(in12A);
+    const float power12B = power(in12B);
+    channeliser.stop();
+
+    QVERIFY(std::abs(power12B - 1.0f) < 0.01f);
+    QVERIFY(power12A < 1e-4f);
+}
+
+void BackendTests::testHalfBandDecimator()
+{
+    // The decimator runs at 2 * INPUT_RATE
+    const double inputRate = 2.0 * INPUT_RATE;
+
+    auto gain = [inputRate](double frequency) {
+        CHalfBandDecimator decimator;
+        const double step = 2 * M_PI * frequency / inputRate;
+        std::vector<DSPCOMPLEX> in(4096);
+        double phase = 0;
+        float sum = 0;
+        size_t count = 0;
+        // Blocks of odd length exercise the sample kept between calls
+        for (size_t block = 0; block < 20; block++) {
+            const size_t n = in.size() - (block % 2);
+            for (size_t i = 0; i < n; i++) {
+                in[i] = std::polar(1.0f, (float)phase);
+                phase = fmod(phase + step, 2 * M_PI);
+            }
+            const auto& out = decimator.decimate(in.data(), n);
+            // Skip the start-up of the filter
+            if (block > 0) {
+                for (const auto& z : out) {
+                    sum += std::norm(z);
+                    count++;
+                }
+            }
+        }
+        return 10 * log10(sum / count);
+    };
+
+    // DC and the DAB band up to 768 kHz pass with less than 0.01 dB ripple
+    QVERIFY(std::abs(gain(0)) < 0.001f);
+    QVERIFY(std::abs(gain(500000)) < 0.01f);
+    QVERIFY(std::abs(gain(-768000)) < 0.01f);
+
+    // What would alias onto the DAB band is attenuated by 70 dB
+    QVERIFY(gain(1280000) < -70.0f);
+    QVERIFY(gain(-1800000) < -70.0f);
+}
+
+void BackendTests::testTIIDecoder()
+{
+    const DABParams params(1);
+    TestRadioInterface radioInterface;
+    CIRAnalyser cirAnalyser(params);
+    TIIDecoder tiiDecoder(params, radioInterface, cirAnalyser);
+
+    std::mt19937 gen(44);
+    std::uniform_int_distribution<int> quadrant(0, 3);
+    std::vector<DSPCOMPLEX> prsCarriers(params.T_u);
+    for (int k = -params.K / 2; k <= params.K / 2; k++) {
+        if (k != 0) {
+            prsCarriers[(k + params.T_u) % params.T_u] =
+                std::polar(1.0f, (float)M_PI_2 * quadrant(gen) + (float)M_PI_4);
+        }
+    }
+
+    fft::Backward ifft(params.T_u);
+    auto toTime = [&](const std::vector<DSPCOMPLEX>& carriers) {
+        std::copy(carriers.begin(), carriers.end(), ifft.getVector());
+        ifft.do_IFFT();
+        return std::vector<DSPCOMPLEX>(ifft.getVector(), ifft.getVector() + params.T_u);
+    };
+    const auto prs = toTime(prsCarriers);
+
+    // A transmitter switches on the carrier pairs of its comb and pattern
+    // in the NULL symbol, with the phase of the first PRS carrier of
+    // every pair, and is received with the given delay
+    const CombPattern cp(5, 17);
+    auto nullSymbol = [&](int delay) {
+        std::vector<DSPCOMPLEX> nullCarriers(params.T_u);
+        const auto carriers = cp.generateCarriers(params.K);
+        for (size_t i = 0; i < carriers.size(); i++) {
+            const carrier_t first = carriers[i - i % 2];
+            const carrier_t k = carriers[i];
+            nullCarriers[(k + params.T_u) % params.T_u] =
+                prsCarriers[(first + params.T_u) % params.T_u] *
+                std::polar(1.0f, (float)(-2 * M_PI * delay * k / params.T_u));
+        }
+        auto symbol = toTime(nullCarriers);
+        // Prepend the cyclic prefix
+        symbol.insert(symbol.begin(),
+                symbol.end() - (params.T_null - params.T_u), symbol.end());
+        return symbol;
+    };
+
+    auto pushFrames = [&](int delay, int count) {
+        const auto null = nullSymbol(delay);
+        for (int i = 0; i < count; i++) {
+            tiiDecoder.pushSymbols(null, prs);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        std::lock_guard<std::mutex> lock(radioInterface.tiiMutex);
+        return radioInterface.tiiMeasurements;
+    };
+
+    // The phase errors are summed over five frames before a measurement
+    QVERIFY(pushFrames(20, 3).empty());
+
+    // After a retune, the frames received before do not count
+    tiiDecoder.reset();
+    QVERIFY(pushFrames(40, 4).empty());
+
+    const auto measurements = pushFrames(40, 1);
+    QCOMPARE(measurements.size(), (size_t)1);
+    QCOMPARE(measurements[0].comb, cp.comb);
+    QCOMPARE(measurements[0].pattern, cp.pattern);
+    QCOMPARE(measurements[0].delay_samples, 40);
+}
+
+void BackendTests::testCSIDemapper()
+{
+    // The carriers are received with the same noise: the first one at
+    // full level, the second one faded by 10 dB, the third one lost
+    const size_t K = 3;
+    const std::vector<float> amplitudes = {1.0f, 0.316f, 0.0f};
+    CSIDemapper demapper(K);
+    std::vector<softbit_t> bits(2 * K);
+
+    // Soft bit of the plain demapper, see demodulateAndDemap()
+    auto plainBit = [](float value, DSPCOMPLEX product) {
+        return (softbit_t)(-value * 127.0f /
+                (std::fabs(real(product)) + std::fabs(imag(product))));
+    };
+
+    std::mt19937 gen(49);
+    std::uniform_int_distribution<int> quadrant(0, 3);
+    auto point = [&](float amplitude) {
+        return std::polar(amplitude, (float)M_PI_2 * quadrant(gen) + (float)M_PI_4);
+    };
+
+    // The first symbol is taken to be at the reference SNR, where the
+    // soft bits are the same as with the plain demapper
+    std::vector<DSPCOMPLEX> products = {point(1.0f), point(0.316f), point(0.1f)};
+    demapper.demap(products.data(), bits.data());
+    for (size_t i = 0; i < K; i++) {
+        QCOMPARE(bits[i], plainBit(real(products[i]), products[i]));
+        QCOMPARE(bits[K + i], plainBit(imag(products[i]), products[i]));
+    }
+
+    std::normal_distribution<float> noise(0.0f, 0.1f);
+    std::vector<float> csiMagnitude(K), plainMagnitude(K);
+    size_t erased = 0;
+    for (int n = 0; n < 1000; n++) {
+        for (size_t i = 0; i < K; i++) {
+            products[i] = point(amplitudes[i]) +
+                DSPCOMPLEX(noise(gen), noise(gen));
+        }
+        demapper.demap(products.data(), bits.data());
+
+        // Once the estimates have converged
+        if (n < 100) {
+            continue;
+        }
+
+        for (size_t i = 0; i < K; i++) {
+            csiMagnitude[i] += std::abs(bits[i]) + std::abs(bits[K + i]);
+            plainMagnitude[i] +=
+                std::abs(plainBit(real(products[i]), products[i])) +
+                std::abs(plainBit(imag(products[i]), products[i]));
+        }
+        if (bits[2] == 0 and bits[K + 2] == 0) {
+            erased++;
+        }
+    }
+
+    // The plain demapper is as confident on the faded carrier as on
+    // the good one, the CSI weighted demapper is not
+    QVERIFY(plainMagnitude[1] > 0.8f * plainMagnitude[0]);
+    QVERIFY(csiMagnitude[1] < 0.4f * csiMagnitude[0]);
+
+    // The lost carrier is erased most of the time
+    QVERIFY(csiMagnitude[2] < 0.1f * csiMagnitude[0]);
+    QVERIFY(erased > 400);
+}
+
+void BackendTests::testSignalPresence()
+{
+    const DABParams params(1);
+    std::mt19937 gen(11);
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+    auto complexGauss = [&](float sigma) {
+        return DSPCOMPLEX(sigma * gauss(gen), sigma * gauss(gen));
+    };
+
+    // A transmission frame and a bit, as looked at by the OFDM processor,
+    // with the null symbol 20 dB below the rest of the frame
+    const size_t frameLength = params.T_F + params.T_null;
+    const size_t nullStart = 100000;
+    std::vector<DSPCOMPLEX> frame(frameLength);
+    for (size_t i = 0; i < frameLength; i++) {
+        const bool isNull = i >= nullStart and i < nullStart + params.T_null;
+        frame[i] = complexGauss(0.1f) + (isNull ? 0.0f : complexGauss(1.0f));
+    }
+    const float frameDepth = nullDipDepth(frame.data(), frameLength, params.T_null / 2);
+    QVERIFY(frameDepth < 0.2f);
+    QVERIFY(frameDepth < NULL_DIP_THRESHOLD);
+
+    // Noise alone has no dip
+    std::vector<DSPCOMPLEX> noise(frameLength);
+    for (auto& v : noise) {
+        v = complexGauss(1.0f);
+    }
+    const float noiseDepth = nullDipDepth(noise.data(), frameLength, params.T_null / 2);
+    QVERIFY(noiseDepth > NULL_DIP_THRESHOLD);
+    QVERIFY(noiseDepth <= 1.0f);
+
+    // A wideband capture with an ensemble 1.5 MHz above the centre, built
+    // in the frequency domain, and nothing 1.5 MHz below
+    const int sampleRate = 4 * INPUT_RATE;
+    const int centre = 225000000;
+    const int blockSize = 2048;
+    const double binWidth = (double)sampleRate / blockSize;
+    fft::Backward ifft(blockSize);
+
+    ChannelOccupancy occupancy(sampleRate);
+    std::vector<DSPCOMPLEX> block(blockSize);
+    for (int b = 0; b < 400; b++) {
+        DSPCOMPLEX *v = ifft.getVector();
+        for (int k = 0; k < blockSize; k++) {
+            const double offset = (k < blockSize / 2 ? k : k - blockSize) * binWidth;
+            const bool inEnsemble = std::abs(offset - 1500000) < 768000;
+            v[k] = complexGauss(0.1f) + (inEnsemble ? complexGauss(1.0f) : 0.0f);
+        }
+        ifft.do_IFFT();
+        std::copy(v, v + blockSize, block.begin());
+        occupancy.add(block.data(), blockSize);
+    }
+
+    const auto levels = occupancy.measure(centre,
+            {centre + 1500000, centre - 1500000, centre + 4000000});
+    QCOMPARE(levels.size(), (size_t)3);
+    QVERIFY(levels[0] > 15.0f);
+    QVERIFY(std::abs(levels[1]) < 1.0f);
+    // Beyond the usable part of the capture
+    QCOMPARE(levels[2], 0.0f);
+}
+
 QTEST_APPLESS_MAIN(BackendTests)
 
 #include "backend_tests.moc"
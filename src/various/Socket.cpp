@@ -104,6 +104,48 @@ ssize_t Socket::recv(void *buffer, size_t length, int flags)
     return ::recv(sock, (char*)buffer, length, flags);
 }
 
+ssize_t Socket::recv(void *buffer1, size_t length1,
+        void *buffer2, size_t length2, int flags)
+{
+#if defined(_WIN32)
+    WSABUF bufs[2];
+    bufs[0].buf = (char*)buffer1;
+    bufs[0].len = length1;
+    bufs[1].buf = (char*)buffer2;
+    bufs[1].len = length2;
+
+    DWORD received = 0;
+    DWORD wsa_flags = flags;
+    if (WSARecv(sock, bufs, length2 > 0 ? 2 : 1, &received, &wsa_flags,
+                nullptr, nullptr) == SOCKET_ERROR) {
+        return -1;
+    }
+    return received;
+#else
+    struct iovec iov[2];
+    iov[0].iov_base = buffer1;
+    iov[0].iov_len = length1;
+    iov[1].iov_base = buffer2;
+    iov[1].iov_len = length2;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = length2 > 0 ? 2 : 1;
+    return ::recvmsg(sock, &msg, flags);
+#endif
+}
+
+int Socket::getReceiveBufferSize() const
+{
+    int size = 0;
+    socklen_t len = sizeof(size);
+    if (::getsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char*)&size, &len) != 0) {
+        return -1;
+    }
+    return size;
+}
+
 ssize_t Socket::send(const void *buffer, size_t length, int flags)
 {
     return ::send(sock, (const char*)buffer, length, flags);
@@ -179,7 +221,8 @@ Socket Socket::accept()
     return s;
 }
 
-bool Socket::connect(const std::string& address, int port, int timeout)
+bool Socket::connect(const std::string& address, int port, int timeout,
+        int receive_buffer_size)
 {
 #if defined(_WIN32)
     TIMEVAL Timeout;
@@ -223,6 +266,14 @@ bool Socket::connect(const std::string& address, int port, int timeout)
         if (sfd == -1)
             continue;
 
+        if (receive_buffer_size > 0) {
+            if (::setsockopt(sfd, SOL_SOCKET, SO_RCVBUF,
+                        (const char*)&receive_buffer_size,
+                        sizeof(receive_buffer_size)) != 0) {
+                std::clog << "Socket: Failed to set receive buffer size" << std::endl;
+            }
+        }
+
         // set the socket in non-blocking mode
 #ifdef _WIN32
         unsigned long mode = 1;
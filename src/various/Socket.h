@@ -45,6 +45,7 @@
     #endif
 #else
     #include <sys/socket.h>
+    #include <sys/uio.h>
     #include <netinet/in.h>
     #include <unistd.h>
     #include <netdb.h>
@@ -73,9 +74,20 @@ class Socket {
         bool bind(int port);
         bool listen();
         Socket accept();
-        bool connect(const std::string& address, int port, int timeout);
+        // A receive_buffer_size other than zero sets SO_RCVBUF before
+        // connecting, so that TCP can use a receive window of that size.
+        bool connect(const std::string& address, int port, int timeout,
+                int receive_buffer_size = 0);
+
+        // Effective SO_RCVBUF in bytes, or -1 on error
+        int getReceiveBufferSize() const;
 
         ssize_t recv(void *buffer, size_t length, int flags);
+
+        // Scatter the received data over two buffers in a single call,
+        // e.g. the two free regions of a ring buffer.
+        ssize_t recv(void *buffer1, size_t length1,
+                void *buffer2, size_t length2, int flags);
         ssize_t send(const void *buffer, size_t length, int flags);
 
     private:
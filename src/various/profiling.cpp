@@ -47,6 +47,7 @@ const char* mark_to_cstr(const ProfilingMark& m) {
         MARK_TO_CSTR_CASE(SyncOnEndNull)
         MARK_TO_CSTR_CASE(SyncOnPhase)
         MARK_TO_CSTR_CASE(FindIndex)
+        MARK_TO_CSTR_CASE(TrackTiming)
         MARK_TO_CSTR_CASE(DataSymbols)
         MARK_TO_CSTR_CASE(PushAllSymbols)
         MARK_TO_CSTR_CASE(OnNewNull)
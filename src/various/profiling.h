@@ -41,6 +41,7 @@ enum class ProfilingMark {
     SyncOnEndNull,
     SyncOnPhase,
     FindIndex,
+    TrackTiming,
     DataSymbols,
     PushAllSymbols,
     OnNewNull,
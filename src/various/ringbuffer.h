@@ -69,6 +69,7 @@
 #ifndef RING_BUFFER_H
 #define RING_BUFFER_H
 
+#include    <atomic>
 #include    <stdlib.h>
 #include    <vector>
 #include    <stdio.h>
@@ -139,14 +140,20 @@ class RingBuffer
         uint32_t    bigMask;
         uint32_t    smallMask;
         std::vector<char> buffer;
+        std::atomic<uint64_t> droppedElementCount = ATOMIC_VAR_INIT(0);
 
-    protected:
+    public:
+        // Called for the elements that did not fit into the buffer, also
+        // by writers that discard data themselves when the buffer is full.
         void onDroppedData(int32_t droppedElements) {
-            (void) droppedElements;
-            // In case a warning should be output, do it here
+            droppedElementCount += droppedElements;
+        }
+
+        // Number of elements dropped since the buffer was created
+        uint64_t GetDroppedElements(void) const {
+            return droppedElementCount;
         }
 
-    public:
         RingBuffer(uint32_t elementCount) {
             if (((elementCount - 1) & elementCount) != 0)
                 elementCount = 2 * 16384;   /* default  */
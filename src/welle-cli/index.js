@@ -13,6 +13,19 @@ var png_chevron_right = "iVBORw0KGgoAAAANSUhEUgAAABgAAAAYCAYAAADgdz34AAAABHNCSVQ
 
 var png_chevron_down = "iVBORw0KGgoAAAANSUhEUgAAABgAAAAYCAYAAADgdz34AAAABHNCSVQICAgIfAhkiAAAAAlwSFlzAAAOxAAADsQBlSsOGwAAABl0RVh0U29mdHdhcmUAd3d3Lmlua3NjYXBlLm9yZ5vuPBoAAAB0SURBVEiJ7Y87CoAwEAVHD2khqIUgCF5HUPBzUL9NgiGoSKKN7MAW4cEMAUEQnlAAycUWA6WPPAcWdZm1RcAErEDlGmiATd3M8ZNYvfXWuQYCoLUijSXvgdA1oCO1ITRv8JXfRV6Tn0XGt+VmJP1KLgh/ZQd6AiOdJgUioQAAAABJRU5ErkJggg=="
 
+// When several receivers share one welle-cli, each of them is reachable
+// under its own prefix, e.g. /10B/
+var urlPrefix = window.location.pathname.replace(/\/[^\/]*$/, "");
+
+var plotSpectrumTimer = null;
+var plotCIRTimer = null;
+var plotConstellationTimer = null;
+
+// The plots are pushed by the server over a WebSocket. Polling is only
+// used as a fallback when the browser or the server does not support it.
+var plotSocket = null;
+var plotSocketFailed = false;
+
 window.onload = function() {
     var chevron_right = '<img width=24 height=24 src="data:image/png;base64,' +
         png_chevron_right + '" />';
@@ -57,28 +70,37 @@ window.onload = function() {
 
     spectrum_block.onclick = function() {
         if (toggle_func(spectrum_block)) {
-            populateSpectrumPlots(480);
+            if (!openPlotSocket()) {
+                populateSpectrumPlots(480);
+            }
         }
         else {
-            clearInterval(plotSpectrumTimer);
+            clearTimeout(plotSpectrumTimer);
+            closePlotSocketIfUnused();
         }
     };
 
     cir_block.onclick = function() {
         if (toggle_func(cir_block)) {
-            populateCIRPlots(480);
+            if (!openPlotSocket()) {
+                populateCIRPlots(480);
+            }
         }
         else {
-            clearInterval(plotCIRTimer);
+            clearTimeout(plotCIRTimer);
+            closePlotSocketIfUnused();
         }
     };
 
     constellation_block.onclick = function() {
         if (toggle_func(constellation_block)) {
-            populateConstellationPlots(480);
+            if (!openPlotSocket()) {
+                populateConstellationPlots(480);
+            }
         }
         else {
-            clearInterval(plotConstellationTimer);
+            clearTimeout(plotConstellationTimer);
+            closePlotSocketIfUnused();
         }
     };
 
@@ -95,7 +117,7 @@ window.onload = function() {
     ch.onchange = function() {
         var channel = document.getElementById("channelselector").value;
         var xhr = new XMLHttpRequest();
-        xhr.open("POST", '/channel', true);
+        xhr.open("POST", urlPrefix + '/channel', true);
         xhr.setRequestHeader("Content-type", "text/plain");
         xhr.send(channel);
     };
@@ -111,7 +133,7 @@ window.onload = function() {
     fftw.onchange = function() {
         var fft_window = document.getElementById("fftwindowselector").value;
         var xhr = new XMLHttpRequest();
-        xhr.open("POST", '/fftwindowplacement', true);
+        xhr.open("POST", urlPrefix + '/fftwindowplacement', true);
         xhr.setRequestHeader("Content-type", "text/plain");
         xhr.send(fft_window);
     };
@@ -119,7 +141,7 @@ window.onload = function() {
     document.getElementById("coarsecheckbox").onclick = function() {
         var fft_window = document.getElementById("fftwindowselector").value;
         var xhr = new XMLHttpRequest();
-        xhr.open("POST", '/enablecoarsecorrector', true);
+        xhr.open("POST", urlPrefix + '/enablecoarsecorrector', true);
         xhr.setRequestHeader("Content-type", "text/plain");
         if (document.getElementById("coarsecheckbox").checked) {
             xhr.send(1);
@@ -136,7 +158,7 @@ function refreshChannel() {
         if (r.readyState != 4 || r.status != 200) return;
         document.getElementById("channelselector").value = r.responseText;
     };
-    r.open("GET", "/channel", true);
+    r.open("GET", urlPrefix + "/channel", true);
     r.send()
 };
 
@@ -210,7 +232,7 @@ function playerLoad() {
 }
 
 function setPlayerSource(sid) {
-    document.getElementById("player").src = "/stream/" + sid;
+    document.getElementById("player").src = urlPrefix + "/stream/" + sid;
     playerLoad();
 }
 
@@ -442,7 +464,7 @@ function populateEnsembleinfo() {
 
         drawAudiolevels(data.services);
     };
-    r.open("GET", "/mux.json", true);
+    r.open("GET", urlPrefix + "/mux.json", true);
     r.send()
 };
 
@@ -524,11 +546,11 @@ function populateSpectrum() {
                 plot(spec, "spectrum", 2, 20, 1);
             }
         };
-        r2.open("GET", "/nullspectrum", true);
+        r2.open("GET", urlPrefix + "/nullspectrum", true);
         r2.responseType = "arraybuffer";
         r2.send(null);
     };
-    r.open("GET", "/spectrum", true);
+    r.open("GET", urlPrefix + "/spectrum", true);
     r.responseType = "arraybuffer";
     r.send(null);
 };
@@ -542,7 +564,7 @@ function populateCIR() {
             plot(cir, "cir", 4, 30, 0)
         }
     };
-    r.open("GET", "/impulseresponse", true);
+    r.open("GET", urlPrefix + "/impulseresponse", true);
     r.responseType = "arraybuffer";
     r.send(null);
 }
@@ -552,32 +574,136 @@ function populateConstellation() {
     r.onload = function(oEvent) {
         var arrayBuffer = r.response;
         if (arrayBuffer) {
-            var data = new Float32Array(arrayBuffer);
-
-            var squeeze = 4;
-
-            var canvas = document.getElementById("constellation");
-            var ctx = canvas.getContext("2d");
-            ctx.fillStyle = "#111100";
-            ctx.fillRect(0,0,data.length / squeeze,180);
-
-            ctx.beginPath();
-            ctx.strokeStyle="rgba(255, 100, 0, 0.8)";
-            for (var i = 0; i < data.length; i++) {
-                var x = i / squeeze;
-                var y = (data[i] + 180) / 2;
-                // Draw a little cross
-                ctx.moveTo(x-1, y);
-                ctx.lineTo(x+1, y);
-                ctx.moveTo(x, y-1);
-                ctx.lineTo(x, y+1);
-            }
-            ctx.stroke();
+            drawConstellation(new Float32Array(arrayBuffer));
         }
     };
-    r.open("GET", "/constellation", true);
+    r.open("GET", urlPrefix + "/constellation", true);
     r.responseType = "arraybuffer";
     r.send(null);
 }
 
+function drawConstellation(data) {
+    var squeeze = 4;
+
+    var canvas = document.getElementById("constellation");
+    var ctx = canvas.getContext("2d");
+    ctx.fillStyle = "#111100";
+    ctx.fillRect(0,0,data.length / squeeze,180);
+
+    ctx.beginPath();
+    ctx.strokeStyle="rgba(255, 100, 0, 0.8)";
+    for (var i = 0; i < data.length; i++) {
+        var x = i / squeeze;
+        var y = (data[i] + 180) / 2;
+        // Draw a little cross
+        ctx.moveTo(x-1, y);
+        ctx.lineTo(x+1, y);
+        ctx.moveTo(x, y-1);
+        ctx.lineTo(x, y+1);
+    }
+    ctx.stroke();
+}
+
+function isBlockVisible(id) {
+    var block = document.getElementById(id);
+    return block.getElementsByClassName('data')[0].style.display != "none";
+}
+
+function openPlotSocket() {
+    if (plotSocket !== null) {
+        return true;
+    }
+
+    if (plotSocketFailed || !("WebSocket" in window)) {
+        return false;
+    }
+
+    var proto = (window.location.protocol == "https:") ? "wss://" : "ws://";
+    var ws = new WebSocket(proto + window.location.host + urlPrefix + "/plots");
+    ws.binaryType = "arraybuffer";
+    ws.onmessage = function(ev) { drawPlotFrame(ev.data); };
+    ws.onerror = function() {
+        plotSocketFailed = true;
+    };
+    ws.onclose = function() {
+        if (plotSocket === ws) {
+            plotSocket = null;
+        }
+        if (plotSocketFailed) {
+            if (isBlockVisible('block_spectrum')) { populateSpectrumPlots(480); }
+            if (isBlockVisible('block_cir')) { populateCIRPlots(480); }
+            if (isBlockVisible('block_constellation')) { populateConstellationPlots(480); }
+        }
+    };
+    plotSocket = ws;
+    return true;
+}
+
+function closePlotSocketIfUnused() {
+    if (plotSocket !== null &&
+            !isBlockVisible('block_spectrum') &&
+            !isBlockVisible('block_cir') &&
+            !isBlockVisible('block_constellation')) {
+        plotSocket.close();
+        plotSocket = null;
+    }
+}
+
+// See WebRadioInterface::build_plot_frame() for the frame format
+function drawPlotFrame(arrayBuffer) {
+    var view = new DataView(arrayBuffer);
+    if (view.getUint8(0) != 1) {
+        return;
+    }
+
+    var num_sections = view.getUint8(1);
+    var pos = 2;
+    for (var s = 0; s < num_sections; s++) {
+        var type = view.getUint8(pos);
+        var len = view.getUint16(pos + 2, true);
+        var offset = view.getFloat32(pos + 4, true);
+        var step = view.getFloat32(pos + 8, true);
+        var data = new Float32Array(len);
+        for (var i = 0; i < len; i++) {
+            data[i] = offset + step * view.getUint8(pos + 12 + i);
+        }
+        pos += 12 + len;
 
+        if (type == 0 && isBlockVisible('block_spectrum')) {
+            plotMinMax(data, "spectrum", 2, 20, 0);
+        }
+        else if (type == 1 && isBlockVisible('block_spectrum')) {
+            plotMinMax(data, "spectrum", 2, 20, 1);
+        }
+        else if (type == 2 && isBlockVisible('block_cir')) {
+            plotMinMax(data, "cir", 4, 30, 0);
+        }
+        else if (type == 3 && isBlockVisible('block_constellation')) {
+            drawConstellation(data);
+        }
+    }
+}
+
+// Same as plot(), but the data already contains min/max pairs
+function plotMinMax(data, id, scalefactor, shiftfactor, plot_ix) {
+    var canvas = document.getElementById(id);
+    var ctx = canvas.getContext("2d");
+    if (plot_ix == 0) {
+        ctx.fillStyle = "#111100";
+        ctx.fillRect(0,0,data.length/2,150);
+    }
+
+    ctx.beginPath();
+    colors = ["#FF4444", "#33FF55", "#778800"];
+    if (plot_ix < colors.length) {
+        ctx.strokeStyle=colors[plot_ix];
+    }
+    else {
+        ctx.strokeStyle=colors[0];
+    }
+    for (var i = 0; i + 1 < data.length; i += 2) {
+        ctx.moveTo(i/2, 170-scalefactor*(data[i] + shiftfactor));
+        ctx.lineTo(i/2, 170-scalefactor*(data[i+1] + shiftfactor));
+    }
+    ctx.stroke();
+}
@@ -201,6 +201,27 @@ static void to_json(nlohmann::json& j, const tii_measurement_t& tii) {
     };
 }
 
+static void to_json(nlohmann::json& j, const transmitter_sample_t& s) {
+    j = nlohmann::json{
+        {"time", std::chrono::duration_cast<std::chrono::milliseconds>(
+                s.time.time_since_epoch()).count()},
+        {"delay", s.delay_samples},
+        {"level", s.level_dB}
+    };
+}
+
+static void to_json(nlohmann::json& j, const transmitter_track_t& t) {
+    j = nlohmann::json{
+        {"id", t.id},
+        {"comb", t.comb},
+        {"pattern", t.pattern},
+        {"delay", t.delay_samples},
+        {"delay_km", t.getDelayKm()},
+        {"level", t.level_dB},
+        {"history", t.history}
+    };
+}
+
 static void to_json(nlohmann::json& j, const PeakJson& peak)
 {
     j = nlohmann::json{
@@ -217,7 +238,8 @@ static void to_json(nlohmann::json& j, const MuxJson& mux) {
         {"utctime", mux.utctime},
         {"messages", mux.messages},
         {"tii", mux.tii},
-        {"cir_peaks", mux.cir_peaks}
+        {"cir_peaks", mux.cir_peaks},
+        {"transmitters", mux.transmitters}
     };
 
     j["demodulator"]["fic"]["numcrcerrors"] = mux.demodulator_fic_numcrcerrors;
@@ -227,6 +249,13 @@ static void to_json(nlohmann::json& j, const MuxJson& mux) {
     j["demodulator"]["time_last_fct0_frame"] = timelastfct0_ms;
     j["demodulator"]["snr"] = mux.demodulator_snr;
     j["demodulator"]["frequencycorrection"] = mux.demodulator_frequencycorrection;
+    j["demodulator"]["samplingclockoffset"] = mux.demodulator_samplingclockoffset;
+    if (mux.demodulator_coarsesyncconfidence < 0) {
+        j["demodulator"]["coarsesyncconfidence"] = nullptr;
+    }
+    else {
+        j["demodulator"]["coarsesyncconfidence"] = mux.demodulator_coarsesyncconfidence;
+    }
 }
 
 std::string build_mux_json(const MuxJson& mux)
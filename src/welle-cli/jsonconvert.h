@@ -32,6 +32,7 @@
 #include <ctime>
 #include "dab-constants.h"
 #include "backend/radio-controller.h"
+#include "backend/cir-analyser.h"
 
 struct SoftwareJson {
     std::string name;
@@ -138,10 +139,13 @@ struct MuxJson {
 
     double demodulator_snr = 0.0;
     double demodulator_frequencycorrection = 0.0;
+    float demodulator_coarsesyncconfidence = -1.0f;
+    float demodulator_samplingclockoffset = 0.0f;
     std::chrono::system_clock::time_point demodulator_timelastfct0frame;
 
     std::list<tii_measurement_t> tii;
     std::vector<PeakJson> cir_peaks;
+    std::vector<transmitter_track_t> transmitters;
 };
 
 std::string build_mux_json(const MuxJson& mux);
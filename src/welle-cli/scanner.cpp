@@ -0,0 +1,353 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "welle-cli/scanner.h"
+#include "backend/radio-receiver.h"
+#include "backend/signal-presence.h"
+#include "input/channeliser.h"
+#include "various/channels.h"
+
+using namespace std;
+
+// Time to wait for the OFDM processor to decide if there is a signal
+static constexpr auto PRESENCE_TIMEOUT = chrono::seconds(3);
+// Maximum time spent on a channel with a signal
+static constexpr auto CHANNEL_TIMEOUT = chrono::seconds(10);
+// Give up a channel with a signal if no FIB can be decoded
+static constexpr auto FIC_TIMEOUT = chrono::seconds(2);
+// The service list is complete when no new service appears for this long
+static constexpr auto SERVICE_SETTLE_TIME = chrono::seconds(3);
+// Once the service list is complete, wait at most this long for the
+// ensemble label
+static constexpr auto LABEL_TIMEOUT = chrono::seconds(2);
+static constexpr auto POLL_INTERVAL = chrono::milliseconds(100);
+
+// Spectrum measurement on the wideband device, after a settling time
+// that lets the tuner and the AGC adapt to the new frequency.
+static constexpr double OCCUPANCY_SETTLE_SECONDS = 0.02;
+static constexpr double OCCUPANCY_MEASURE_SECONDS = 0.1;
+// Ensembles stand out by more than this from the noise floor
+static constexpr float OCCUPANCY_THRESHOLD_DB = 3.0f;
+
+using Clock = chrono::steady_clock;
+
+class ScanInterface : public RadioControllerInterface {
+    public:
+        enum class Presence { Unknown, Absent, Present };
+
+        virtual void onSNR(float /*snr*/) override { }
+        virtual void onFrequencyCorrectorChange(int /*fine*/, int /*coarse*/) override { }
+        virtual void onSyncChange(char /*isSync*/) override { }
+        virtual void onSignalPresence(bool isSignal) override
+        {
+            lock_guard<mutex> lock(mtx);
+            presence = isSignal ? Presence::Present : Presence::Absent;
+            presenceTime = Clock::now();
+        }
+
+        virtual void onServiceDetected(uint32_t /*sId*/) override
+        {
+            lock_guard<mutex> lock(mtx);
+            lastServiceTime = Clock::now();
+            serviceSeen = true;
+        }
+
+        virtual void onNewEnsemble(uint16_t /*eId*/) override { }
+        virtual void onSetEnsembleLabel(DabLabel& /*label*/) override
+        {
+            lock_guard<mutex> lock(mtx);
+            labelSeen = true;
+        }
+        virtual void onDateTimeUpdate(const dab_date_time_t& /*dateTime*/) override { }
+        virtual void onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* /*fib*/) override
+        {
+            if (crcCheckOk) {
+                lock_guard<mutex> lock(mtx);
+                ficSeen = true;
+            }
+        }
+        virtual void onNewImpulseResponse(std::vector<float>&& /*data*/) override { }
+        virtual void onNewNullSymbol(std::vector<DSPCOMPLEX>&& /*data*/) override { }
+        virtual void onConstellationPoints(std::vector<DSPCOMPLEX>&& /*data*/) override { }
+        virtual void onMessage(message_level_t level, const std::string& text, const std::string& text2 = std::string()) override
+        {
+            if (level == message_level_t::Error) {
+                cerr << "Error: " << text << text2 << endl;
+            }
+        }
+        virtual void onTIIMeasurement(tii_measurement_t&& /*m*/) override { }
+
+        virtual void onInputFailure(void) override
+        {
+            lock_guard<mutex> lock(mtx);
+            inputFailed = true;
+        }
+
+        // Whether the channel needs no more time, sets isSignal accordingly
+        bool isDone(Clock::time_point start, bool& isSignal)
+        {
+            lock_guard<mutex> lock(mtx);
+            const auto now = Clock::now();
+
+            if (inputFailed or presence == Presence::Absent) {
+                isSignal = false;
+                return true;
+            }
+
+            if (presence == Presence::Unknown) {
+                isSignal = false;
+                return now - start > PRESENCE_TIMEOUT;
+            }
+
+            isSignal = true;
+            const auto elapsed = now - presenceTime;
+            const auto settled = now - lastServiceTime;
+            return elapsed > CHANNEL_TIMEOUT or
+                (elapsed > FIC_TIMEOUT and not ficSeen) or
+                (serviceSeen and settled > SERVICE_SETTLE_TIME and
+                 (labelSeen or settled > SERVICE_SETTLE_TIME + LABEL_TIMEOUT));
+        }
+
+    private:
+        mutex mtx;
+        Presence presence = Presence::Unknown;
+        Clock::time_point presenceTime;
+        Clock::time_point lastServiceTime;
+        bool serviceSeen = false;
+        bool labelSeen = false;
+        bool ficSeen = false;
+        bool inputFailed = false;
+};
+
+struct ScanJob {
+    ScanResult *result;
+    ScanInterface si;
+    unique_ptr<RadioReceiver> rx;
+    bool done = false;
+};
+
+static vector<pair<string, int> > all_channels()
+{
+    Channels channels;
+    vector<pair<string, int> > all;
+
+    for (string ch = Channels::firstChannel; not ch.empty();
+            ch = channels.getNextChannel()) {
+        all.emplace_back(ch, channels.getFrequency(ch));
+    }
+    return all;
+}
+
+static void print_result(const ScanResult& r)
+{
+    cerr << "Scan: " << r.channel << " (" << r.frequency / 1000 << " kHz): ";
+    if (not r.signal) {
+        cerr << "no signal" << endl;
+    }
+    else if (r.numServices == 0) {
+        cerr << "signal, but no ensemble decoded" << endl;
+    }
+    else {
+        cerr << "ensemble 0x" << hex << r.eId << dec << " '" << r.label <<
+            "', " << r.numServices << " services" << endl;
+    }
+}
+
+ChannelScanner::ChannelScanner(RadioReceiverOptions rro) :
+    rro(rro)
+{
+    // TII is of no use to find the ensembles
+    this->rro.decodeTII = false;
+}
+
+vector<ScanResult> ChannelScanner::scan(CVirtualInput& input)
+{
+    vector<ScanResult> results;
+
+    for (const auto& ch : all_channels()) {
+        ScanResult r;
+        r.channel = ch.first;
+        r.frequency = ch.second;
+
+        input.setFrequency(r.frequency);
+        input.reset();
+        decodeChannels({&input}, {&r});
+        print_result(r);
+
+        results.push_back(r);
+    }
+
+    input.stop();
+    return results;
+}
+
+vector<ScanResult> ChannelScanner::scan(CChanneliser& channeliser)
+{
+    const int sampleRate = channeliser.getSampleRate();
+    const ChannelOccupancy limits(sampleRate);
+
+    const auto all = all_channels();
+    vector<ScanResult> results(all.size());
+    for (size_t i = 0; i < all.size(); i++) {
+        results[i].channel = all[i].first;
+        results[i].frequency = all[i].second;
+    }
+
+    // Whether a channel can be received and measured with the
+    // wideband device tuned to centre
+    auto fits = [&](int centre, int frequency) {
+        return abs(frequency - centre) + INPUT_RATE/2 <= sampleRate/2 and
+            limits.isMeasurable(centre, frequency);
+    };
+
+    size_t first = 0;
+    while (first < all.size()) {
+        // Take as many adjacent channels as fit into the band
+        size_t last = first;
+        while (last + 1 < all.size() and
+                fits((all[first].second + all[last + 1].second) / 2, all[first].second)) {
+            last++;
+        }
+
+        const int centre = (all[first].second + all[last].second) / 2;
+        channeliser.setCentreFrequency(centre);
+
+        vector<int> frequencies;
+        for (size_t i = first; i <= last; i++) {
+            frequencies.push_back(all[i].second);
+        }
+        const auto occupied = findOccupiedChannels(channeliser, frequencies);
+
+        channeliser.removeChannels();
+        vector<CVirtualInput*> inputs;
+        vector<ScanResult*> candidates;
+        for (size_t i = first; i <= last; i++) {
+            if (occupied[i - first]) {
+                inputs.push_back(&channeliser.addChannel(all[i].second));
+                candidates.push_back(&results[i]);
+            }
+        }
+
+        if (not inputs.empty()) {
+            decodeChannels(inputs, candidates);
+            channeliser.stop();
+        }
+
+        for (size_t i = first; i <= last; i++) {
+            print_result(results[i]);
+        }
+
+        first = last + 1;
+    }
+
+    channeliser.removeChannels();
+    return results;
+}
+
+vector<bool> ChannelScanner::findOccupiedChannels(CChanneliser& channeliser,
+        const vector<int>& frequencies)
+{
+    auto& wideband = channeliser.getWidebandInput();
+    const int sampleRate = channeliser.getSampleRate();
+    vector<bool> occupied(frequencies.size(), false);
+
+    if (not wideband.restart()) {
+        cerr << "Scan: could not start the wideband device" << endl;
+        return occupied;
+    }
+    wideband.reset();
+
+    ChannelOccupancy occupancy(sampleRate);
+    const size_t settle = OCCUPANCY_SETTLE_SECONDS * sampleRate;
+    const size_t total = settle + OCCUPANCY_MEASURE_SECONDS * sampleRate;
+    vector<DSPCOMPLEX> buf(16384);
+
+    size_t done = 0;
+    while (done < total) {
+        if ((size_t)wideband.getSamplesToRead() < buf.size()) {
+            if (not wideband.is_ok()) {
+                cerr << "Scan: wideband device failed" << endl;
+                break;
+            }
+            this_thread::sleep_for(chrono::milliseconds(1));
+            continue;
+        }
+
+        const int32_t n = wideband.getSamples(buf.data(), buf.size());
+        if (done + n > settle) {
+            const size_t skip = done < settle ? settle - done : 0;
+            occupancy.add(buf.data() + skip, n - skip);
+        }
+        done += n;
+    }
+    wideband.stop();
+
+    const auto levels = occupancy.measure(channeliser.getCentreFrequency(), frequencies);
+    for (size_t i = 0; i < frequencies.size(); i++) {
+        occupied[i] = levels[i] > OCCUPANCY_THRESHOLD_DB;
+    }
+    return occupied;
+}
+
+void ChannelScanner::decodeChannels(const vector<CVirtualInput*>& inputs,
+        const vector<ScanResult*>& results)
+{
+    vector<unique_ptr<ScanJob> > jobs;
+    const auto start = Clock::now();
+
+    for (size_t i = 0; i < inputs.size(); i++) {
+        auto job = make_unique<ScanJob>();
+        job->result = results[i];
+        job->rx = make_unique<RadioReceiver>(job->si, *inputs[i], rro);
+        job->rx->restart(true);
+        jobs.push_back(move(job));
+    }
+
+    size_t remaining = jobs.size();
+    while (remaining > 0) {
+        this_thread::sleep_for(POLL_INTERVAL);
+
+        for (auto& job : jobs) {
+            if (job->done or not job->si.isDone(start, job->result->signal)) {
+                continue;
+            }
+
+            auto& rx = *job->rx;
+            job->result->eId = rx.getEnsembleId();
+            job->result->label = rx.getEnsembleLabel().utf8_label();
+            job->result->numServices = rx.getServiceList().size();
+
+            // Free the CPU for the other channels
+            rx.stop();
+            job->done = true;
+            remaining--;
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "backend/radio-receiver-options.h"
+#include "input/virtual_input.h"
+
+class CChanneliser;
+
+struct ScanResult {
+    std::string channel;
+    int frequency = 0;
+
+    // Whether a DAB signal was found, the other fields are only
+    // valid if the ensemble could be decoded.
+    bool signal = false;
+    uint16_t eId = 0;
+    std::string label;
+    size_t numServices = 0;
+};
+
+/* Looks for ensembles on all channels of Band III and L-Band.
+ *
+ * Empty channels are given up as soon as the OFDM processor reports the
+ * absence of a null symbol. Channels with a signal are left once all
+ * services and the ensemble label are known, or when no FIC can be
+ * decoded.
+ *
+ * With a channeliser, every tuning of the wideband device covers several
+ * channels. Their spectrum is looked at first, and only the channels
+ * showing some energy are then decoded, all at the same time. */
+class ChannelScanner {
+    public:
+        ChannelScanner(RadioReceiverOptions rro);
+
+        std::vector<ScanResult> scan(CVirtualInput& input);
+        std::vector<ScanResult> scan(CChanneliser& channeliser);
+
+    private:
+        // Run a receiver on each input until every channel is done
+        void decodeChannels(const std::vector<CVirtualInput*>& inputs,
+                const std::vector<ScanResult*>& results);
+
+        // Return for each channel whether it shows some energy
+        std::vector<bool> findOccupiedChannels(CChanneliser& channeliser,
+                const std::vector<int>& frequencies);
+
+        RadioReceiverOptions rro;
+};
@@ -95,9 +95,6 @@ class ChannelSimulator : public CVirtualInput
             return r;
         }
 
-        virtual vector<DSPCOMPLEX> getSpectrumSamples(int size)
-            { return parentInput->getSpectrumSamples(size); }
-
         virtual int32_t getSamplesToRead(void)
             { return parentInput->getSamplesToRead(); }
 
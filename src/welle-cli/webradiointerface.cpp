@@ -35,6 +35,7 @@
 #include <future>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <regex>
 #include <signal.h>
 #include <stdexcept>
@@ -47,6 +48,10 @@
  #include <sys/socket.h>
 #endif
 
+#ifdef HAVE_ZLIB
+# include <zlib.h>
+#endif
+
 #include <utility>
 #include "Socket.h"
 #include "channels.h"
@@ -55,6 +60,7 @@
 #include "virtual_input.h"
 #include "welle-cli/jsonconvert.h"
 #include "welle-cli/webprogrammehandler.h"
+#include "welle-cli/websocket.h"
 
 #include "index.html.h"
 #include "index.js.h"
@@ -83,12 +89,20 @@
 #define ASSERT_RX if (not rx) throw logic_error("rx does not exist")
 
 constexpr size_t MAX_PENDING_MESSAGES = 512;
+constexpr size_t FIB_LENGTH = 32;
+constexpr size_t FIB_RING_LENGTH = 3*250; // six seconds
+constexpr auto MUX_JSON_MIN_AGE = std::chrono::milliseconds(500);
+constexpr auto MUX_JSON_MAX_AGE = std::chrono::seconds(1);
+// A NULL symbol arrives every 96 ms in transmission mode I
+constexpr auto SPECTRUM_REQUEST_WAIT = std::chrono::milliseconds(500);
 
 using namespace std;
 
 static const char* http_ok = "HTTP/1.0 200 OK\r\n";
+static const char* http_304 = "HTTP/1.0 304 Not Modified\r\n";
 static const char* http_400 = "HTTP/1.0 400 Bad Request\r\n";
 static const char* http_404 = "HTTP/1.0 404 Not Found\r\n";
+static const char* http_301 = "HTTP/1.0 301 Moved Permanently\r\n";
 static const char* http_405 = "HTTP/1.0 405 Method Not Allowed\r\n";
 static const char* http_500 = "HTTP/1.0 500 Internal Server Error\r\n";
 static const char* http_503 = "HTTP/1.0 503 Service Unavailable\r\n";
@@ -113,6 +127,24 @@ static const char* http_contenttype_ico =
 
 static const char* http_nocache = "Cache-Control: no-cache\r\n";
 
+// Labels come from the air and may contain any character
+static string html_escape(const string& text)
+{
+    string escaped;
+    escaped.reserve(text.size());
+    for (const char c : text) {
+        switch (c) {
+            case '&': escaped += "&amp;"; break;
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            case '"': escaped += "&quot;"; break;
+            case '\'': escaped += "&#39;"; break;
+            default: escaped += c; break;
+        }
+    }
+    return escaped;
+}
+
 static string to_hex(uint32_t value, int width)
 {
     stringstream sidstream;
@@ -137,27 +169,21 @@ static bool send_http_response(Socket& s, const string& statuscode,
 }
 
 WebRadioInterface::WebRadioInterface(CVirtualInput& in,
-        int port,
+        const string& url_prefix,
         DecodeSettings ds,
         RadioReceiverOptions rro) :
+    url_prefix(url_prefix),
     dabparams(1),
     input(in),
-    spectrum_fft_handler(dabparams.T_u),
     rro(rro),
-    decode_settings(ds)
+    decode_settings(ds),
+    fib_ring(FIB_RING_LENGTH * FIB_LENGTH)
 {
     {
         // Ensure that rx always exists when rx_mut is free!
         lock_guard<mutex> lock(rx_mut);
 
-        bool success = serverSocket.bind(port);
-        if (success) {
-            success = serverSocket.listen();
-        }
-
-        if (success) {
-            rx = make_unique<RadioReceiver>(*this, in, rro);
-        }
+        rx = make_unique<RadioReceiver>(*this, in, rro);
 
         if (not rx) {
             throw runtime_error("Could not initialise WebRadioInterface");
@@ -168,6 +194,7 @@ WebRadioInterface::WebRadioInterface(CVirtualInput& in,
     }
 
     programme_handler_thread = thread(&WebRadioInterface::handle_phs, this);
+    plot_thread = thread(&WebRadioInterface::handle_plots, this);
 }
 
 WebRadioInterface::~WebRadioInterface()
@@ -177,6 +204,11 @@ WebRadioInterface::~WebRadioInterface()
         programme_handler_thread.join();
     }
 
+    plots_running = false;
+    if (plot_thread.joinable()) {
+        plot_thread.join();
+    }
+
     {
         lock_guard<mutex> lock(rx_mut);
         rx.reset();
@@ -190,6 +222,12 @@ void WebRadioInterface::check_decoders_required()
     lock_guard<mutex> lock(rx_mut);
     ASSERT_RX;
 
+    if (restart_decoders.exchange(false)) {
+        cerr << "Restart service decoders" << endl;
+        rx->stopServiceDecoders();
+        programmes_being_decoded.clear();
+    }
+
     try {
         for (auto& s : rx->getServiceList()) {
             const auto sid = s.serviceId;
@@ -303,7 +341,9 @@ void WebRadioInterface::retune(const string& channel)
         }
 
         time_rx_created = chrono::system_clock::now();
+        restart_decoders = false;
         rx->restart(false);
+        mux_json_version++;
 
         cerr << "RETUNE Start programme handler" << endl;
         running = true;
@@ -451,127 +491,135 @@ static http_request_t parse_http_headers(Socket& s) {
     return r;
 }
 
-bool WebRadioInterface::dispatch_client(Socket&& client)
+// Header values keep the whitespace after the colon and the CRLF
+static string header_value(const http_request_t& r, const string& name)
 {
-    Socket s(move(client));
-
-    bool success = false;
+    const auto it = r.headers.find(name);
+    if (it == r.headers.end()) {
+        return "";
+    }
 
-    if (not s.valid()) {
-        cerr << "socket in dispatcher not valid!" << endl;
-        return false;
+    const string& v = it->second;
+    const auto first = v.find_first_not_of(" \t\r\n");
+    if (first == string::npos) {
+        return "";
     }
+    const auto last = v.find_last_not_of(" \t\r\n");
+    return v.substr(first, last - first + 1);
+}
 
-    const auto req = parse_http_headers(s);
+bool WebRadioInterface::dispatch_request(Socket& s, const http_request_t& req)
+{
+    bool success = false;
 
-    if (not req.valid) {
-        return false;
-    }
-    else {
-        if (req.is_get) {
-            if (req.url == "/") {
-                success = send_file(s, index_html, index_html_len, http_contenttype_html);
-            }
-            else if (req.url == "/index.js") {
-                success = send_file(s, index_js, index_js_len, http_contenttype_js);
-            }
-            else if (req.url == "/favicon.ico") {
-                success = send_file(s, favicon_ico, favicon_ico_len, http_contenttype_ico);
-            }
-            else if (req.url == "/mux.json") {
-                success = send_mux_json(s);
-            }
-            else if (req.url == "/mux.m3u") {
-                success = send_mux_playlist(s);
-            }
-            else if (req.url == "/fic") {
-                success = send_fic(s);
-            }
-            else if (req.url == "/impulseresponse") {
-                success = send_impulseresponse(s);
-            }
-            else if (req.url == "/spectrum") {
-                success = send_spectrum(s);
-            }
-            else if (req.url == "/constellation") {
-                success = send_constellation(s);
-            }
-            else if (req.url == "/nullspectrum") {
-                success = send_null_spectrum(s);
-            }
-            else if (req.url == "/channel") {
-                success = send_channel(s);
+    if (req.is_get) {
+        if (req.url == "/") {
+            success = send_file(s, index_html, index_html_len, http_contenttype_html);
+        }
+        else if (req.url == "/index.js") {
+            success = send_file(s, index_js, index_js_len, http_contenttype_js);
+        }
+        else if (req.url == "/favicon.ico") {
+            success = send_file(s, favicon_ico, favicon_ico_len, http_contenttype_ico);
+        }
+        else if (req.url == "/mux.json") {
+            success = send_mux_json(s,
+                    header_value(req, "If-None-Match"),
+                    header_value(req, "Accept-Encoding").find("gzip") != string::npos);
+        }
+        else if (req.url == "/mux.m3u") {
+            success = send_mux_playlist(s);
+        }
+        else if (req.url == "/fic") {
+            success = send_fic(s);
+        }
+        else if (req.url == "/impulseresponse") {
+            success = send_impulseresponse(s);
+        }
+        else if (req.url == "/spectrum") {
+            success = send_spectrum(s);
+        }
+        else if (req.url == "/constellation") {
+            success = send_constellation(s);
+        }
+        else if (req.url == "/nullspectrum") {
+            success = send_null_spectrum(s);
+        }
+        else if (req.url == "/channel") {
+            success = send_channel(s);
+        }
+        else if (req.url == "/plots") {
+            success = send_plot_stream(s, header_value(req, "Sec-WebSocket-Key"));
+        }
+        else if (req.url == "/fftwindowplacement" or req.url == "/enablecoarsecorrector") {
+            send_http_response(s, http_405,
+                    "405 Method Not Allowed\r\n" + req.url + " is POST-only");
+            return false;
+        }
+        else {
+            bool url_handled = false;
+            const regex regex_slide(R"(^[/]slide[/]([^ ]+))");
+            smatch match_slide;
+            if (regex_search(req.url, match_slide, regex_slide)) {
+                success = send_slide(s, match_slide[1]);
+                url_handled = true;
             }
-            else if (req.url == "/fftwindowplacement" or req.url == "/enablecoarsecorrector") {
-                send_http_response(s, http_405,
-                        "405 Method Not Allowed\r\n" + req.url + " is POST-only");
-                return false;
+
+            const regex regex_stream(R"(^[/]stream[/]([^ ]+))");
+            smatch match_stream;
+            if (regex_search(req.url, match_stream, regex_stream)) {
+                success = send_stream(s, match_stream[1]);
+                url_handled = true;
             }
-            else {
-                bool url_handled = false;
-                const regex regex_slide(R"(^[/]slide[/]([^ ]+))");
-                smatch match_slide;
-                if (regex_search(req.url, match_slide, regex_slide)) {
-                    success = send_slide(s, match_slide[1]);
-                    url_handled = true;
-                }
 
-                const regex regex_stream(R"(^[/]stream[/]([^ ]+))");
-                smatch match_stream;
-                if (regex_search(req.url, match_stream, regex_stream)) {
-                    success = send_stream(s, match_stream[1]);
+            if (decode_settings.outputCodec == OutputCodec::MP3)
+            {
+                const regex regex_mp3(R"(^[/]mp3[/]([^ ]+))");
+                smatch match_mp3;
+                if (regex_search(req.url, match_mp3, regex_mp3)) {
+                    success = send_stream(s, match_mp3[1]);
                     url_handled = true;
                 }
+            }
 
-                if (decode_settings.outputCodec == OutputCodec::MP3)
-                {
-                    const regex regex_mp3(R"(^[/]mp3[/]([^ ]+))");
-                    smatch match_mp3;
-                    if (regex_search(req.url, match_mp3, regex_mp3)) {
-                        success = send_stream(s, match_mp3[1]);
-                        url_handled = true;
-                    }
-                }
-
-                if (decode_settings.outputCodec == OutputCodec::FLAC)
-                {
-                    const regex regex_flac(R"(^[/]flac[/]([^ ]+))");
-                    smatch match_flac;
-                    if (regex_search(req.url, match_flac, regex_flac)) {
-                        success = send_stream(s, match_flac[1]);
-                        url_handled = true;
-                    }
+            if (decode_settings.outputCodec == OutputCodec::FLAC)
+            {
+                const regex regex_flac(R"(^[/]flac[/]([^ ]+))");
+                smatch match_flac;
+                if (regex_search(req.url, match_flac, regex_flac)) {
+                    success = send_stream(s, match_flac[1]);
+                    url_handled = true;
                 }
+            }
 
-                if (not url_handled) {
-                    cerr << "Could not understand GET request " << req.url << endl;
-                }
+            if (not url_handled) {
+                cerr << "Could not understand GET request " << req.url << endl;
             }
         }
-        else if (req.is_post) {
-            if (req.url == "/channel") {
-                success = handle_channel_post(s, req.post_data);
-            }
-            else if (req.url == "/fftwindowplacement") {
-                success = handle_fft_window_placement_post(s, req.post_data);
-            }
-            else if (req.url == "/enablecoarsecorrector") {
-                success = handle_coarse_corrector_post(s, req.post_data);
-            }
-            else {
-                cerr << "Could not understand POST request " << req.url << endl;
-            }
+    }
+    else if (req.is_post) {
+        if (req.url == "/channel") {
+            success = handle_channel_post(s, req.post_data);
         }
-        else {
-            throw logic_error("valid req is neither GET nor POST!");
+        else if (req.url == "/fftwindowplacement") {
+            success = handle_fft_window_placement_post(s, req.post_data);
         }
-
-        if (not success) {
-            send_http_response(s, http_404, "Could not understand request.\r\n");
+        else if (req.url == "/enablecoarsecorrector") {
+            success = handle_coarse_corrector_post(s, req.post_data);
         }
+        else {
+            cerr << "Could not understand POST request " << req.url << endl;
+        }
+    }
+    else {
+        throw logic_error("valid req is neither GET nor POST!");
+    }
 
-        return success;
+    if (not success) {
+        send_http_response(s, http_404, "Could not understand request.\r\n");
     }
+
+    return success;
 }
 
 bool WebRadioInterface::send_file(Socket& s,
@@ -628,7 +676,7 @@ static vector<PeakJson> calculate_cir_peaks(const vector<float>& cir_linear)
     return peaks;
 }
 
-bool WebRadioInterface::send_mux_json(Socket& s)
+string WebRadioInterface::build_mux_json_document()
 {
     MuxJson mux_json;
 
@@ -684,7 +732,7 @@ bool WebRadioInterface::send_mux_json(Socket& s)
                                      "unknown")});
                         if (sc.audioType() == AudioServiceComponentType::DAB or
                             sc.audioType() == AudioServiceComponentType::DABPlus) {
-                            string urlmp3 = "/mp3/" + to_hex(s.serviceId, 4);
+                            string urlmp3 = url_prefix + "/mp3/" + to_hex(s.serviceId, 4);
                             service.url_mp3 = urlmp3;
                         }
                         break;
@@ -795,8 +843,11 @@ bool WebRadioInterface::send_mux_json(Socket& s)
         mux_json.demodulator_snr = last_snr;
         mux_json.demodulator_frequencycorrection = last_fine_correction + last_coarse_correction;
         mux_json.demodulator_timelastfct0frame = rx->getReceiverStats().timeLastFCT0Frame;
+        mux_json.demodulator_coarsesyncconfidence = rx->getCoarseSyncConfidence();
+        mux_json.demodulator_samplingclockoffset = rx->getSamplingClockOffset();
 
         mux_json.tii = getTiiStats();
+        mux_json.transmitters = rx->getTransmitterTracks();
     }
 
     {
@@ -804,13 +855,114 @@ bool WebRadioInterface::send_mux_json(Socket& s)
         mux_json.cir_peaks = calculate_cir_peaks(last_CIR);
     }
 
-    if (not send_http_response(s, http_ok, "", http_contenttype_json)) {
+    return build_mux_json(mux_json);
+}
+
+#ifdef HAVE_ZLIB
+static string gzip_compress(const string& data)
+{
+    z_stream zs = {};
+    // 15 window bits + 16 selects the gzip wrapper
+    if (deflateInit2(&zs, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8,
+                Z_DEFAULT_STRATEGY) != Z_OK) {
+        return "";
+    }
+
+    string out(deflateBound(&zs, data.size()), '\0');
+    zs.next_in = (Bytef*)data.data();
+    zs.avail_in = data.size();
+    zs.next_out = (Bytef*)&out[0];
+    zs.avail_out = out.size();
+
+    const int ret = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+
+    return ret == Z_STREAM_END ? out : "";
+}
+#endif
+
+// FNV-1a, good enough to tell two versions of the mux.json apart
+static string calculate_etag(const string& data)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (const char c : data) {
+        hash ^= (uint8_t)c;
+        hash *= 0x100000001b3;
+    }
+
+    stringstream ss;
+    ss << '"' << hex << setfill('0') << setw(16) << hash << '"';
+    return ss.str();
+}
+
+shared_ptr<const WebRadioInterface::MuxJsonCache> WebRadioInterface::get_mux_json()
+{
+    using namespace chrono;
+    const auto now = steady_clock::now();
+
+    lock_guard<mutex> lock(mux_json_mut);
+
+    if (mux_json_cache) {
+        const auto age = now - mux_json_cache->time_built;
+        const bool changed = mux_json_cache->version != mux_json_version;
+
+        // Rebuild at most every MUX_JSON_MIN_AGE when the ensemble changed,
+        // and every MUX_JSON_MAX_AGE anyway to refresh the measurements,
+        // audio levels and DLS, which are not tracked by the version.
+        if ((not changed or age < MUX_JSON_MIN_AGE) and age < MUX_JSON_MAX_AGE) {
+            return mux_json_cache;
+        }
+    }
+
+    auto cache = make_shared<MuxJsonCache>();
+    cache->version = mux_json_version;
+    cache->json = build_mux_json_document();
+    cache->etag = calculate_etag(cache->json);
+#ifdef HAVE_ZLIB
+    cache->json_gzip = gzip_compress(cache->json);
+#endif
+    cache->time_built = now;
+
+    mux_json_cache = cache;
+    return mux_json_cache;
+}
+
+bool WebRadioInterface::send_mux_json(Socket& s,
+        const string& if_none_match, bool accept_gzip)
+{
+    const auto cache = get_mux_json();
+
+    const bool not_modified = if_none_match == "*" or
+        if_none_match.find(cache->etag) != string::npos;
+
+    const bool use_gzip = accept_gzip and not cache->json_gzip.empty();
+    const string& body = use_gzip ? cache->json_gzip : cache->json;
+
+    string headers = not_modified ? http_304 : http_ok;
+    headers += http_contenttype_json;
+    headers += http_nocache;
+    headers += "ETag: " + cache->etag + "\r\n";
+    headers += "Vary: Accept-Encoding\r\n";
+    if (not not_modified) {
+        if (use_gzip) {
+            headers += "Content-Encoding: gzip\r\n";
+        }
+        headers += "Content-Length: " + to_string(body.size()) + "\r\n";
+    }
+    headers += "\r\n";
+
+    ssize_t ret = s.send(headers.data(), headers.size(), MSG_NOSIGNAL);
+    if (ret == -1) {
+        cerr << "Failed to send mux.json headers" << endl;
         return false;
     }
 
-    const auto json_str = build_mux_json(mux_json);
+    if (not_modified) {
+        return true;
+    }
 
-    ssize_t ret = s.send(json_str.c_str(), json_str.size(), MSG_NOSIGNAL);
+    ret = s.send(body.data(), body.size(), MSG_NOSIGNAL);
     if (ret == -1) {
         cerr << "Failed to send mux.json data" << endl;
         return false;
@@ -837,7 +989,7 @@ bool WebRadioInterface::send_mux_playlist(Socket& s)
                     case TransportMode::Audio:
                         if (sc.audioType() == AudioServiceComponentType::DAB or
                             sc.audioType() == AudioServiceComponentType::DABPlus) {
-                            url_mp3 = "/mp3/" + hex_sid;
+                            url_mp3 = url_prefix + "/mp3/" + hex_sid;
                         }
                         break;
                     default:
@@ -983,19 +1135,56 @@ bool WebRadioInterface::send_fic(Socket& s)
         return false;
     }
 
+    uint64_t cursor = 0;
+    {
+        lock_guard<mutex> lock(fib_mut);
+        // Start with the FIBs received from now on
+        cursor = fib_ring_head;
+    }
+
+    vector<uint8_t> batch;
+    batch.reserve(fib_ring.size());
+
     while (true) {
-        unique_lock<mutex> lock(fib_mut);
-        while (fib_blocks.empty()) {
-            new_fib_block_available.wait_for(lock, chrono::seconds(1));
-        }
-        ssize_t ret = s.send(fib_blocks.front().data(),
-                fib_blocks.front().size(), MSG_NOSIGNAL);
-        if (ret == -1) {
-            cerr << "Failed to send FIC data" << endl;
-            return false;
+        batch.clear();
+
+        {
+            unique_lock<mutex> lock(fib_mut);
+            while (cursor == fib_ring_head) {
+                new_fib_block_available.wait_for(lock, chrono::seconds(1));
+            }
+
+            if (fib_ring_head - cursor > FIB_RING_LENGTH) {
+                cerr << "FIC client too slow, dropped " <<
+                    fib_ring_head - cursor - FIB_RING_LENGTH << " FIBs" << endl;
+                cursor = fib_ring_head - FIB_RING_LENGTH;
+            }
+
+            // Copy everything this client has not seen yet, in at most
+            // two parts because the ring can wrap around
+            while (cursor != fib_ring_head) {
+                const size_t start = cursor % FIB_RING_LENGTH;
+                const size_t count = min<uint64_t>(
+                        fib_ring_head - cursor, FIB_RING_LENGTH - start);
+                batch.insert(batch.end(),
+                        fib_ring.begin() + start * FIB_LENGTH,
+                        fib_ring.begin() + (start + count) * FIB_LENGTH);
+                cursor += count;
+            }
         }
 
-        fib_blocks.pop_front();
+        // The send happens without holding fib_mut, so that a slow client
+        // cannot hold up the decoder or the other clients.
+        size_t sent = 0;
+        while (sent < batch.size()) {
+            ssize_t ret = s.send(batch.data() + sent,
+                    batch.size() - sent, MSG_NOSIGNAL);
+            if (ret <= 0) {
+                cerr << "Failed to send FIC data" << endl;
+                return false;
+            }
+            sent += ret;
+        }
     }
     return true;
 }
@@ -1010,7 +1199,7 @@ bool WebRadioInterface::send_impulseresponse(Socket& s)
     lock_guard<mutex> lock(plotdata_mut);
     vector<float> cir_db(last_CIR.size());
     transform(last_CIR.begin(), last_CIR.end(), cir_db.begin(),
-            [](float y) { return 10.0f * log10(y); });
+            [](float y) { return 10.0f * log10(y + 1e-10f); });
 
     size_t lengthBytes = cir_db.size() * sizeof(float);
     ssize_t ret = s.send(cir_db.data(), lengthBytes, MSG_NOSIGNAL);
@@ -1022,19 +1211,8 @@ bool WebRadioInterface::send_impulseresponse(Socket& s)
     return true;
 }
 
-static bool send_fft_data(Socket& s, DSPCOMPLEX *spectrumBuffer, size_t T_u)
+static bool send_fft_data(Socket& s, const vector<float>& spectrum)
 {
-    vector<float> spectrum(T_u);
-
-    // Shift FFT samples
-    const size_t half_Tu = T_u / 2;
-    for (size_t i = 0; i < half_Tu; i++) {
-        spectrum[i] = abs(spectrumBuffer[i + half_Tu]);
-    }
-    for (size_t i = half_Tu; i < T_u; i++) {
-        spectrum[i] = abs(spectrumBuffer[i - half_Tu]);
-    }
-
     if (not send_http_response(s, http_ok, "", http_contenttype_data)) {
         cerr << "Failed to send spectrum headers" << endl;
         return false;
@@ -1050,44 +1228,39 @@ static bool send_fft_data(Socket& s, DSPCOMPLEX *spectrumBuffer, size_t T_u)
     return true;
 }
 
+std::vector<float> WebRadioInterface::get_spectrum(
+        SpectrumEngine::Source source, chrono::milliseconds maxWait)
+{
+    lock_guard<mutex> lock(rx_mut);
+    if (not rx) {
+        return {};
+    }
+    return rx->getSpectrum(source, maxWait);
+}
+
 bool WebRadioInterface::send_spectrum(Socket& s)
 {
-    // Get FFT buffer
-    DSPCOMPLEX* spectrumBuffer = spectrum_fft_handler.getVector();
-    auto samples = input.getSpectrumSamples(dabparams.T_u);
+    // The spectrum is computed only while it is read, so a single
+    // request has to wait for the first one
+    auto spectrum = get_spectrum(SpectrumEngine::Source::Signal,
+            SPECTRUM_REQUEST_WAIT);
 
     // Continue only if we got data
-    if (samples.size() != (size_t)dabparams.T_u)
+    if (spectrum.empty())
         return false;
 
-    copy(samples.begin(), samples.end(), spectrumBuffer);
-
-    // Do FFT to get the spectrum
-    spectrum_fft_handler.do_FFT();
-
-    return send_fft_data(s, spectrumBuffer, dabparams.T_u);
+    return send_fft_data(s, spectrum);
 }
 
 bool WebRadioInterface::send_null_spectrum(Socket& s)
 {
-    // Get FFT buffer
-    DSPCOMPLEX* spectrumBuffer = spectrum_fft_handler.getVector();
+    auto spectrum = get_spectrum(SpectrumEngine::Source::NullSymbol,
+            SPECTRUM_REQUEST_WAIT);
 
-    lock_guard<mutex> lock(plotdata_mut);
-    if (last_NULL.empty()) {
+    if (spectrum.empty())
         return false;
-    }
-    else if (last_NULL.size() != (size_t)dabparams.T_null) {
-        cerr << "Invalid NULL size " << last_NULL.size() << endl;
-        return false;
-    }
-
-    copy(last_NULL.begin(), last_NULL.begin() + dabparams.T_u, spectrumBuffer);
-
-    // Do FFT to get the spectrum
-    spectrum_fft_handler.do_FFT();
 
-    return send_fft_data(s, spectrumBuffer, dabparams.T_u);
+    return send_fft_data(s, spectrum);
 }
 
 bool WebRadioInterface::send_constellation(Socket& s)
@@ -1156,6 +1329,184 @@ bool WebRadioInterface::send_channel(Socket& s)
     return true;
 }
 
+bool WebRadioInterface::send_plot_stream(Socket& s, const string& ws_key)
+{
+    if (ws_key.empty()) {
+        send_http_response(s, http_400,
+                "400 Bad Request\r\n/plots is a WebSocket endpoint");
+        return true;
+    }
+
+    if (not websocket::send_handshake(s, ws_key)) {
+        return false;
+    }
+
+    num_plot_subscribers++;
+
+    uint64_t seq_sent = 0;
+    bool client_alive = true;
+    while (client_alive and plots_running) {
+        shared_ptr<const vector<uint8_t> > frame;
+        {
+            unique_lock<mutex> lock(plot_frame_mut);
+            plot_frame_available.wait_for(lock, chrono::seconds(2),
+                    [&]{ return plot_frame_seq != seq_sent or not plots_running; });
+
+            if (plot_frame_seq != seq_sent) {
+                frame = last_plot_frame;
+                seq_sent = plot_frame_seq;
+            }
+        }
+
+        if (frame) {
+            client_alive = websocket::send_binary(s, frame->data(), frame->size());
+        }
+        else {
+            // Nothing new to plot, check that the client is still there
+            client_alive = websocket::send_ping(s);
+        }
+    }
+
+    num_plot_subscribers--;
+    return true;
+}
+
+/* A plot frame is a sequence of sections, each containing one plot
+ * quantised to one byte per value. All multi-byte fields are little-endian:
+ *
+ *  uint8   version (1)
+ *  uint8   number of sections
+ *  for each section:
+ *    uint8   plot type, see plot_type_t
+ *    uint8   decimation, number of input values per min/max pair, or 0 if
+ *            every value is sent as is
+ *    uint16  payload length in bytes
+ *    float32 offset
+ *    float32 step, the plotted value is offset + step * byte
+ *    payload
+ */
+enum class plot_type_t : uint8_t {
+    Spectrum = 0,
+    NullSpectrum = 1,
+    ImpulseResponse = 2,
+    Constellation = 3,
+};
+
+static void append_plot_section(vector<uint8_t>& frame, plot_type_t type,
+        uint8_t decimation, float offset, float step,
+        const vector<uint8_t>& payload)
+{
+    frame.push_back((uint8_t)type);
+    frame.push_back(decimation);
+    frame.push_back(payload.size() & 0xFF);
+    frame.push_back((payload.size() >> 8) & 0xFF);
+
+    for (float f : {offset, step}) {
+        uint32_t u = 0;
+        memcpy(&u, &f, sizeof(u));
+        for (int i = 0; i < 4; i++) {
+            frame.push_back((u >> (8 * i)) & 0xFF);
+        }
+    }
+
+    copy(payload.begin(), payload.end(), back_inserter(frame));
+
+    // Number of sections
+    frame[1]++;
+}
+
+// Keep the minimum and maximum of every group of decimation values,
+// quantised on a scale that spans the range of the values.
+static void append_minmax_section(vector<uint8_t>& frame, plot_type_t type,
+        const vector<float>& values, size_t decimation)
+{
+    if (values.empty()) {
+        return;
+    }
+
+    const auto minmax = minmax_element(values.begin(), values.end());
+    const float offset = *minmax.first;
+    const float range = *minmax.second - offset;
+    const float step = range > 0 ? range / 255.0f : 1.0f;
+
+    vector<uint8_t> payload;
+    payload.reserve(2 * (values.size() / decimation + 1));
+    for (size_t i = 0; i < values.size(); i += decimation) {
+        const auto last = min(values.size(), i + decimation);
+        const auto group = minmax_element(values.begin() + i, values.begin() + last);
+        payload.push_back(lrintf((*group.first - offset) / step));
+        payload.push_back(lrintf((*group.second - offset) / step));
+    }
+
+    append_plot_section(frame, type, decimation, offset, step, payload);
+}
+
+vector<uint8_t> WebRadioInterface::build_plot_frame()
+{
+    // Every canvas in index.html is 512 pixels wide, which is a quarter of
+    // T_u in mode I.
+    const size_t decimation = 4;
+
+    vector<uint8_t> frame;
+    frame.push_back(1);
+    frame.push_back(0);
+
+    append_minmax_section(frame, plot_type_t::Spectrum,
+            get_spectrum(SpectrumEngine::Source::Signal), decimation);
+    append_minmax_section(frame, plot_type_t::NullSpectrum,
+            get_spectrum(SpectrumEngine::Source::NullSymbol), decimation);
+
+    vector<float> cir_db;
+    vector<uint8_t> phases;
+    {
+        lock_guard<mutex> lock(plotdata_mut);
+
+        cir_db.resize(last_CIR.size());
+        transform(last_CIR.begin(), last_CIR.end(), cir_db.begin(),
+                [](float y) { return 10.0f * log10(y + 1e-10f); });
+
+        phases.resize(last_constellation.size());
+        transform(last_constellation.begin(), last_constellation.end(), phases.begin(),
+                [](const DSPCOMPLEX& z) {
+                    return (uint8_t)lrintf((arg(z) + (float)M_PI) * 255.0f / (2.0f * (float)M_PI));
+                });
+    }
+
+    append_minmax_section(frame, plot_type_t::ImpulseResponse, cir_db, decimation);
+
+    if (not phases.empty()) {
+        append_plot_section(frame, plot_type_t::Constellation, 0,
+                -180.0f, 360.0f / 255.0f, phases);
+    }
+
+    return frame;
+}
+
+void WebRadioInterface::handle_plots()
+{
+    const auto interval = chrono::milliseconds(max(1,
+            1000 / max(1, decode_settings.plot_frames_per_second)));
+
+    while (plots_running) {
+        this_thread::sleep_for(interval);
+
+        if (num_plot_subscribers == 0) {
+            continue;
+        }
+
+        auto frame = make_shared<vector<uint8_t> >(build_plot_frame());
+
+        {
+            lock_guard<mutex> lock(plot_frame_mut);
+            last_plot_frame = move(frame);
+            plot_frame_seq++;
+        }
+        plot_frame_available.notify_all();
+    }
+
+    plot_frame_available.notify_all();
+}
+
 bool WebRadioInterface::handle_fft_window_placement_post(Socket& s, const string& fft_window_placement)
 {
     cerr << "POST fft window: " << fft_window_placement << endl;
@@ -1188,6 +1539,7 @@ bool WebRadioInterface::handle_fft_window_placement_post(Socket& s, const string
         ASSERT_RX;
         rx->setReceiverOptions(rro);
     }
+    mux_json_version++;
 
     string response = http_ok;
     response += http_contenttype_text;
@@ -1231,6 +1583,7 @@ bool WebRadioInterface::handle_coarse_corrector_post(Socket& s, const string& co
         ASSERT_RX;
         rx->setReceiverOptions(rro);
     }
+    mux_json_version++;
 
     string response = http_ok;
     response += http_contenttype_text;
@@ -1406,7 +1759,119 @@ static void handler(int /*signum*/)
 const int sig_caught = 0;
 #endif
 
-void WebRadioInterface::serve()
+void WebRadioInterface::stop()
+{
+    running = false;
+    if (programme_handler_thread.joinable()) {
+        programme_handler_thread.join();
+    }
+
+    // Terminate the WebSocket plot streams
+    plots_running = false;
+    plot_frame_available.notify_all();
+}
+
+void WebRadioInterface::clear_programme_handlers()
+{
+    phs.clear();
+    programmes_being_decoded.clear();
+    carousel_services_available.clear();
+    carousel_services_active.clear();
+}
+
+string WebRadioInterface::get_description()
+{
+    string description;
+    try {
+        description = channels.getChannelForFrequency(input.getFrequency());
+    }
+    catch (const out_of_range&) {
+        description = "unknown channel";
+    }
+
+    lock_guard<mutex> lock(rx_mut);
+    if (rx) {
+        const auto label = rx->getEnsembleLabel().utf8_label();
+        if (not label.empty()) {
+            description += ": " + label;
+        }
+    }
+    return description;
+}
+
+WebServer::WebServer(int port, const vector<WebRadioInterface*>& receivers) :
+    receivers(receivers)
+{
+    bool success = serverSocket.bind(port);
+    if (success) {
+        success = serverSocket.listen();
+    }
+
+    if (not success) {
+        throw runtime_error("Could not initialise WebServer");
+    }
+}
+
+bool WebServer::dispatch_client(Socket&& client)
+{
+    Socket s(move(client));
+
+    if (not s.valid()) {
+        cerr << "socket in dispatcher not valid!" << endl;
+        return false;
+    }
+
+    auto req = parse_http_headers(s);
+
+    if (not req.valid) {
+        return false;
+    }
+
+    for (auto wri : receivers) {
+        const auto& prefix = wri->get_url_prefix();
+
+        if (prefix.empty()) {
+            return wri->dispatch_request(s, req);
+        }
+        else if (req.url == prefix) {
+            // The page uses relative URLs, it must be loaded from prefix/
+            string response = http_301;
+            response += "Location: " + prefix + "/\r\n";
+            response += http_contenttype_text;
+            response += "\r\n";
+            return s.send(response.data(), response.size(), MSG_NOSIGNAL) != -1;
+        }
+        else if (req.url.compare(0, prefix.size() + 1, prefix + "/") == 0) {
+            req.url = req.url.substr(prefix.size());
+            return wri->dispatch_request(s, req);
+        }
+    }
+
+    if (req.is_get and req.url == "/") {
+        return send_receiver_list(s);
+    }
+
+    send_http_response(s, http_404, "Could not understand request.\r\n");
+    return false;
+}
+
+bool WebServer::send_receiver_list(Socket& s)
+{
+    stringstream html;
+    html << "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\">" <<
+        "<title>welle-cli</title></head><body><h1>welle-cli</h1><ul>\n";
+    for (const auto wri : receivers) {
+        const auto prefix = html_escape(wri->get_url_prefix());
+        html << "<li><a href=\"" << prefix << "/\">" <<
+            prefix << "</a> " << html_escape(wri->get_description()) <<
+            "</li>\n";
+    }
+    html << "</ul></body></html>\n";
+
+    return send_http_response(s, http_ok, html.str(), http_contenttype_html);
+}
+
+void WebServer::serve()
 {
     deque<future<bool> > running_connections;
 
@@ -1423,7 +1888,7 @@ void WebRadioInterface::serve()
         auto client = serverSocket.accept();
 
         running_connections.push_back(async(launch::async,
-                    &WebRadioInterface::dispatch_client, this, move(client)));
+                    &WebServer::dispatch_client, this, move(client)));
 
         deque<future<bool> > still_running_connections;
         for (auto& fut : running_connections) {
@@ -1444,9 +1909,8 @@ void WebRadioInterface::serve()
 
     cerr << "SERVE No more connections running" << endl;
 
-    running = false;
-    if (programme_handler_thread.joinable()) {
-        programme_handler_thread.join();
+    for (auto wri : receivers) {
+        wri->stop();
     }
 
     cerr << "SERVE Wait for all futures to clear" << endl;
@@ -1469,10 +1933,9 @@ void WebRadioInterface::serve()
     }
 
     cerr << "SERVE clear remaining data structures" << endl;
-    phs.clear();
-    programmes_being_decoded.clear();
-    carousel_services_available.clear();
-    carousel_services_active.clear();
+    for (auto wri : receivers) {
+        wri->clear_programme_handlers();
+    }
 }
 
 void WebRadioInterface::onSNR(float snr)
@@ -1494,9 +1957,20 @@ void WebRadioInterface::onSyncChange(char isSync)
 }
 
 void WebRadioInterface::onSignalPresence(bool /*isSignal*/) { }
-void WebRadioInterface::onServiceDetected(uint32_t /*sId*/) { }
-void WebRadioInterface::onNewEnsemble(uint16_t /*eId*/) { }
-void WebRadioInterface::onSetEnsembleLabel(DabLabel& /*label*/) { }
+void WebRadioInterface::onServiceDetected(uint32_t /*sId*/)
+{
+    mux_json_version++;
+}
+
+void WebRadioInterface::onNewEnsemble(uint16_t /*eId*/)
+{
+    mux_json_version++;
+}
+
+void WebRadioInterface::onSetEnsembleLabel(DabLabel& /*label*/)
+{
+    mux_json_version++;
+}
 
 void WebRadioInterface::onDateTimeUpdate(const dab_date_time_t& dateTime)
 {
@@ -1512,28 +1986,27 @@ void WebRadioInterface::onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib)
         return;
     }
 
-    // Convert the fib bitvector to bytes
-    vector<uint8_t> buf(32);
-    for (size_t i = 0; i < buf.size(); i++) {
-        uint8_t v = 0;
-        for (int j = 0; j < 8; j++) {
-            if (fib[8*i+j]) {
-                v |= 1 << (7-j);
-            }
-        }
-        buf[i] = v;
-    }
-
     {
         lock_guard<mutex> lock(fib_mut);
-        fib_blocks.push_back(move(buf));
 
-        if (fib_blocks.size() > 3*250) { // six seconds
-            fib_blocks.pop_front();
+        // Convert the fib bitvector to bytes, directly into the ring. The
+        // oldest FIB gets overwritten, clients that did not read it
+        // in time will skip it.
+        uint8_t *buf = fib_ring.data() +
+            (fib_ring_head % FIB_RING_LENGTH) * FIB_LENGTH;
+        for (size_t i = 0; i < FIB_LENGTH; i++) {
+            uint8_t v = 0;
+            for (int j = 0; j < 8; j++) {
+                if (fib[8*i+j]) {
+                    v |= 1 << (7-j);
+                }
+            }
+            buf[i] = v;
         }
+        fib_ring_head++;
     }
 
-    new_fib_block_available.notify_one();
+    new_fib_block_available.notify_all();
 }
 
 void WebRadioInterface::onNewImpulseResponse(vector<float>&& data)
@@ -1542,12 +2015,6 @@ void WebRadioInterface::onNewImpulseResponse(vector<float>&& data)
     last_CIR = move(data);
 }
 
-void WebRadioInterface::onNewNullSymbol(vector<DSPCOMPLEX>&& data)
-{
-    lock_guard<mutex> lock(plotdata_mut);
-    last_NULL = move(data);
-}
-
 void WebRadioInterface::onConstellationPoints(vector<DSPCOMPLEX>&& data)
 {
     lock_guard<mutex> lock(plotdata_mut);
@@ -1588,6 +2055,13 @@ void WebRadioInterface::onInputFailure()
     exit(1);
 }
 
+void WebRadioInterface::onRestartService()
+{
+    // Called with the FIC database locked, the decoders are restarted
+    // by the programme handler thread.
+    restart_decoders = true;
+}
+
 list<tii_measurement_t> WebRadioInterface::getTiiStats()
 {
     list<tii_measurement_t> l;
@@ -40,7 +40,7 @@
 #include <cstddef>
 #include "backend/dab-constants.h"
 #include "backend/radio-controller.h"
-#include "various/fft.h"
+#include "backend/spectrum-engine.h"
 #include "various/Socket.h"
 #include "various/channels.h"
 #include "webprogrammehandler.h"
@@ -48,6 +48,7 @@
 
 class CVirtualInput; // from input/virtual_input.h
 class RadioReceiver; // from backend/radio_receiver.h
+struct http_request_t;
 
 class WebRadioInterface : public RadioControllerInterface {
     public:
@@ -70,18 +71,37 @@ class WebRadioInterface : public RadioControllerInterface {
             DecodeStrategy strategy = DecodeStrategy::OnDemand;
             int num_decoders_in_carousel = 0;
             OutputCodec outputCodec;
+
+            /* Number of frames per second pushed to the /plots WebSocket */
+            int plot_frames_per_second = 4;
         };
 
+        /* url_prefix is the path under which this receiver is reachable
+         * on the WebServer, e.g. "/10B". It is empty when the receiver
+         * is the only one. */
         WebRadioInterface(
                 CVirtualInput& in,
-                int port,
+                const std::string& url_prefix,
                 DecodeSettings cs,
                 RadioReceiverOptions rro);
         virtual ~WebRadioInterface();
         WebRadioInterface(const WebRadioInterface&) = delete;
         WebRadioInterface& operator=(const WebRadioInterface&) = delete;
 
-        void serve();
+        const std::string& get_url_prefix() const { return url_prefix; }
+
+        // Handle a request, the URL prefix has already been removed
+        bool dispatch_request(Socket& s, const http_request_t& req);
+
+        // Stop the decoders and the WebSocket streams, called by the
+        // WebServer once it stopped accepting connections.
+        void stop();
+
+        // Release the programme handlers, once all connections are closed.
+        void clear_programme_handlers();
+
+        // A short description for the receiver list of the WebServer
+        std::string get_description();
 
         virtual void onSNR(float snr) override;
         virtual void onFrequencyCorrectorChange(int fine, int coarse) override;
@@ -93,25 +113,42 @@ class WebRadioInterface : public RadioControllerInterface {
         virtual void onDateTimeUpdate(const dab_date_time_t& dateTime) override;
         virtual void onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib) override;
         virtual void onNewImpulseResponse(std::vector<float>&& data) override;
-        virtual void onNewNullSymbol(std::vector<DSPCOMPLEX>&& data) override;
+        virtual void onNewNullSymbol(std::vector<DSPCOMPLEX>&& data) override { (void)data; }
         virtual void onConstellationPoints(std::vector<DSPCOMPLEX>&& data) override;
         virtual void onMessage(message_level_t level, const std::string& text, const std::string& text2 = std::string()) override;
         virtual void onTIIMeasurement(tii_measurement_t&& m) override;
         virtual void onInputFailure() override;
+        virtual void onRestartService() override;
 
     private:
         std::mutex retune_mut;
         void retune(const std::string& channel);
 
-        bool dispatch_client(Socket&& client);
         // Send a file
         bool send_file(Socket& s,
                 const unsigned char *file,
                 const unsigned int file_length,
                 const std::string& content_type);
 
-        // Generate and send the mux.json
-        bool send_mux_json(Socket& s);
+        // Send the mux.json from the cache. Replies 304 Not Modified when
+        // if_none_match contains the current ETag.
+        bool send_mux_json(Socket& s, const std::string& if_none_match,
+                bool accept_gzip);
+
+        // Generate the mux.json document
+        std::string build_mux_json_document();
+
+        struct MuxJsonCache {
+            std::string json;
+            std::string json_gzip; // empty when built without zlib
+            std::string etag;
+            std::chrono::time_point<std::chrono::steady_clock> time_built;
+            uint64_t version = 0;
+        };
+
+        // Returns the cached mux.json, rebuilt only if mux_json_version
+        // changed or if the cached document is getting old.
+        std::shared_ptr<const MuxJsonCache> get_mux_json();
 
         // Generate and send a m3u playlist with all services
         bool send_mux_playlist(Socket& s);
@@ -138,12 +175,21 @@ class WebRadioInterface : public RadioControllerInterface {
         bool send_spectrum(Socket& s);
         bool send_null_spectrum(Socket& s);
 
+        // Spectrum in dB computed by the receiver, can be empty.
+        std::vector<float> get_spectrum(SpectrumEngine::Source source,
+                std::chrono::milliseconds maxWait =
+                    std::chrono::milliseconds(0));
+
         // Send the constellation points, a sequence of phases between -180 and 180 .
         bool send_constellation(Socket& s);
 
         // Send the currently tuned channel
         bool send_channel(Socket& s);
 
+        // Upgrade the connection to a WebSocket and push the plot frames
+        // built by handle_plots() until the client goes away.
+        bool send_plot_stream(Socket& s, const std::string& ws_key);
+
         // Handle a POSTs
         bool handle_fft_window_placement_post(Socket& s, const std::string& request);
         bool handle_coarse_corrector_post(Socket& s, const std::string& request);
@@ -152,6 +198,11 @@ class WebRadioInterface : public RadioControllerInterface {
         bool handle_channel_post(Socket& s, const std::string& request);
 
         void handle_phs();
+
+        // Build a plot frame at most plot_frames_per_second times per
+        // second, but only while at least one WebSocket client is connected.
+        void handle_plots();
+        std::vector<uint8_t> build_plot_frame();
         void check_decoders_required();
         std::list<tii_measurement_t> getTiiStats();
 
@@ -159,9 +210,9 @@ class WebRadioInterface : public RadioControllerInterface {
         std::atomic<bool> running = ATOMIC_VAR_INIT(true);
 
         Channels channels;
+        std::string url_prefix;
         DABParams dabparams;
         CVirtualInput& input;
-        fft::Forward spectrum_fft_handler;
 
         RadioReceiverOptions rro;
         DecodeSettings decode_settings;
@@ -183,21 +234,37 @@ class WebRadioInterface : public RadioControllerInterface {
 
         mutable std::mutex plotdata_mut;
         std::vector<float> last_CIR;
-        std::vector<DSPCOMPLEX> last_NULL;
         std::vector<DSPCOMPLEX> last_constellation;
 
+        // The plot frame is computed once and shared by all WebSocket clients
+        std::thread plot_thread;
+        std::atomic<bool> plots_running = ATOMIC_VAR_INIT(true);
+        std::atomic<int> num_plot_subscribers = ATOMIC_VAR_INIT(0);
+        mutable std::mutex plot_frame_mut;
+        std::condition_variable plot_frame_available;
+        uint64_t plot_frame_seq = 0;
+        std::shared_ptr<const std::vector<uint8_t> > last_plot_frame;
+
         mutable std::mutex fib_mut;
         size_t num_fic_crc_errors = 0;
         std::condition_variable new_fib_block_available;
-        std::deque<std::vector<uint8_t> > fib_blocks;
+        // Broadcast ring holding the most recent FIBs. Every /fic client
+        // keeps its own cursor into it, fib_ring_head counts all FIBs
+        // ever written.
+        std::vector<uint8_t> fib_ring;
+        uint64_t fib_ring_head = 0;
+
+        // Incremented every time the ensemble or the receiver settings
+        // shown in mux.json change
+        std::atomic<uint64_t> mux_json_version{1};
+        std::mutex mux_json_mut;
+        std::shared_ptr<const MuxJsonCache> mux_json_cache;
 
         using comb_pattern_t = std::pair<int, int>;
 
         std::chrono::time_point<std::chrono::steady_clock> time_last_tiis_clean;
         std::map<comb_pattern_t, std::list<tii_measurement_t> > tiis;
 
-        Socket serverSocket;
-
         mutable std::mutex rx_mut;
         std::chrono::time_point<std::chrono::system_clock> time_rx_created;
         std::unique_ptr<RadioReceiver> rx;
@@ -205,6 +272,9 @@ class WebRadioInterface : public RadioControllerInterface {
         using SId_t = uint32_t;
         std::map<SId_t, WebProgrammeHandler> phs;
         std::map<SId_t, bool> programmes_being_decoded;
+        // Set from the FIC when the decoders have to be started again
+        // with a new configuration, handled in check_decoders_required
+        std::atomic<bool> restart_decoders = ATOMIC_VAR_INIT(false);
         std::condition_variable phs_changed;
 
         std::list<SId_t> carousel_services_available;
@@ -217,3 +287,25 @@ class WebRadioInterface : public RadioControllerInterface {
         };
         std::list<ActiveCarouselService> carousel_services_active;
 };
+
+/* The HTTP server. A single WebServer is shared by all WebRadioInterfaces
+ * of the process, and hands every request to the receiver whose URL
+ * prefix matches. */
+class WebServer {
+    public:
+        WebServer(int port, const std::vector<WebRadioInterface*>& receivers);
+        WebServer(const WebServer&) = delete;
+        WebServer& operator=(const WebServer&) = delete;
+
+        // Accept connections until SIGINT, then stop all receivers
+        void serve();
+
+    private:
+        bool dispatch_client(Socket&& client);
+
+        // List the receivers, when several share this server
+        bool send_receiver_list(Socket& s);
+
+        Socket serverSocket;
+        std::vector<WebRadioInterface*> receivers;
+};
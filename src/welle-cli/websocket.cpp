@@ -0,0 +1,198 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "welle-cli/websocket.h"
+#include <array>
+#include <vector>
+#include <iostream>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using namespace std;
+
+namespace websocket {
+
+static const char *ws_guid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+static inline uint32_t rol(uint32_t value, int bits)
+{
+    return (value << bits) | (value >> (32 - bits));
+}
+
+// SHA-1 is only used for the handshake, where speed does not matter.
+static array<uint8_t, 20> sha1(const string& message)
+{
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+    vector<uint8_t> msg(message.begin(), message.end());
+    const uint64_t bit_len = (uint64_t)msg.size() * 8;
+    msg.push_back(0x80);
+    while (msg.size() % 64 != 56) {
+        msg.push_back(0);
+    }
+    for (int i = 7; i >= 0; i--) {
+        msg.push_back((bit_len >> (8 * i)) & 0xFF);
+    }
+
+    for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (msg[chunk + 4*i] << 24) | (msg[chunk + 4*i + 1] << 16) |
+                   (msg[chunk + 4*i + 2] << 8) | (msg[chunk + 4*i + 3]);
+        }
+        for (int i = 16; i < 80; i++) {
+            w[i] = rol(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            const uint32_t temp = rol(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+
+    array<uint8_t, 20> digest;
+    for (int i = 0; i < 5; i++) {
+        digest[4*i]     = (h[i] >> 24) & 0xFF;
+        digest[4*i + 1] = (h[i] >> 16) & 0xFF;
+        digest[4*i + 2] = (h[i] >> 8) & 0xFF;
+        digest[4*i + 3] = h[i] & 0xFF;
+    }
+    return digest;
+}
+
+static string base64(const uint8_t *data, size_t len)
+{
+    static const char *alphabet =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    string out;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = data[i] << 16;
+        if (i + 1 < len) v |= data[i + 1] << 8;
+        if (i + 2 < len) v |= data[i + 2];
+
+        out += alphabet[(v >> 18) & 0x3F];
+        out += alphabet[(v >> 12) & 0x3F];
+        out += (i + 1 < len) ? alphabet[(v >> 6) & 0x3F] : '=';
+        out += (i + 2 < len) ? alphabet[v & 0x3F] : '=';
+    }
+    return out;
+}
+
+string accept_key(const string& client_key)
+{
+    const auto digest = sha1(client_key + ws_guid);
+    return base64(digest.data(), digest.size());
+}
+
+bool send_handshake(Socket& s, const string& client_key)
+{
+    string response = "HTTP/1.1 101 Switching Protocols\r\n";
+    response += "Upgrade: websocket\r\n";
+    response += "Connection: Upgrade\r\n";
+    response += "Sec-WebSocket-Accept: " + accept_key(client_key) + "\r\n";
+    response += "\r\n";
+
+    ssize_t ret = s.send(response.data(), response.size(), MSG_NOSIGNAL);
+    if (ret == -1) {
+        cerr << "Failed to send WebSocket handshake" << endl;
+    }
+    return ret != -1;
+}
+
+static bool send_frame(Socket& s, uint8_t opcode, const uint8_t *data, size_t len)
+{
+    // Server to client frames are never masked
+    uint8_t header[10];
+    size_t header_len = 0;
+
+    header[header_len++] = 0x80 | opcode; // FIN
+    if (len < 126) {
+        header[header_len++] = len;
+    }
+    else if (len < 65536) {
+        header[header_len++] = 126;
+        header[header_len++] = (len >> 8) & 0xFF;
+        header[header_len++] = len & 0xFF;
+    }
+    else {
+        header[header_len++] = 127;
+        for (int i = 7; i >= 0; i--) {
+            header[header_len++] = ((uint64_t)len >> (8 * i)) & 0xFF;
+        }
+    }
+
+    if (s.send(header, header_len, MSG_NOSIGNAL) != (ssize_t)header_len) {
+        return false;
+    }
+
+    size_t sent = 0;
+    while (sent < len) {
+        ssize_t ret = s.send(data + sent, len - sent, MSG_NOSIGNAL);
+        if (ret <= 0) {
+            return false;
+        }
+        sent += ret;
+    }
+    return true;
+}
+
+bool send_binary(Socket& s, const uint8_t *data, size_t len)
+{
+    return send_frame(s, 0x2, data, len);
+}
+
+bool send_ping(Socket& s)
+{
+    return send_frame(s, 0x9, nullptr, 0);
+}
+
+} // namespace websocket
@@ -0,0 +1,49 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "various/Socket.h"
+
+/* Minimal server side of RFC 6455, just enough to push binary
+ * messages to a browser. Messages sent by the client are never read,
+ * a dead client is detected when a send fails. */
+namespace websocket {
+
+// Compute the Sec-WebSocket-Accept value for the client's Sec-WebSocket-Key
+std::string accept_key(const std::string& client_key);
+
+// Send the 101 Switching Protocols response
+bool send_handshake(Socket& s, const std::string& client_key);
+
+// Send one unfragmented binary message
+bool send_binary(Socket& s, const uint8_t *data, size_t len);
+
+// Send an empty ping, used to detect clients that went away
+bool send_ping(Socket& s);
+
+} // namespace websocket
@@ -31,6 +31,7 @@
  */
 
 #include <algorithm>
+#include <cctype>
 #include <condition_variable>
 #include <deque>
 #include <iostream>
@@ -49,8 +50,10 @@
 #  include "welle-cli/alsa-output.h"
 #endif
 #include "welle-cli/webradiointerface.h"
+#include "welle-cli/scanner.h"
 #include "welle-cli/tests.h"
 #include "backend/radio-receiver.h"
+#include "input/channeliser.h"
 #include "input/input_factory.h"
 #include "input/raw_file.h"
 #include "various/channels.h"
@@ -272,12 +275,22 @@ class RadioInterface : public RadioControllerInterface {
         FILE* fic_fd = nullptr;
 };
 
+/* One of several receivers sharing the web server, given with -m */
+struct receiver_options_t {
+    string name;
+    string channel;
+    string frontend = "auto";
+    string frontend_args = "";
+    string iqsource = "";
+};
+
 struct options_t {
     string soapySDRDriverArgs = "";
     string antenna = "";
     int gain = -1;
     string channel = "10B";
     string iqsource = "";
+    int start_frame = 0;
     string programme = "GRRIF";
     string frontend = "auto";
     string frontend_args = "";
@@ -286,8 +299,15 @@ struct options_t {
     int num_decoders_in_carousel = 0;
     bool carousel_pad = false;
     int web_port = -1; // positive value means enable
+    int plot_frames_per_second = 4;
+    list<receiver_options_t> receivers;
+    int wideband_rate = 0;
+    bool scan = false;
     list<int> tests;
     string outputcodec = "";
+    string record_file = "";
+    uint64_t record_max_size = 0;
+    int record_max_duration = 0;
 
     RadioReceiverOptions rro;
 };
@@ -305,6 +325,9 @@ static void usage()
     "Tuning:" << endl <<
     "    -c channel    Tune to <channel> (eg. 10B, 5A, LD...)." << endl <<
     "    -p programme  Play <programme> with ALSA (text name of the radio: eg. GRIFF)." << endl <<
+    "    -S            Scan all channels and print the ensembles found. With -W," << endl <<
+    "                  several channels are looked at with each tuning of the" << endl <<
+    "                  device, and the occupied ones are decoded together." << endl <<
     endl <<
     "Dumping:" << endl <<
     "    -D            Dump FIC and all programmes to files (cannot be used with -C)." << endl <<
@@ -323,10 +346,27 @@ static void usage()
     "                  With the -P option, welle-cli will switch once DLS and a" << endl <<
     "                  slide were decoded, staying at most 80 seconds on a given" << endl <<
     "                  programme." << endl <<
+    "    -R rate       Number of plot frames per second sent to the /plots" << endl <<
+    "                  WebSocket, 1 to 1000 (default 4)." << endl <<
+    "    -m name=channel@input" << endl <<
+    "                  Add a receiver, reachable under http://host:port/<name>/." << endl <<
+    "                  <name> must be unique and must not contain '/', '?'," << endl <<
+    "                  '#', '%' or whitespace." << endl <<
+    "                  Can be given several times, all receivers share the" << endl <<
+    "                  same web server. <input> is a driver as for -F, or" << endl <<
+    "                  file:<path> to read an IQ file, or wideband to cut the" << endl <<
+    "                  channel out of the stream of the -F device (see -W)." << endl <<
+    "                  -c and -f are ignored when -m is used." << endl <<
+    "    -W rate       Sample rate of the device given with -F, used for the" << endl <<
+    "                  'wideband' receivers of -m and for -S. Must be a multiple" << endl <<
+    "                  of 2048000, e.g. 8192000. Only supported with soapysdr." << endl <<
     endl <<
     "Backend and input options:" << endl <<
     "    -f file       Read an IQ file <file> and play with ALSA." << endl <<
     "                  IQ file format is u8, unless the file ends with 'FORMAT.iq'." << endl <<
+    "                  Files ending with '.wiq' are compressed recordings." << endl <<
+    "    -j frame      Start reading the IQ file given with -f at transmission" << endl <<
+    "                  frame <frame> (96ms each) instead of at its beginning." << endl <<
     "    -u            Disable coarse corrector, for receivers who have a low " << endl <<
     "                  frequency offset." << endl <<
     "    -g gain       Set input gain to <gain> or -1 for auto gain." << endl <<
@@ -336,10 +376,28 @@ static void usage()
     "                  Possible values are: auto (default), airspy, rtl_sdr," << endl <<
     "                  android_rtl_sdr, rtl_tcp, soapysdr." << endl <<
     "                  With \"rtl_tcp\", host IP and port can be specified as " << endl <<
-    "                  \"rtl_tcp,<HOST_IP>:<PORT>\"." << endl <<
+    "                  \"rtl_tcp,<HOST_IP>:<PORT>\", optionally followed by the" << endl <<
+    "                  socket receive buffer size in kB \":<SIZE>\" (default 1024)." << endl <<
     "    -s args       SoapySDR Driver arguments." << endl <<
     "    -A antenna    Set input antenna to ANT (for SoapySDR input only)." << endl <<
     "    -T            Disable TII decoding to reduce CPU usage." << endl <<
+    "    -L            Weight the soft bits by the SNR of each carrier, improves" << endl <<
+    "                  decoding on channels with deep fades." << endl <<
+    "    -K dir        Keep the configuration of every ensemble received in the" << endl <<
+    "                  existing directory <dir>, and use it to start decoding" << endl <<
+    "                  right after tuning, before the FIC is received." << endl <<
+    "    -o file[,MB[,min]]" << endl <<
+    "                  Record the u8 IQ samples to <file> while receiving," << endl <<
+    "                  starting a new file every <MB> megabytes or <min> minutes." << endl <<
+    "                  Files ending with '.wiq' are compressed, '.q4.wiq' with" << endl <<
+    "                  loss. Works with rtl_sdr, rtl_tcp and u8 or .wiq IQ" << endl <<
+    "                  files, but not together with -m." << endl <<
+    "    -e prefix[,pre[,post]]" << endl <<
+    "                  Keep the last <pre> seconds (default 5) of IQ samples in" << endl <<
+    "                  memory, and save them together with the following <post>" << endl <<
+    "                  seconds (default 2) to a file starting with <prefix> on" << endl <<
+    "                  FIC CRC error bursts, uncorrectable Reed-Solomon errors" << endl <<
+    "                  and sync loss." << endl <<
     "    -O            Output Codec for web streaming : mp3 (default), flac (lossless)" << endl <<
     endl <<
     "Other options:" << endl <<
@@ -377,6 +435,18 @@ static void usage()
     "    Enable web server on port 8000, decode programmes one by one in a carousel" << endl <<
     "    on channel 10B; welle-cli will switch every 10 seconds." << endl <<
     endl <<
+    "welle-cli -w 8000 -m 10B=10B@rtl_tcp,localhost:1234 -m 12C=12C@rtl_tcp,localhost:1235" << endl <<
+    "    Enable web server on port 8000, receive channel 10B from the first rtl_tcp" << endl <<
+    "    server on http://localhost:8000/10B/ and channel 12C from the second one on" << endl <<
+    "    http://localhost:8000/12C/." << endl <<
+    endl <<
+    "welle-cli -w 8000 -F soapysdr -W 8192000 -m 12A=12A@wideband -m 12B=12B@wideband -m 12C=12C@wideband" << endl <<
+    "    Enable web server on port 8000, capture 8.192MHz around channels 12A to 12C" << endl <<
+    "    with one SoapySDR device, and decode the three ensembles." << endl <<
+    endl <<
+    "welle-cli -S -F soapysdr -W 8192000" << endl <<
+    "    Scan all channels, looking at four channels at once with one SoapySDR device." << endl <<
+    endl <<
     "welle-cli -c 10B -PC 1 -w 8000" << endl <<
     "    Enable web server on port 8000, decode programmes one by one in a carousel" << endl <<
     "    on channel 10B; welle-cli will switch once DLS and a slide were decoded," << endl <<
@@ -409,7 +479,7 @@ options_t parse_cmdline(int argc, char **argv)
     options.rro.decodeTII = true;
 
     int opt;
-    while ((opt = getopt(argc, argv, "A:c:C:dDf:F:g:hp:O:Ps:Tt:uvw:")) != -1) {
+    while ((opt = getopt(argc, argv, "A:c:C:dDe:f:F:g:hj:K:Lm:o:p:O:PR:s:STt:uvw:W:")) != -1) {
         switch (opt) {
             case 'A':
                 options.antenna = optarg;
@@ -426,6 +496,23 @@ options_t parse_cmdline(int argc, char **argv)
             case 'D':
                 options.decode_all_programmes = true;
                 break;
+            case 'e':
+                {
+                    auto& capture = options.rro.iqCapture;
+                    string arg = optarg;
+                    size_t comma = arg.find(',');
+                    capture.enabled = true;
+                    capture.fileNamePrefix = arg.substr(0, comma);
+                    if (comma != string::npos) {
+                        string durations = arg.substr(comma + 1);
+                        size_t comma2 = durations.find(',');
+                        capture.preTriggerSeconds = std::atoi(durations.substr(0, comma2).c_str());
+                        if (comma2 != string::npos) {
+                            capture.postTriggerSeconds = std::atoi(durations.substr(comma2 + 1).c_str());
+                        }
+                    }
+                }
+                break;
             case 'f':
                 options.iqsource = optarg;
                 break;
@@ -435,27 +522,120 @@ options_t parse_cmdline(int argc, char **argv)
             case 'g':
                 options.gain = std::atoi(optarg);
                 break;
+            case 'j':
+                options.start_frame = std::atoi(optarg);
+                if (options.start_frame < 0) {
+                    cerr << "The start frame must not be negative" << endl;
+                    exit(1);
+                }
+                break;
+            case 'm':
+                {
+                    const string spec = optarg;
+                    const size_t eq = spec.find('=');
+                    const size_t at = spec.find('@', eq);
+                    if (eq == string::npos or at == string::npos) {
+                        cerr << "Cannot parse receiver '" << spec <<
+                            "', expected name=channel@input" << endl;
+                        exit(1);
+                    }
+                    if (eq == 0) {
+                        cerr << "Receiver '" << spec << "' needs a name" << endl;
+                        exit(1);
+                    }
+
+                    receiver_options_t r;
+                    r.name = spec.substr(0, eq);
+
+                    // The name is the first component of the URL path
+                    const bool bad_name = std::any_of(r.name.begin(), r.name.end(),
+                            [](unsigned char c) {
+                                return c == '/' or c == '?' or c == '#' or
+                                    c == '%' or isspace(c) or iscntrl(c);
+                            });
+                    if (bad_name) {
+                        cerr << "Receiver name '" << r.name << "' must not " <<
+                            "contain '/', '?', '#', '%' or whitespace" << endl;
+                        exit(1);
+                    }
+                    for (const auto& other : options.receivers) {
+                        if (other.name == r.name) {
+                            cerr << "Receiver name '" << r.name <<
+                                "' given more than once" << endl;
+                            exit(1);
+                        }
+                    }
+
+                    r.channel = spec.substr(eq + 1, at - eq - 1);
+                    const string input = spec.substr(at + 1);
+                    if (input.compare(0, 5, "file:") == 0) {
+                        r.iqsource = input.substr(5);
+                    }
+                    else {
+                        const size_t comma = input.find(',');
+                        r.frontend = input.substr(0, comma);
+                        if (comma != string::npos) {
+                            r.frontend_args = input.substr(comma + 1);
+                        }
+                    }
+                    options.receivers.push_back(r);
+                }
+                break;
             case 'p':
                 options.programme = optarg;
                 break;
+            case 'o':
+                {
+                    string arg = optarg;
+                    size_t comma = arg.find(',');
+                    options.record_file = arg.substr(0, comma);
+                    if (comma != string::npos) {
+                        string limits = arg.substr(comma + 1);
+                        size_t comma2 = limits.find(',');
+                        options.record_max_size = (uint64_t)std::atoll(
+                                limits.substr(0, comma2).c_str()) * 1024 * 1024;
+                        if (comma2 != string::npos) {
+                            options.record_max_duration =
+                                std::atoi(limits.substr(comma2 + 1).c_str()) * 60;
+                        }
+                    }
+                }
+                break;
             case 'O':
                 options.outputcodec = optarg;
                 break;
             case 'P':
                 options.carousel_pad = true;
                 break;
+            case 'R':
+                options.plot_frames_per_second = std::atoi(optarg);
+                if (options.plot_frames_per_second < 1 or
+                        options.plot_frames_per_second > 1000) {
+                    cerr << "The plot rate must be between 1 and 1000" << endl;
+                    exit(1);
+                }
+                break;
             case 'h':
                 usage();
                 exit(1);
             case 's':
                 options.soapySDRDriverArgs = optarg;
                 break;
+            case 'S':
+                options.scan = true;
+                break;
             case 't':
                 options.tests.push_back(std::atoi(optarg));
                 break;
             case 'T':
                 options.rro.decodeTII = false;
                 break;
+            case 'K':
+                options.rro.ensembleCacheDirectory = optarg;
+                break;
+            case 'L':
+                options.rro.csiWeightedDemapper = true;
+                break;
             case 'v':
                 version();
                 cerr << endl;
@@ -464,6 +644,9 @@ options_t parse_cmdline(int argc, char **argv)
             case 'w':
                 options.web_port = std::atoi(optarg);
                 break;
+            case 'W':
+                options.wideband_rate = std::atoi(optarg);
+                break;
             case 'u':
                 options.rro.disableCoarseCorrector = true;
                 break;
@@ -486,27 +669,41 @@ options_t parse_cmdline(int argc, char **argv)
         cerr << "Cannot select both -C and -D" << endl;
         exit(1);
     }
+    if (not options.receivers.empty() and options.web_port == -1) {
+        cerr << "-m can only be used together with -w" << endl;
+        exit(1);
+    }
+    if (options.scan and options.web_port != -1) {
+        cerr << "Cannot select both -S and -w" << endl;
+        exit(1);
+    }
+    if (not options.record_file.empty() and not options.receivers.empty()) {
+        cerr << "Cannot select both -o and -m" << endl;
+        exit(1);
+    }
+    if (not options.record_file.empty() and options.scan and
+            options.wideband_rate != 0) {
+        cerr << "Cannot select -o for a scan with -W" << endl;
+        exit(1);
+    }
 
     return options;
 }
 
-int main(int argc, char **argv)
+static unique_ptr<CVirtualInput> create_input(RadioInterface& ri,
+        const options_t& options,
+        const string& frontend,
+        const string& frontend_args,
+        const string& iqsource)
 {
-    auto options = parse_cmdline(argc, argv);
-    version();
-
-    RadioInterface ri;
-
-    Channels channels;
-
     unique_ptr<CVirtualInput> in = nullptr;
 
-    if (options.iqsource.empty()) {
-        in.reset(CInputFactory::GetDevice(ri, options.frontend));
+    if (iqsource.empty()) {
+        in.reset(CInputFactory::GetDevice(ri, frontend));
 
         if (not in) {
             cerr << "Could not start device" << endl;
-            return 1;
+            return nullptr;
         }
     }
     else {
@@ -516,10 +713,13 @@ int main(int argc, char **argv)
         auto in_file = make_unique<CRAWFile>(ri, throttle, rewind);
         if (not in_file) {
             cerr << "Could not prepare CRAWFile" << endl;
-            return 1;
+            return nullptr;
         }
 
-        in_file->setFileName(options.iqsource, "auto");
+        in_file->setFileName(iqsource, "auto");
+        if (options.start_frame > 0) {
+            in_file->seekToFrame(options.start_frame);
+        }
         in = move(in_file);
     }
 
@@ -541,27 +741,103 @@ int main(int argc, char **argv)
         dynamic_cast<CSoapySdr*>(in.get())->setDeviceParam(DeviceParam::SoapySDRDriverArgs, options.soapySDRDriverArgs);
     }
 #endif
-    if (options.frontend == "rtl_tcp" && !options.frontend_args.empty()) {
-        string args = options.frontend_args;
+    if (frontend == "rtl_tcp" && !frontend_args.empty()) {
+        string args = frontend_args;
         size_t colon = args.find(':');
         if (colon == string::npos) {
             cerr << "I need a colon ':' to parse rtl_tcp options!" << endl;
-            return 1;
+            return nullptr;
         }
         else {
             string host = args.substr(0, colon);
             string port = args.substr(colon + 1);
+            string rcvbuf;
+            size_t colon2 = port.find(':');
+            if (colon2 != string::npos) {
+                rcvbuf = port.substr(colon2 + 1);
+                port = port.substr(0, colon2);
+            }
             if (!host.empty()) {
                 dynamic_cast<CRTL_TCP_Client*>(in.get())->setServerAddress(host);
             }
             if (!port.empty()) {
                 dynamic_cast<CRTL_TCP_Client*>(in.get())->setPort(atoi(port.c_str()));
             }
+            if (!rcvbuf.empty()) {
+                in->setDeviceParam(DeviceParam::RTLTCPReceiveBufferSize,
+                        atoi(rcvbuf.c_str()) * 1024);
+            }
             // cout << "setting rtl_tcp host to '" << host << "', port to '" << atoi(port.c_str()) << "'" << endl;
         }
     }
-    auto freq = channels.getFrequency(options.channel);
-    in->setFrequency(freq);
+
+    return in;
+}
+
+static unique_ptr<CChanneliser> create_channeliser(RadioInterface& ri,
+        const options_t& options)
+{
+    if (options.wideband_rate == 0) {
+        cerr << "wideband receivers need the -W option" << endl;
+        return nullptr;
+    }
+
+    auto wideband = create_input(ri, options, options.frontend,
+            options.frontend_args, "");
+    if (not wideband or not wideband->setDeviceParam(
+                DeviceParam::SoapySDRSampleRate,
+                options.wideband_rate)) {
+        cerr << "Could not set up the device for wideband capture" << endl;
+        return nullptr;
+    }
+
+    try {
+        return make_unique<CChanneliser>(move(wideband), options.wideband_rate);
+    }
+    catch (const invalid_argument& e) {
+        cerr << e.what() << endl;
+        return nullptr;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    auto options = parse_cmdline(argc, argv);
+    version();
+
+    RadioInterface ri;
+
+    Channels channels;
+
+    unique_ptr<CVirtualInput> in = nullptr;
+
+    // A wideband scan opens the device itself
+    const bool wideband_scan = options.scan and options.wideband_rate != 0;
+
+    if (options.receivers.empty() and not wideband_scan) {
+        in = create_input(ri, options, options.frontend,
+                options.frontend_args, options.iqsource);
+        if (not in) {
+            return 1;
+        }
+
+        auto freq = channels.getFrequency(options.channel);
+        in->setFrequency(freq);
+
+        if (not options.record_file.empty()) {
+            if (not in->supportsRecording()) {
+                cerr << "Recording with -o is not supported by input " <<
+                    in->getDescription() << endl;
+                return 1;
+            }
+
+            if (not in->startRecording(options.record_file,
+                        options.record_max_size, options.record_max_duration)) {
+                cerr << "Could not start recording to " << options.record_file << endl;
+                return 1;
+            }
+        }
+    }
     string service_to_tune = options.programme;
 
     if (not options.tests.empty()) {
@@ -570,6 +846,34 @@ int main(int argc, char **argv)
             tests.run_test(test);
         }
     }
+    else if (options.scan) {
+        ChannelScanner scanner(options.rro);
+        vector<ScanResult> results;
+        const auto start = chrono::steady_clock::now();
+
+        if (wideband_scan) {
+            auto channeliser = create_channeliser(ri, options);
+            if (not channeliser) {
+                return 1;
+            }
+            results = scanner.scan(*channeliser);
+        }
+        else {
+            results = scanner.scan(*in);
+        }
+
+        const auto elapsed = chrono::duration_cast<chrono::milliseconds>(
+                chrono::steady_clock::now() - start);
+        cerr << "Scan finished in " << elapsed.count() / 1000.0 << " s" << endl;
+
+        for (const auto& r : results) {
+            if (r.numServices > 0) {
+                cout << r.channel << "\t" << r.frequency << "\t0x" <<
+                    hex << r.eId << dec << "\t" << r.numServices << "\t" <<
+                    r.label << endl;
+            }
+        }
+    }
     else if (options.web_port != -1) {
         using DS = WebRadioInterface::DecodeStrategy;
         WebRadioInterface::DecodeSettings ds;
@@ -585,6 +889,7 @@ int main(int argc, char **argv)
             }
             ds.num_decoders_in_carousel = options.num_decoders_in_carousel;
         }
+        ds.plot_frames_per_second = options.plot_frames_per_second;
         if (options.outputcodec == "" || options.outputcodec == "mp3")
         {
             ds.outputCodec = OutputCodec::MP3;
@@ -605,8 +910,84 @@ int main(int argc, char **argv)
             return 1;
         }
 
-        WebRadioInterface wri(*in, options.web_port, ds, options.rro);
-        wri.serve();
+        // The inputs must outlive the WebRadioInterfaces using them
+        vector<unique_ptr<CVirtualInput> > inputs;
+        unique_ptr<CChanneliser> channeliser;
+        vector<unique_ptr<WebRadioInterface> > wris;
+
+        if (options.receivers.empty()) {
+            wris.push_back(make_unique<WebRadioInterface>(
+                        *in, "", ds, options.rro));
+        }
+        else {
+            vector<int> wideband_frequencies;
+            for (const auto& r : options.receivers) {
+                if (r.iqsource.empty() and r.frontend == "wideband") {
+                    wideband_frequencies.push_back(channels.getFrequency(r.channel));
+                }
+            }
+
+            if (not wideband_frequencies.empty()) {
+                channeliser = create_channeliser(ri, options);
+                if (not channeliser) {
+                    return 1;
+                }
+
+                const auto f = minmax_element(
+                        wideband_frequencies.begin(), wideband_frequencies.end());
+                channeliser->setCentreFrequency((*f.first + *f.second) / 2);
+            }
+
+            // Constructing a WebRadioInterface starts the channeliser, after
+            // which no channel can be added any more.
+            vector<CChannelisedInput*> channelised_inputs;
+            for (const auto& r : options.receivers) {
+                if (r.iqsource.empty() and r.frontend == "wideband") {
+                    try {
+                        channelised_inputs.push_back(&channeliser->addChannel(
+                                    channels.getFrequency(r.channel)));
+                    }
+                    // Also catches the out_of_range for channels outside
+                    // the captured band
+                    catch (const logic_error& e) {
+                        cerr << "Receiver " << r.name << ": " << e.what() << endl;
+                        return 1;
+                    }
+                }
+            }
+
+            auto next_channelised_input = channelised_inputs.begin();
+            for (const auto& r : options.receivers) {
+                if (r.iqsource.empty() and r.frontend == "wideband") {
+                    wris.push_back(make_unique<WebRadioInterface>(
+                                **next_channelised_input, "/" + r.name,
+                                ds, options.rro));
+                    ++next_channelised_input;
+                    continue;
+                }
+
+                auto rin = create_input(ri, options, r.frontend,
+                        r.frontend_args, r.iqsource);
+                if (not rin) {
+                    cerr << "Could not create input for receiver " <<
+                        r.name << endl;
+                    return 1;
+                }
+                rin->setFrequency(channels.getFrequency(r.channel));
+
+                wris.push_back(make_unique<WebRadioInterface>(
+                            *rin, "/" + r.name, ds, options.rro));
+                inputs.push_back(move(rin));
+            }
+        }
+
+        vector<WebRadioInterface*> receivers;
+        for (auto& wri : wris) {
+            receivers.push_back(wri.get());
+        }
+
+        WebServer server(options.web_port, receivers);
+        server.serve();
     }
     else {
         RadioReceiver rx(ri, *in, options.rro);
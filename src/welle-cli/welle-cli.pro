@@ -8,14 +8,18 @@ HEADERS += \
     alsa-output.h  \
     webprogrammehandler.h \
     webradiointerface.h \
-    jsonconvert.h
+    websocket.h \
+    jsonconvert.h \
+    scanner.h
 
 SOURCES += \
     alsa-output.cpp \
     tests.cpp \
     webprogrammehandler.cpp \
     webradiointerface.cpp \
+    websocket.cpp \
     jsonconvert.cpp \
+    scanner.cpp \
     welle-cli.cpp
 
 # Include git hash into build
@@ -45,8 +45,9 @@ ViewBaseFrame {
     Connections{
         target: guiHelper
 
-        function onSetNullSymbolAxis(Ymax, Xmin, Xmax) {
+        function onSetNullSymbolAxis(Ymax, Xmin, Xmax, Ymin) {
             spectrum.yMax = Ymax
+            spectrum.yMin = Ymin
             spectrum.freqMin = Xmin
             spectrum.freqMax = Xmax
         }
@@ -37,9 +37,19 @@ ViewBaseFrame {
 
     property bool isStart: false
     property int ringeBufferSize: 0
+    property bool isStreaming: false
+    property real streamBytesWritten: 0
+    property real streamDroppedBytes: 0
 
     content:  ColumnLayout {
+        TextStandart {
+            visible: !radioController.isRecorderSupported
+            text: qsTr("Recording is not supported by this input device")
+        }
+
         RowLayout {
+            enabled: radioController.isRecorderSupported
+
             TextStandart {
                 text: qsTr("Ring buffer length [s]")
             }
@@ -58,12 +68,13 @@ ViewBaseFrame {
                 text: isStart ? qsTr("Save ring buffer") : qsTr("Init")
 
                 onPressed: {
-                    if(!isStart)
-                        radioController.initRecorder(ringeBufferSize)
-                    else
+                    if(!isStart) {
+                        isStart = radioController.initRecorder(ringeBufferSize)
+                    }
+                    else {
                         radioController.triggerRecorder("")
-
-                    isStart = !isStart
+                        isStart = false
+                    }
                 }
             }
         }
@@ -71,5 +82,59 @@ ViewBaseFrame {
         TextStandart {
             text: qsTr("Ring buffer size (roughly): ") + (ringeBufferSize / 1000000 * 2).toFixed(0) + " MB"
         }
+
+        RowLayout {
+            enabled: radioController.isRecorderSupported
+
+            TextStandart {
+                text: qsTr("New file every [MB]")
+            }
+
+            WTumbler {
+                id: maxFileSizeSetting
+                model: [0, 100, 1000, 4000]
+            }
+
+            TextStandart {
+                text: qsTr("or [min]")
+            }
+
+            WTumbler {
+                id: maxFileDurationSetting
+                model: [0, 10, 60, 240]
+            }
+
+            WButton {
+                text: isStreaming ? qsTr("Stop recording") : qsTr("Record to disk")
+
+                onPressed: {
+                    if(!isStreaming) {
+                        isStreaming = radioController.startStreamRecorder(
+                                    parseInt(maxFileSizeSetting.currentItem.text),
+                                    parseInt(maxFileDurationSetting.currentItem.text))
+                    }
+                    else {
+                        radioController.stopStreamRecorder()
+                        isStreaming = false
+                    }
+                }
+            }
+        }
+
+        TextStandart {
+            visible: isStreaming
+            text: qsTr("Written: ") + (streamBytesWritten / 1000000).toFixed(0) + " MB, " +
+                  qsTr("dropped: ") + (streamDroppedBytes / 1000000).toFixed(1) + " MB"
+        }
+
+        Timer {
+            interval: 1000
+            running: isStreaming
+            repeat: true
+            onTriggered: {
+                streamBytesWritten = radioController.streamRecorderBytesWritten()
+                streamDroppedBytes = radioController.streamRecorderDroppedBytes()
+            }
+        }
     }
 }
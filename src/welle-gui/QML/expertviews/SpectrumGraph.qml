@@ -49,8 +49,9 @@ ViewBaseFrame {
     Connections{
         target: guiHelper
 
-        function onSetSpectrumAxis(Ymax, Xmin, Xmax) {
+        function onSetSpectrumAxis(Ymax, Xmin, Xmax, Ymin) {
             spectrum.yMax = Ymax
+            spectrum.yMin = Ymin
             spectrum.freqMin = Xmin
             spectrum.freqMax = Xmax
         }
@@ -41,6 +41,7 @@ Item {
         property alias enableExpertModeState : enableExpertMode.checked
         property alias disableCoarseState: disableCoarse.checked
         property alias enableDecodeTIIState: enableDecodeTII.checked
+        property alias enableCSIWeightingState: enableCSIWeighting.checked
         property alias freqSyncMethodBoxState: freqSyncMethodBox.currentIndex
         property alias fftWindowPlacement: fftPlacementBox.currentIndex
     }
@@ -92,6 +93,7 @@ Item {
                         ListElement { label: "GetMiddle"; trLabel: qsTr("GetMiddle"); trContext: "ExpertSettings" }
                         ListElement { label: "CorrelatePRS"; trLabel: qsTr("CorrelatePRS"); trContext: "ExpertSettings" }
                         ListElement { label: "PatternOfZeros"; trLabel: qsTr("PatternOfZeros"); trContext: "ExpertSettings" }
+                        ListElement { label: "CorrelateSpectrum"; trLabel: qsTr("CorrelateSpectrum"); trContext: "ExpertSettings" }
                     }
                     sizeToContents: true
                     currentIndex: 1
@@ -120,6 +122,18 @@ Item {
                 Component.onCompleted: radioController.enableTIIDecode(checked)
             }
 
+            WSwitch {
+                id: enableCSIWeighting
+                Layout.fillWidth: true
+                text: qsTr("Weight soft bits by the SNR of each carrier")
+                checked: false
+                onCheckedChanged: {
+                    radioController.enableCSIWeighting(checked)
+                }
+
+                Component.onCompleted: radioController.enableCSIWeighting(checked)
+            }
+
             RowLayout {
                 Layout.fillWidth: true
                 WComboBoxList {
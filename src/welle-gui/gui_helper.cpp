@@ -328,217 +328,93 @@ void CGUIHelper::tryHideWindow()
 #endif
 }
 
+// Width in pixels of the plot area of the chart showing the series, or 0
+// if the series is not shown in a chart, e.g. for the waterfall.
+static int plotWidth(QXYSeries *series)
+{
+    if (series && series->chart())
+        return series->chart()->plotArea().width();
+    else
+        return 0;
+}
+
 // This function is called by the QML GUI
 void CGUIHelper::updateSpectrum()
 {
-    std::vector<DSPCOMPLEX> signalProbeBuffer;
-    int T_u = radioController->getParams().T_u;
-
-    qreal y = 0;
-    qreal x = 0;
-    qreal y_max = 0;
-    qreal x_min = 0;
-    qreal x_max = 0;
-
-    qreal tunedFrequency_MHz = 0;
-    qreal CurrentFrequency = radioController->getCurrentFrequency();
-    qreal sampleFrequency_MHz = INPUT_RATE / 1e6;
-    qreal dip_MHz = sampleFrequency_MHz / T_u;
-
-    signalProbeBuffer = radioController->getSignalProbe();
-
-    if (signalProbeBuffer.size() == (size_t)T_u) {
-        spectrumSeriesData.resize(T_u);
-
-        fft::Forward FFT(T_u);
-        DSPCOMPLEX* spectrumBuffer = FFT.getVector();
-
-        std::copy(signalProbeBuffer.begin(), signalProbeBuffer.begin() + T_u,
-                spectrumBuffer);
-
-        // Do FFT to get the spectrum
-        FFT.do_FFT();
-
-        tunedFrequency_MHz = CurrentFrequency / 1e6;
-
-        // Process samples one by one
-        for (int i = 0; i < T_u; i++) {
-            int half_Tu = T_u / 2;
+    // The spectrum is averaged by the receiver
+    auto spectrum = radioController->getSpectrum(SpectrumEngine::Source::Signal);
 
-            // Shift FFT samples
-            if (i < half_Tu)
-                y = abs(spectrumBuffer[i + half_Tu]);
-            else
-                y = abs(spectrumBuffer[i - half_Tu]);
-
-            // Apply a cumulative moving average filter
-            int avg = 4; // Number of y values to average
-            qreal CMA = spectrumSeriesData[i].y();
-            y = (CMA * avg + y) / (avg + 1);
-
-            // Find maximum value to scale the plotter
-            if (y > y_max)
-                y_max = y;
-
-            // Calc x frequency
-            x = (i * dip_MHz) + (tunedFrequency_MHz - (sampleFrequency_MHz / 2));
-
-            spectrumSeriesData[i]= QPointF(x, y);
-        }
-
-        x_min = tunedFrequency_MHz - (sampleFrequency_MHz / 2);
-        x_max = tunedFrequency_MHz + (sampleFrequency_MHz / 2);
+    if (not spectrum.empty()) {
+        plotWorker.submitSpectrum(PlotTypeEn::Spectrum, std::move(spectrum),
+                radioController->getCurrentFrequency() / 1e6, plotWidth(spectrumSeries));
+    }
 
-        emit setSpectrumAxis(y_max, x_min, x_max);
+    if (plotWorker.take(PlotTypeEn::Spectrum, spectrumPlot)) {
+        emit setSpectrumAxis(spectrumPlot.y_max, spectrumPlot.x_min, spectrumPlot.x_max, spectrumPlot.y_min);
 
         if(spectrumSeries)
-            spectrumSeries->replace(spectrumSeriesData);
+            spectrumSeries->replace(spectrumPlot.points);
     }
 }
 
 void CGUIHelper::updateImpulseResponse()
 {
-    std::vector<float> impulseResponseBuffer;
     int T_u = radioController->getParams().T_u;
 
-    qreal y_max = 0;
-    qreal x_min = 0;
-    qreal x_max = 0;
-
-    impulseResponseBuffer = radioController->getImpulseResponse();
+    auto impulseResponseBuffer = radioController->getImpulseResponse();
 
     if (impulseResponseBuffer.size() == (size_t)T_u) {
-        impulseResponseSeriesData.resize(T_u);
-        for (int i = 0; i < T_u; i++) {
-            qreal y = 10.0f * std::log10(impulseResponseBuffer[i]);
-            qreal x = i;
-
-            // Find maximum value to scale the plotter
-            if (y > y_max)
-                y_max = y;
-            impulseResponseSeriesData[i] = QPointF(x, y);
-        }
-
-        x_min = 0;
-        x_max = T_u;
+        plotWorker.submitImpulseResponse(std::move(impulseResponseBuffer),
+                plotWidth(impulseResponseSeries));
+    }
 
-        emit setImpulseResponseAxis(y_max, x_min, x_max);
+    if (plotWorker.take(PlotTypeEn::ImpulseResponse, impulseResponsePlot)) {
+        emit setImpulseResponseAxis(impulseResponsePlot.y_max, impulseResponsePlot.x_min, impulseResponsePlot.x_max);
 
         if(impulseResponseSeries)
-            impulseResponseSeries->replace(impulseResponseSeriesData);
+            impulseResponseSeries->replace(impulseResponsePlot.points);
     }
 }
 
 void CGUIHelper::updateNullSymbol()
 {
-    std::vector<DSPCOMPLEX> nullSymbolBuffer;
-    int T_u = radioController->getParams().T_u;
-    int T_null = radioController->getParams().T_null;
-
-    qreal y = 0;
-    qreal x = 0;
-    qreal y_max = 0;
-    qreal x_min = 0;
-    qreal x_max = 0;
+    auto spectrum = radioController->getSpectrum(SpectrumEngine::Source::NullSymbol);
 
-    qreal tunedFrequency_MHz = 0;
-    qreal CurrentFrequency = radioController->getCurrentFrequency();
-    qreal sampleFrequency_MHz = INPUT_RATE / 1e6;
-    qreal dip_MHz = sampleFrequency_MHz / T_u;
-
-    nullSymbolBuffer = radioController->getNullSymbol();
-
-    if (nullSymbolBuffer.size() == (size_t)T_null) {
-        nullSymbolSeriesData.resize(T_u);
-
-        fft::Forward FFT(T_u);
-        DSPCOMPLEX* spectrumBuffer = FFT.getVector();
-
-        std::copy(nullSymbolBuffer.begin(), nullSymbolBuffer.begin() + T_u,
-                spectrumBuffer);
-
-        // Do FFT to get the spectrum
-        FFT.do_FFT();
-
-        tunedFrequency_MHz = CurrentFrequency / 1e6;
-
-        // Process samples one by one
-        for (int i = 0; i < T_u; i++) {
-            int half_Tu = T_u / 2;
-
-            // Shift FFT samples
-            if (i < half_Tu)
-                y = abs(spectrumBuffer[i + half_Tu]);
-            else
-                y = abs(spectrumBuffer[i - half_Tu]);
-
-            // Apply a cumulative moving average filter
-            int avg = 4; // Number of y values to average
-            qreal CMA = nullSymbolSeriesData[i].y();
-            y = (CMA * avg + y) / (avg + 1);
-
-            // Find maximum value to scale the plotter
-            if (y > y_max)
-                y_max = y;
-
-            // Calc x frequency
-            x = (i * dip_MHz) + (tunedFrequency_MHz - (sampleFrequency_MHz / 2));
-
-            nullSymbolSeriesData[i]= QPointF(x, y);
-        }
-
-        x_min = tunedFrequency_MHz - (sampleFrequency_MHz / 2);
-        x_max = tunedFrequency_MHz + (sampleFrequency_MHz / 2);
+    if (not spectrum.empty()) {
+        plotWorker.submitSpectrum(PlotTypeEn::Null, std::move(spectrum),
+                radioController->getCurrentFrequency() / 1e6, plotWidth(nullSymbolSeries));
+    }
 
-        emit setNullSymbolAxis(y_max, x_min, x_max);
+    if (plotWorker.take(PlotTypeEn::Null, nullSymbolPlot)) {
+        emit setNullSymbolAxis(nullSymbolPlot.y_max, nullSymbolPlot.x_min, nullSymbolPlot.x_max, nullSymbolPlot.y_min);
 
         if(nullSymbolSeries)
-            nullSymbolSeries->replace(nullSymbolSeriesData);
+            nullSymbolSeries->replace(nullSymbolPlot.points);
     }
 }
 
 void CGUIHelper::updateConstellation()
 {
-    std::vector<DSPCOMPLEX> constellationPointBuffer;
-
-    qreal x_min = 0;
-    qreal x_max = 0;
-
-    constellationPointBuffer = radioController->getConstellationPoint();
+    auto constellationPointBuffer = radioController->getConstellationPoint();
 
     const size_t decim = OfdmDecoder::constellationDecimation;
     const auto& params = radioController->getParams();
     const size_t num_iqpoints = (params.L-1) * params.K / decim;
     if (constellationPointBuffer.size() == num_iqpoints) {
-        constellationSeriesData.resize(num_iqpoints);
-
-        size_t i = 0;
-        for (int l = 1; l < params.L; l++) {
-            size_t ix = (l-1) * params.K/decim;
-            for (int k = 0; k < params.K; k += decim) {
-                qreal y = 180.0f / (float)M_PI *
-                    std::arg(constellationPointBuffer.at(ix++));
-
-                qreal x = k - params.K/2.0 + (l-1)/((qreal)params.L/decim);
-                constellationSeriesData[i++] = QPointF(x, y);
-            }
-        }
-
-        // TM I:
-        // k from -768 to 768, but not counting 0 gives a total of 1536 carriers
-        x_min = -params.K / 2;
-        x_max = params.K / 2;
-
-        emit setConstellationAxis(x_min, x_max);
-
-        if(constellationSeries)
-            constellationSeries->replace(constellationSeriesData);
+        plotWorker.submitConstellation(std::move(constellationPointBuffer), params);
     }
     /*
     else {
         qDebug() << "IQ" << constellationPointBuffer.size() << num_iqpoints;
     }
     */
+
+    if (plotWorker.take(PlotTypeEn::QPSK, constellationPlot)) {
+        emit setConstellationAxis(constellationPlot.x_min, constellationPlot.x_max);
+
+        if(constellationSeries)
+            constellationSeries->replace(constellationPlot.points);
+    }
 }
 
 void CGUIHelper::saveMotImages(QString folder)
@@ -50,6 +50,7 @@
 #include "mot_image_provider.h"
 #include "dab-constants.h"
 #include "radio_controller.h"
+#include "plot_worker.h"
 
 #ifndef __ANDROID__
     #include "mpris/mpris.h"
@@ -119,17 +120,20 @@ private:
     void translateGUI(QObject *obj);
     CRadioController *radioController;
 
+    // Builds the points of the series below outside of the GUI thread
+    CPlotWorker plotWorker;
+
     QXYSeries* spectrumSeries;
-    QVector<QPointF> spectrumSeriesData;
+    CPlotWorker::Plot spectrumPlot;
 
     QXYSeries* impulseResponseSeries;
-    QVector<QPointF> impulseResponseSeriesData;
+    CPlotWorker::Plot impulseResponsePlot;
 
     QXYSeries* nullSymbolSeries;
-    QVector<QPointF> nullSymbolSeriesData;
+    CPlotWorker::Plot nullSymbolPlot;
 
     QXYSeries* constellationSeries;
-    QVector<QPointF> constellationSeriesData;
+    CPlotWorker::Plot constellationPlot;
 
     const QVariantMap licenses();
     const QByteArray getFileContent(QString filepath);
@@ -168,9 +172,9 @@ private slots:
 
 signals:
     void foundChannelCount(int channelCount);
-    void setSpectrumAxis(qreal Ymax, qreal Xmin, qreal Xmax);
+    void setSpectrumAxis(qreal Ymax, qreal Xmin, qreal Xmax, qreal Ymin);
     void setImpulseResponseAxis(qreal Ymax, qreal Xmin, qreal Xmax);
-    void setNullSymbolAxis(qreal Ymax, qreal Xmin, qreal Xmax);
+    void setNullSymbolAxis(qreal Ymax, qreal Xmin, qreal Xmax, qreal Ymin);
     void setConstellationAxis(qreal Xmin, qreal Xmax);
     void motChanged(QString pictureName, QString categoryTitle, int categoryId, int slideId);
     void motReseted(void);
@@ -0,0 +1,229 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <cmath>
+#include "plot_worker.h"
+#include "ofdm-decoder.h"
+
+// Fill points with one point per value, or with the minimum and the
+// maximum of every pixel column when there are more than two values per
+// pixel, so that narrow peaks stay visible. The two points of a column
+// are kept in the order in which they appear in the values.
+static void decimateMinMax(const std::vector<float>& values,
+        qreal x_start, qreal x_step, int pixelWidth, QVector<QPointF>& points)
+{
+    const int n = values.size();
+
+    if (pixelWidth <= 0 || n <= 2 * pixelWidth) {
+        points.resize(n);
+        for (int i = 0; i < n; i++) {
+            points[i] = QPointF(x_start + i * x_step, values[i]);
+        }
+        return;
+    }
+
+    points.resize(2 * pixelWidth);
+    for (int column = 0; column < pixelWidth; column++) {
+        const int first = column * n / pixelWidth;
+        const int last = (column + 1) * n / pixelWidth;
+
+        int i_min = first;
+        int i_max = first;
+        for (int i = first + 1; i < last; i++) {
+            if (values[i] < values[i_min])
+                i_min = i;
+            if (values[i] > values[i_max])
+                i_max = i;
+        }
+
+        const int i_a = std::min(i_min, i_max);
+        const int i_b = std::max(i_min, i_max);
+        points[2 * column] = QPointF(x_start + i_a * x_step, values[i_a]);
+        points[2 * column + 1] = QPointF(x_start + i_b * x_step, values[i_b]);
+    }
+}
+
+CPlotWorker::CPlotWorker()
+{
+    thread = std::thread(&CPlotWorker::workerthread, this);
+}
+
+CPlotWorker::~CPlotWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    jobAvailable.notify_all();
+
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void CPlotWorker::submitSpectrum(PlotTypeEn type, std::vector<float>&& spectrum,
+        qreal tunedFrequency_MHz, int pixelWidth)
+{
+    Job job;
+    job.values = std::move(spectrum);
+    job.tunedFrequency_MHz = tunedFrequency_MHz;
+    job.pixelWidth = pixelWidth;
+    submit(type, std::move(job));
+}
+
+void CPlotWorker::submitImpulseResponse(std::vector<float>&& impulseResponse, int pixelWidth)
+{
+    Job job;
+    job.values = std::move(impulseResponse);
+    job.pixelWidth = pixelWidth;
+    submit(PlotTypeEn::ImpulseResponse, std::move(job));
+}
+
+void CPlotWorker::submitConstellation(std::vector<DSPCOMPLEX>&& points, const DABParams& params)
+{
+    Job job;
+    job.iq = std::move(points);
+    job.L = params.L;
+    job.K = params.K;
+    submit(PlotTypeEn::QPSK, std::move(job));
+}
+
+void CPlotWorker::submit(PlotTypeEn type, Job&& job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingJobs[type] = std::move(job);
+    }
+    jobAvailable.notify_one();
+}
+
+bool CPlotWorker::take(PlotTypeEn type, Plot& plot)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = results.find(type);
+    if (it == results.end() || !it->second.fresh) {
+        return false;
+    }
+
+    // The vector of the caller is reused for a later plot
+    std::swap(plot, it->second.plot);
+    it->second.fresh = false;
+    return true;
+}
+
+void CPlotWorker::workerthread()
+{
+    // The buffers the worker fills, they are swapped with the results
+    std::map<PlotTypeEn, Plot> backBuffers;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        if (pendingJobs.empty()) {
+            jobAvailable.wait(lock);
+            continue;
+        }
+
+        const PlotTypeEn type = pendingJobs.begin()->first;
+        Job job = std::move(pendingJobs.begin()->second);
+        pendingJobs.erase(pendingJobs.begin());
+        lock.unlock();
+
+        Plot& plot = backBuffers[type];
+        process(type, job, plot);
+
+        lock.lock();
+        Result& result = results[type];
+        std::swap(result.plot, plot);
+        result.fresh = true;
+    }
+}
+
+void CPlotWorker::process(PlotTypeEn type, Job& job, Plot& plot)
+{
+    switch (type) {
+        case PlotTypeEn::Spectrum:
+        case PlotTypeEn::Null:
+        {
+            const int T_u = job.values.size();
+            const qreal sampleFrequency_MHz = INPUT_RATE / 1e6;
+            plot.x_min = job.tunedFrequency_MHz - (sampleFrequency_MHz / 2);
+            plot.x_max = job.tunedFrequency_MHz + (sampleFrequency_MHz / 2);
+
+            decimateMinMax(job.values, plot.x_min, sampleFrequency_MHz / T_u,
+                    job.pixelWidth, plot.points);
+
+            // The y axis starts at a multiple of 10 dB below the weakest value
+            plot.y_min = job.values.empty() ? 0 : job.values[0];
+            plot.y_max = plot.y_min;
+            for (const auto& p : plot.points) {
+                plot.y_min = std::min(plot.y_min, p.y());
+                plot.y_max = std::max(plot.y_max, p.y());
+            }
+            plot.y_min = std::floor(plot.y_min / 10) * 10;
+            break;
+        }
+        case PlotTypeEn::ImpulseResponse:
+        {
+            for (auto& v : job.values) {
+                v = 10.0f * std::log10(v);
+            }
+
+            plot.x_min = 0;
+            plot.x_max = job.values.size();
+
+            decimateMinMax(job.values, 0, 1, job.pixelWidth, plot.points);
+
+            plot.y_min = 0;
+            plot.y_max = 0;
+            for (const auto& p : plot.points) {
+                plot.y_max = std::max(plot.y_max, p.y());
+            }
+            break;
+        }
+        case PlotTypeEn::QPSK:
+        {
+            const int decim = OfdmDecoder::constellationDecimation;
+            plot.points.resize(job.iq.size());
+
+            size_t i = 0;
+            for (int l = 1; l < job.L; l++) {
+                for (int k = 0; k < job.K; k += decim) {
+                    qreal y = 180.0f / (float)M_PI * std::arg(job.iq[i]);
+                    qreal x = k - job.K/2.0 + (l-1)/((qreal)job.L/decim);
+                    plot.points[i++] = QPointF(x, y);
+                }
+            }
+
+            // TM I:
+            // k from -768 to 768, but not counting 0 gives a total of 1536 carriers
+            plot.x_min = -job.K / 2;
+            plot.x_max = job.K / 2;
+            break;
+        }
+        case PlotTypeEn::Unknown:
+            break;
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ *    Copyright (C) 2026
+ *    agent (agent@local)
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef CPLOTWORKER_H
+#define CPLOTWORKER_H
+
+#include <QPointF>
+#include <QVector>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "dab-constants.h"
+#include "radio_controller.h"
+
+/* Converts the data of the expert view plots into the points of the
+ * QtCharts series, so that the GUI thread only has to replace() them.
+ *
+ * The GUI thread submits the latest data of a plot, together with the
+ * width of the plot area in pixels. The worker thread scales the data,
+ * and keeps only the minimum and the maximum for every pixel column
+ * when there are more values than pixels. Every plot is double
+ * buffered: take() swaps the vector of the GUI with the one the worker
+ * filled last, so that steady state updates do not allocate.
+ *
+ * A plot is displayed one update after its data was submitted. */
+class CPlotWorker
+{
+public:
+    struct Plot {
+        QVector<QPointF> points;
+        qreal x_min = 0;
+        qreal x_max = 0;
+        qreal y_min = 0;
+        qreal y_max = 0;
+    };
+
+    CPlotWorker();
+    ~CPlotWorker();
+    CPlotWorker(const CPlotWorker&) = delete;
+    CPlotWorker& operator=(const CPlotWorker&) = delete;
+
+    // Spectrum or Null: dB values with the DC carrier in the middle
+    void submitSpectrum(PlotTypeEn type, std::vector<float>&& spectrum,
+            qreal tunedFrequency_MHz, int pixelWidth);
+
+    // ImpulseResponse: linear power values
+    void submitImpulseResponse(std::vector<float>&& impulseResponse, int pixelWidth);
+
+    // QPSK: the decimated constellation points of all symbols of a frame
+    void submitConstellation(std::vector<DSPCOMPLEX>&& points, const DABParams& params);
+
+    // Get the latest plot of this type. Returns false if there was no
+    // new one since the last call, plot is then left unchanged.
+    bool take(PlotTypeEn type, Plot& plot);
+
+private:
+    struct Job {
+        std::vector<float> values;
+        std::vector<DSPCOMPLEX> iq;
+        qreal tunedFrequency_MHz = 0;
+        int pixelWidth = 0;
+        int L = 0;
+        int K = 0;
+    };
+
+    struct Result {
+        Plot plot;
+        bool fresh = false;
+    };
+
+    void submit(PlotTypeEn type, Job&& job);
+    void workerthread(void);
+    static void process(PlotTypeEn type, Job& job, Plot& plot);
+
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    bool running = true;
+
+    // Only the latest job of every plot is kept
+    std::map<PlotTypeEn, Job> pendingJobs;
+    std::map<PlotTypeEn, Result> results;
+
+    std::thread thread;
+};
+
+#endif // CPLOTWORKER_H
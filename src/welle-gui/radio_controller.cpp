@@ -32,6 +32,8 @@
 
 #include <QCoreApplication>
 #include <QDebug>
+#include <QDateTime>
+#include <QDir>
 #include <QSettings>
 #include <QStandardPaths>
 #include <QTimeZone>
@@ -84,6 +86,12 @@ CRadioController::CRadioController(QVariantMap& commandLineOptions, QObject *par
     // Init the technical data
     resetTechnicalData();
 
+    // Services of known channels start without waiting for the FIC
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/ensembles";
+    if (QDir().mkpath(cacheDir)) {
+        rro.ensembleCacheDirectory = cacheDir.toStdString();
+    }
+
     // Init timers
     connect(&labelTimer, &QTimer::timeout, this, &CRadioController::labelTimerTimeout);
     connect(&stationTimer, &QTimer::timeout, this, &CRadioController::stationTimerTimeout);
@@ -310,6 +318,9 @@ void CRadioController::setService(uint32_t service, bool force)
         emit audioModeChanged(audioMode);
 
         emit motReseted();
+
+        // The service is already known if the ensemble was cached
+        stationTimerTimeout();
     }
 }
 
@@ -431,6 +442,8 @@ void CRadioController::startScan(void)
         isChannelScan = true;
         emit isChannelScanChanged(isChannelScan);
         stationCount = 0;
+        scanFICSeen = false;
+        scanServiceTime.invalidate();
         currentTitle = tr("Scanning") + " ... " + Channel
                 + " (" + QString::number((1 * 100 / NUMBEROFCHANNELS)) + "%)";
         emit titleChanged();
@@ -464,6 +477,7 @@ void CRadioController::stopScan(void)
     isChannelScan = false;
     emit isChannelScanChanged(isChannelScan);
     emit scanStopped();
+    channelTimer.stop();
 
     stop();
 }
@@ -503,6 +517,14 @@ void CRadioController::enableTIIDecode(bool enable)
     }
 }
 
+void CRadioController::enableCSIWeighting(bool enable)
+{
+    rro.csiWeightedDemapper = enable;
+    if (radioReceiver) {
+        radioReceiver->setReceiverOptions(rro);
+    }
+}
+
 void CRadioController::selectFFTWindowPlacement(int fft_window_placement_ix)
 {
     if (fft_window_placement_ix == 0) {
@@ -552,19 +574,77 @@ void CRadioController::setGain(int Gain)
     }
 }
 
-void CRadioController::initRecorder(int size)
+// The recorder writes u8 samples, which CRAWFile recognises by the extension
+static QString recordFileName(bool withTime)
+{
+    QString filename = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation) + "/welle-io-record";
+    if (withTime)
+        filename += "_" + QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
+    return filename + ".u8.iq";
+}
+
+bool CRadioController::checkRecorderSupported()
 {
+    if (device && device->supportsRecording())
+        return true;
+
+    setErrorMessage(tr("Recording is not supported by this input device"));
+    return false;
+}
+
+bool CRadioController::initRecorder(int size)
+{
+    if (!checkRecorderSupported())
+        return false;
+
     device->initRecordBuffer(size);
+    return true;
 }
 
 void CRadioController::triggerRecorder(QString filename)
 {
-    // TODO just for testing
-    filename = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation) + "/welle-io-record.iq";
+    if (!checkRecorderSupported())
+        return;
+
+    if (filename.isEmpty())
+        filename = recordFileName(true);
     std::string filename_tmp = filename.toStdString();
     device->writeRecordBufferToFile(filename_tmp);
 }
 
+bool CRadioController::startStreamRecorder(int maxFileSizeMB, int maxFileDurationMin)
+{
+    if (!checkRecorderSupported())
+        return false;
+
+    // When the recording is split, the recorder puts the time of every
+    // file into its name
+    const bool split = maxFileSizeMB > 0 || maxFileDurationMin > 0;
+    QString filename = recordFileName(!split);
+    if (!device->startRecording(filename.toStdString(),
+            (uint64_t)maxFileSizeMB * 1024 * 1024, maxFileDurationMin * 60)) {
+        setErrorMessage(tr("Cannot open ") + filename);
+        return false;
+    }
+    return true;
+}
+
+void CRadioController::stopStreamRecorder()
+{
+    if (device)
+        device->stopRecording();
+}
+
+qint64 CRadioController::streamRecorderBytesWritten()
+{
+    return device ? device->getRecordedBytes() : 0;
+}
+
+qint64 CRadioController::streamRecorderDroppedBytes()
+{
+    return device ? device->getRecordingDroppedBytes() : 0;
+}
+
 DABParams& CRadioController::getParams()
 {
     static DABParams dummyParams(1);
@@ -587,26 +667,16 @@ std::vector<float> CRadioController::getImpulseResponse()
     return buf;
 }
 
-std::vector<DSPCOMPLEX> CRadioController::getSignalProbe()
+std::vector<float> CRadioController::getSpectrum(SpectrumEngine::Source source)
 {
-    int16_t T_u = getParams().T_u;
-
-    if (device) {
-        return device->getSpectrumSamples(T_u);
+    if (radioReceiver) {
+        return radioReceiver->getSpectrum(source);
     }
     else {
-        std::vector<DSPCOMPLEX> dummyBuf(static_cast<std::vector<DSPCOMPLEX>::size_type>(T_u));
-        return dummyBuf;
+        return {};
     }
 }
 
-std::vector<DSPCOMPLEX> CRadioController::getNullSymbol()
-{
-    std::lock_guard<std::mutex> lock(nullSymbolBufferMutex);
-    auto buf = std::move(nullSymbolBuffer);
-    return buf;
-}
-
 std::vector<DSPCOMPLEX> CRadioController::getConstellationPoint()
 {
     std::lock_guard<std::mutex> lock(constellationPointBufferMutex);
@@ -649,6 +719,7 @@ void CRadioController::initialise(void)
     emit deviceNameChanged();
 
     deviceId = device->getID();
+    isRecorderSupported = device->supportsRecording();
     emit deviceIdChanged();
 
     if(isAutoPlay) {
@@ -882,8 +953,22 @@ void CRadioController::channelTimerTimeout(void)
 {
     channelTimer.stop();
 
-    if(isChannelScan)
+    if (not isChannelScan)
+        return;
+
+    // Move on as soon as the channel cannot bring anything new: either
+    // no FIC could be decoded at all, or every service has its label
+    // and no new service appeared for a while.
+    const qint64 elapsed = scanChannelTime.elapsed();
+    const bool isTimeout = elapsed >= SCAN_CHANNEL_TIMEOUT_MS;
+    const bool isNoFIC = elapsed >= SCAN_FIC_TIMEOUT_MS and not scanFICSeen;
+    const bool isComplete = scanServiceTime.isValid() and pendingLabels.empty() and
+        scanServiceTime.elapsed() >= SCAN_SERVICE_SETTLE_MS;
+
+    if (isTimeout or isNoFIC or isComplete)
         nextChannel(false);
+    else
+        channelTimer.start(SCAN_POLL_INTERVAL_MS);
 }
 
 void CRadioController::displayDateTime(const dab_date_time_t& dateTime)
@@ -906,12 +991,17 @@ void CRadioController::displayDateTime(const dab_date_time_t& dateTime)
 
 void CRadioController::nextChannel(bool isWait)
 {
-    if (isWait) { // It might be a channel, wait 10 seconds
-        channelTimer.start(10000);
+    if (isWait) { // It might be a channel, wait until the ensemble is known
+        scanChannelTime.start();
+        channelTimer.start(SCAN_POLL_INTERVAL_MS);
     }
     else {
         auto Channel = QString::fromStdString(channels.getNextChannel());
 
+        channelTimer.stop();
+        scanFICSeen = false;
+        scanServiceTime.invalidate();
+
         if(!Channel.isEmpty()) {
             setChannel(Channel, true);
 
@@ -942,6 +1032,7 @@ void CRadioController::serviceId(quint32 sId)
 {
     if (isChannelScan == true) {
         stationCount++;
+        scanServiceTime.start();
         currentText = tr("Found channels") + ": " + QString::number(stationCount);
         emit textChanged();
     }
@@ -970,6 +1061,9 @@ void CRadioController::onDateTimeUpdate(const dab_date_time_t& dateTime)
 void CRadioController::onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib)
 {
     (void)fib;
+    if (crcCheckOk)
+        scanFICSeen = true;
+
     if (isFICCRC == crcCheckOk)
         return;
     isFICCRC = crcCheckOk;
@@ -990,8 +1084,8 @@ void CRadioController::onConstellationPoints(std::vector<DSPCOMPLEX>&& data)
 
 void CRadioController::onNewNullSymbol(std::vector<DSPCOMPLEX>&& data)
 {
-    std::lock_guard<std::mutex> lock(nullSymbolBufferMutex);
-    nullSymbolBuffer = std::move(data);
+    // The NULL symbol spectrum is computed by the receiver
+    (void)data;
 }
 
 void CRadioController::onTIIMeasurement(tii_measurement_t&& m)
@@ -39,6 +39,8 @@
 #include <QImage>
 #include <QVariantMap>
 #include <QFile>
+#include <QElapsedTimer>
+#include <atomic>
 #include <mutex>
 #include <list>
 
@@ -62,6 +64,7 @@ class CRadioController :
     Q_OBJECT
     Q_PROPERTY(QString deviceName MEMBER deviceName NOTIFY deviceNameChanged)
     Q_PROPERTY(CDeviceID deviceId  MEMBER deviceId NOTIFY deviceIdChanged)
+    Q_PROPERTY(bool isRecorderSupported MEMBER isRecorderSupported NOTIFY deviceIdChanged)
     Q_PROPERTY(QDateTime dateTime MEMBER currentDateTime NOTIFY dateTimeChanged)
     Q_PROPERTY(bool isPlaying MEMBER isPlaying NOTIFY isPlayingChanged)
     Q_PROPERTY(bool isChannelScan MEMBER isChannelScan NOTIFY isChannelScanChanged)
@@ -122,18 +125,22 @@ public:
     Q_INVOKABLE void setAGC(bool isAGC);
     Q_INVOKABLE void disableCoarseCorrector(bool disable);
     Q_INVOKABLE void enableTIIDecode(bool enable);
+    Q_INVOKABLE void enableCSIWeighting(bool enable);
     Q_INVOKABLE void selectFFTWindowPlacement(int fft_window_placement_ix);
     Q_INVOKABLE void setFreqSyncMethod(int fsm_ix);
     Q_INVOKABLE void setGain(int gain);
-    Q_INVOKABLE void initRecorder(int size);
+    Q_INVOKABLE bool initRecorder(int size);
     Q_INVOKABLE void triggerRecorder(QString filename);
+    Q_INVOKABLE bool startStreamRecorder(int maxFileSizeMB, int maxFileDurationMin);
+    Q_INVOKABLE void stopStreamRecorder(void);
+    Q_INVOKABLE qint64 streamRecorderBytesWritten(void);
+    Q_INVOKABLE qint64 streamRecorderDroppedBytes(void);
     DABParams& getParams(void);
     int getCurrentFrequency();
 
     // Buffer getter
     std::vector<float> getImpulseResponse(void);
-    std::vector<DSPCOMPLEX> getSignalProbe(void);
-    std::vector<DSPCOMPLEX> getNullSymbol(void);
+    std::vector<float> getSpectrum(SpectrumEngine::Source source);
     std::vector<DSPCOMPLEX> getConstellationPoint(void);
 
     //called from the backend
@@ -178,8 +185,6 @@ private:
     CAudio audio;
     std::mutex impulseResponseBufferMutex;
     std::vector<float> impulseResponseBuffer;
-    std::mutex nullSymbolBufferMutex;
-    std::vector<DSPCOMPLEX> nullSymbolBuffer;
     std::mutex constellationPointBufferMutex;
     std::vector<DSPCOMPLEX> constellationPointBuffer;
 
@@ -219,11 +224,22 @@ private:
     qreal currentVolume = 1.0;
     QString deviceName = "Unknown";
     CDeviceID deviceId = CDeviceID::UNKNOWN;
+    bool isRecorderSupported = false;
 
     QTimer labelTimer;
     QTimer stationTimer;
     QTimer channelTimer;
 
+    // Channel scan: time since the signal was found on the current
+    // channel, and since the last new service
+    QElapsedTimer scanChannelTime;
+    QElapsedTimer scanServiceTime;
+    std::atomic<bool> scanFICSeen = ATOMIC_VAR_INIT(false);
+    static constexpr int SCAN_POLL_INTERVAL_MS = 250;
+    static constexpr qint64 SCAN_CHANNEL_TIMEOUT_MS = 10000;
+    static constexpr qint64 SCAN_FIC_TIMEOUT_MS = 2000;
+    static constexpr qint64 SCAN_SERVICE_SETTLE_MS = 3000;
+
     bool isChannelScan = false;
     bool isAGC = false;
     bool isAutoPlay = false;
@@ -234,6 +250,8 @@ private:
     std::unique_ptr<QFile> rawFileAndroid;
 #endif
 
+    bool checkRecorderSupported(void);
+
 public slots:
     void setErrorMessage(QString Text);
     void setErrorMessage(const std::string& head, const std::string& text = "");
@@ -26,6 +26,9 @@
 #include <climits>
 #include "waterfallitem.h"
 
+// Height in pixels of the row showing one spectrum
+static const int ROW_HEIGHT = 6;
+
 WaterfallItem::WaterfallItem(QQuickItem *parent)
     : QQuickPaintedItem(parent) {
 
@@ -38,12 +41,16 @@ WaterfallItem::WaterfallItem(QQuickItem *parent)
     this->setVisible(true);
     this->setFlag(QQuickItem::ItemHasContents);
     _samplesUpdated = false;
-    _image = QImage((int)this->width(), (int)this->height(), QImage::Format_ARGB32);
+    _minValue = 0;
+    _topRow = 0;
+    _columnSampleNumber = 0;
+    _image = QImage((int)this->width(), rowCount(), QImage::Format_RGB32);
     _image.fill(QColor(255, 255, 255));
+    _rowMessages.resize(_image.height());
 
     // Generate displayable colors
     QImage img(500, 1, QImage::Format_ARGB32);
-    _colors.reserve(img.height());
+    _colors.reserve(img.width());
     QPainter painter;
     painter.begin(&img);
     QLinearGradient gradient;
@@ -66,23 +73,81 @@ WaterfallItem::WaterfallItem(QQuickItem *parent)
     update();
 }
 
+int WaterfallItem::rowCount() const {
+    return ((int)this->height() + ROW_HEIGHT - 1) / ROW_HEIGHT;
+}
+
 void WaterfallItem::sizeChanged() {
-    QImage img = QImage((int)this->width(), (int)this->height(), QImage::Format_ARGB32);
+    const int rows = rowCount();
+    QImage img = QImage((int)this->width(), rows, QImage::Format_RGB32);
     img.fill(QColor(255, 255, 255));
+    QVector<QString> messages(rows);
 
-    if (!_image.isNull()) {
+    if (!_image.isNull() && _image.height() > 0) {
+        // Unroll the ring buffer so that the newest row is on top again
+        const int oldRows = _image.height();
+        QImage ordered(_image.width(), oldRows, _image.format());
         QPainter painter;
+        painter.begin(&ordered);
+        painter.drawImage(0, 0, _image, 0, _topRow, _image.width(), oldRows - _topRow);
+        if (_topRow > 0) {
+            painter.drawImage(0, oldRows - _topRow, _image, 0, 0, _image.width(), _topRow);
+        }
+        painter.end();
+
         painter.begin(&img);
-        painter.drawImage(QRect(0, 0, width(), height()), _image, QRect(0, 0, _image.width(), _image.height()));
+        painter.drawImage(QRect(0, 0, img.width(), img.height()), ordered);
         painter.end();
+
+        for (int row = 0; row < oldRows; row++) {
+            if (!_rowMessages[row].isEmpty()) {
+                const int age = (row - _topRow + oldRows) % oldRows;
+                messages[age * rows / oldRows] = _rowMessages[row];
+            }
+        }
     }
 
     _image = img;
+    _topRow = 0;
+    _rowMessages = messages;
+    _columnSampleNumber = 0;
     update();
 }
 
 void WaterfallItem::paint(QPainter *painter) {
-    painter->drawImage(QRect(0, 0, width(), height()), _image, QRect(0, 0, _image.width(), _image.height()));
+    const int rows = _image.height();
+    if (rows == 0) {
+        return;
+    }
+
+    // The rows from _topRow to the end of the image, followed by the
+    // rows from the start of the image, each stretched to ROW_HEIGHT.
+    const int firstPart = rows - _topRow;
+    painter->drawImage(QRect(0, 0, width(), firstPart * ROW_HEIGHT),
+            _image, QRect(0, _topRow, _image.width(), firstPart));
+    if (_topRow > 0) {
+        painter->drawImage(QRect(0, firstPart * ROW_HEIGHT, width(), _topRow * ROW_HEIGHT),
+                _image, QRect(0, 0, _image.width(), _topRow));
+    }
+
+    // Draw the messages at the row that was the newest when they came in
+    for (int row = 0; row < rows; row++) {
+        if (_rowMessages[row].isEmpty()) {
+            continue;
+        }
+
+        const int y = ((row - _topRow + rows) % rows) * ROW_HEIGHT;
+
+        // Draw everything in black
+        painter->setPen(QColor("black"));
+
+        // Draw horizontal line
+        painter->drawLine(0, y + 14, width(), y + 14);
+
+        // Put text above the line
+        painter->setFont(QFont("Arial", 12));
+        painter->drawText(2, y + 12, _rowMessages[row]);
+    }
 }
 
 bool WaterfallItem::start() {
@@ -103,8 +168,9 @@ bool WaterfallItem::isStarted() const {
 }
 
 void WaterfallItem::clear() {
-    _image = QImage((int)this->width(), (int)this->height(), QImage::Format_ARGB32);
     _image.fill(QColor(255, 255, 255));
+    _topRow = 0;
+    _rowMessages.fill(QString());
 }
 
 void WaterfallItem::plotMessage(QString message)
@@ -128,13 +194,21 @@ QLineSeries *WaterfallItem::getDataSeries()
     return &dataSeries;
 }
 
-void WaterfallItem::samplesCollected() {
-    int _sampleNumber = dataSeries.count();
+void WaterfallItem::updateColumnSamples(int sampleNumber) {
+    const int width = _image.width();
+    _columnSampleNumber = sampleNumber;
+    _columnSamples.resize(width);
+    for (int x = 0; x < width; x++) {
+        _columnSamples[x] = x * sampleNumber / width;
+    }
+}
 
-    // Create new image
-    QImage img((int)this->width(), (int)this->height(), QImage::Format_ARGB32);
-    QPainter painter;
-    painter.begin(&img);
+void WaterfallItem::samplesCollected() {
+    const int _sampleNumber = dataSeries.count();
+    const int rows = _image.height();
+    if (_sampleNumber == 0 || rows == 0 || _image.width() == 0) {
+        return;
+    }
 
     // Find max value
     float maxValue = 0;
@@ -145,45 +219,35 @@ void WaterfallItem::samplesCollected() {
             maxValue = amplitude;
     }
 
-    // Draw 1st pixel row: new values
-    for (int x = 0; x < img.width(); x++) {
-        unsigned i1 = x * _sampleNumber / img.width();
-        float amplitude = (dataSeries.at(i1).y() - _minValue);
-
-        int value = (int)(amplitude / maxValue * 256); // Scale to max value
-        if (value < 0)
-            value = 0;
-        if (value >= _colors.length())
-            value = _colors.length() - 1;
-
-        painter.setPen(_colors[value]);
-        painter.drawRect(x, 0, 1, 5);
+    if (_columnSampleNumber != _sampleNumber) {
+        updateColumnSamples(_sampleNumber);
     }
 
-    // Draw old values
-    if (!_image.isNull()) {
-        painter.drawImage(QRect(0, 6, width(), height()), _image, QRect(0, 0, _image.width(), _image.height()));
-    }
+    // The new row replaces the oldest one
+    _topRow = (_topRow + rows - 1) % rows;
 
-    // Draw message into the plot
-    if(!messageToPlot.isEmpty()) {
-        // Draw everything in black
-        painter.setPen(QColor("black"));
+    // Scale to max value
+    const float scale = maxValue > 0 ? 256 / maxValue : 0;
+    const int lastColor = _colors.size() - 1;
+    const QRgb *colors = _colors.constData();
+    const int *columnSamples = _columnSamples.constData();
+    QRgb *line = reinterpret_cast<QRgb*>(_image.scanLine(_topRow));
 
-        // Draw horizontal line
-        painter.drawLine(0,14, img.width(), 14);
+    for (int x = 0; x < _image.width(); x++) {
+        float amplitude = (dataSeries.at(columnSamples[x]).y() - _minValue);
 
-        // Put text above the line
-        painter.setFont(QFont("Arial", 12));
-        painter.drawText(2,12, messageToPlot);
+        int value = (int)(amplitude * scale);
+        if (value < 0)
+            value = 0;
+        if (value > lastColor)
+            value = lastColor;
 
-        // Reset message
-        messageToPlot.clear();
+        line[x] = colors[value];
     }
 
-    painter.end();
+    _rowMessages[_topRow] = messageToPlot;
+    messageToPlot.clear();
 
     // Redraw the item
-    _image = img;
     update();
 }
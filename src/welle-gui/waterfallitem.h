@@ -31,13 +31,27 @@ class WaterfallItem : public QQuickPaintedItem
     Q_PROPERTY(bool isStarted READ isStarted NOTIFY isStartedChanged)
     Q_PROPERTY(float minValue READ minValue WRITE setMinValue NOTIFY minMinValueChanged)
 
+    // Every spectrum is one row of _image, which is used as a ring
+    // buffer: _topRow holds the newest spectrum, older ones follow below
+    // and wrap around at the end of the image. Adding a spectrum only
+    // writes one row, the scrolling is done when painting.
     QImage _image;
-    QList<QRgb> _colors;
+    int _topRow;
+    QVector<QString> _rowMessages;
+
+    QVector<QRgb> _colors;
+    // Index of the sample shown in each column of the image, for
+    // spectra of _columnSampleNumber samples
+    QVector<int> _columnSamples;
+    int _columnSampleNumber;
     bool _samplesUpdated;
     float _minValue;
     QLineSeries dataSeries;
     QString messageToPlot;
 
+    int rowCount() const;
+    void updateColumnSamples(int sampleNumber);
+
 public:
     explicit WaterfallItem(QQuickItem *parent = 0);
     void paint(QPainter *painter);
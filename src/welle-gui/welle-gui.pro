@@ -81,6 +81,7 @@ HEADERS += \
     audio_output.h \
     debug_output.h \
     gui_helper.h \
+    plot_worker.h \
     mot_image_provider.h \
     radio_controller.h \
     mpris/mpris.h \
@@ -94,6 +95,7 @@ SOURCES += \
     audio_output.cpp \
     debug_output.cpp \
     gui_helper.cpp \
+    plot_worker.cpp \
     mot_image_provider.cpp \
     radio_controller.cpp \
     mpris/mpris.cpp \